@@ -0,0 +1,228 @@
+#include "AABBTree.h"
+
+// Taken by reference, e.g. by push_back, so it needs a definition.
+const int32_t ResourceLib::AABBTree::Null;
+
+int32_t ResourceLib::AABBTree::Insert(const AABB& box, uint64_t userData) {
+	int32_t leaf = AllocateNode();
+	Node& node = nodes[leaf];
+	for (int i = 0; i < 3; i++) {
+		node.box.min[i] = box.min[i] - margin;
+		node.box.max[i] = box.max[i] + margin;
+	}
+	node.userData = userData;
+	node.height = 0;
+
+	InsertLeaf(leaf);
+	proxyCount++;
+	return leaf;
+}
+
+void ResourceLib::AABBTree::Remove(int32_t proxy) {
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	proxyCount--;
+}
+
+bool ResourceLib::AABBTree::Move(int32_t proxy, const AABB& box) {
+	if (nodes[proxy].box.Contains(box))
+		return false;
+
+	RemoveLeaf(proxy);
+	Node& node = nodes[proxy];
+	for (int i = 0; i < 3; i++) {
+		node.box.min[i] = box.min[i] - margin;
+		node.box.max[i] = box.max[i] + margin;
+	}
+	InsertLeaf(proxy);
+	return true;
+}
+
+void ResourceLib::AABBTree::Clear() {
+	nodes.clear();
+	root = Null;
+	freeList = Null;
+	proxyCount = 0;
+}
+
+int32_t ResourceLib::AABBTree::AllocateNode() {
+	if (freeList == Null) {
+		nodes.push_back(Node());
+		return (int32_t)nodes.size() - 1;
+	}
+
+	int32_t node = freeList;
+	freeList = nodes[node].parent;
+	nodes[node] = Node();
+	return node;
+}
+
+void ResourceLib::AABBTree::FreeNode(int32_t node) {
+	nodes[node].parent = freeList;
+	nodes[node].height = -1;
+	freeList = node;
+}
+
+void ResourceLib::AABBTree::InsertLeaf(int32_t leaf) {
+	if (root == Null) {
+		root = leaf;
+		nodes[leaf].parent = Null;
+		return;
+	}
+
+	///////////////////////
+	// FIND BEST SIBLING //
+	///////////////////////
+	// Walk down while pairing with a child is cheaper than pairing here,
+	// counting the area every ancestor grows by along the way.
+	AABB box = nodes[leaf].box;
+	int32_t index = root;
+	while (!nodes[index].IsLeaf()) {
+		const Node& node = nodes[index];
+		float area = node.box.HalfArea();
+		float combinedArea = AABB::Merge(node.box, box).HalfArea();
+
+		// Cost of a new parent for this node and the leaf.
+		float cost = 2.0f * combinedArea;
+		// Every ancestor below here grows by this much anyway.
+		float inheritance = 2.0f * (combinedArea - area);
+
+		float childCost[2];
+		int32_t children[2] = { node.child1, node.child2 };
+		for (int c = 0; c < 2; c++) {
+			const Node& child = nodes[children[c]];
+			AABB merged = AABB::Merge(child.box, box);
+			if (child.IsLeaf())
+				childCost[c] = merged.HalfArea() + inheritance;
+			else
+				childCost[c] = merged.HalfArea() - child.box.HalfArea() + inheritance;
+		}
+
+		if (cost < childCost[0] && cost < childCost[1])
+			break;
+
+		index = childCost[0] < childCost[1] ? node.child1 : node.child2;
+	}
+
+	////////////////////////
+	// SPLICE IN A PARENT //
+	////////////////////////
+	int32_t sibling = index;
+	int32_t oldParent = nodes[sibling].parent;
+	int32_t newParent = AllocateNode();
+	// AllocateNode() may have moved the array.
+	Node& parent = nodes[newParent];
+	parent.parent = oldParent;
+	parent.box = AABB::Merge(box, nodes[sibling].box);
+	parent.height = nodes[sibling].height + 1;
+	parent.child1 = sibling;
+	parent.child2 = leaf;
+
+	if (oldParent != Null) {
+		if (nodes[oldParent].child1 == sibling)
+			nodes[oldParent].child1 = newParent;
+		else
+			nodes[oldParent].child2 = newParent;
+	}
+	else {
+		root = newParent;
+	}
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+
+	Refit(nodes[leaf].parent);
+}
+
+void ResourceLib::AABBTree::RemoveLeaf(int32_t leaf) {
+	if (leaf == root) {
+		root = Null;
+		return;
+	}
+
+	// The parent goes away and the sibling takes its place.
+	int32_t parent = nodes[leaf].parent;
+	int32_t grandParent = nodes[parent].parent;
+	int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+	if (grandParent != Null) {
+		if (nodes[grandParent].child1 == parent)
+			nodes[grandParent].child1 = sibling;
+		else
+			nodes[grandParent].child2 = sibling;
+		nodes[sibling].parent = grandParent;
+		FreeNode(parent);
+
+		Refit(grandParent);
+	}
+	else {
+		root = sibling;
+		nodes[sibling].parent = Null;
+		FreeNode(parent);
+	}
+}
+
+void ResourceLib::AABBTree::Refit(int32_t index) {
+	while (index != Null) {
+		index = Balance(index);
+
+		Node& node = nodes[index];
+		const Node& child1 = nodes[node.child1];
+		const Node& child2 = nodes[node.child2];
+		node.height = 1 + (child1.height > child2.height ? child1.height : child2.height);
+		node.box = AABB::Merge(child1.box, child2.box);
+
+		index = node.parent;
+	}
+}
+
+int32_t ResourceLib::AABBTree::Balance(int32_t a) {
+	Node& A = nodes[a];
+	if (A.IsLeaf() || A.height < 2)
+		return a;
+
+	int32_t b = A.child1;
+	int32_t c = A.child2;
+	int32_t balance = nodes[c].height - nodes[b].height;
+
+	// Rotate the taller child up, a takes its shorter grandchild.
+	if (balance > 1 || balance < -1) {
+		int32_t up = balance > 1 ? c : b;
+		int32_t other = balance > 1 ? b : c;
+		Node& U = nodes[up];
+		int32_t f = U.child1;
+		int32_t g = U.child2;
+
+		U.child1 = a;
+		U.parent = A.parent;
+		A.parent = up;
+
+		if (U.parent != Null) {
+			if (nodes[U.parent].child1 == a)
+				nodes[U.parent].child1 = up;
+			else
+				nodes[U.parent].child2 = up;
+		}
+		else {
+			root = up;
+		}
+
+		// The taller grandchild stays with up, the other moves to a.
+		int32_t keep = nodes[f].height > nodes[g].height ? f : g;
+		int32_t move = keep == f ? g : f;
+		U.child2 = keep;
+		if (balance > 1)
+			A.child2 = move;
+		else
+			A.child1 = move;
+		nodes[move].parent = a;
+
+		A.box = AABB::Merge(nodes[other].box, nodes[move].box);
+		A.height = 1 + (nodes[other].height > nodes[move].height ? nodes[other].height : nodes[move].height);
+		U.box = AABB::Merge(A.box, nodes[keep].box);
+		U.height = 1 + (A.height > nodes[keep].height ? A.height : nodes[keep].height);
+
+		return up;
+	}
+
+	return a;
+}
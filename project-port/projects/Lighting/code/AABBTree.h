@@ -0,0 +1,332 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "MathLib.h"
+
+namespace ResourceLib {
+
+	/** Axis aligned bounding box. */
+	struct AABB {
+		float min[3] = { 0, 0, 0 };
+		float max[3] = { 0, 0, 0 };
+
+		/** The box of a local center and half extents moved by a model matrix. */
+		static AABB Transform(const float* center, const float* extents, const MathLib::Mat4& matrix) {
+			const float* m = matrix.Data();
+			AABB box;
+			for (int r = 0; r < 3; r++) {
+				const float* row = m + r * 4;
+				float c = row[0] * center[0] + row[1] * center[1] + row[2] * center[2] + row[3];
+				float e = std::fabs(row[0]) * extents[0] + std::fabs(row[1]) * extents[1] + std::fabs(row[2]) * extents[2];
+				box.min[r] = c - e;
+				box.max[r] = c + e;
+			}
+			return box;
+		}
+
+		static AABB Merge(const AABB& a, const AABB& b) {
+			AABB box;
+			for (int i = 0; i < 3; i++) {
+				box.min[i] = a.min[i] < b.min[i] ? a.min[i] : b.min[i];
+				box.max[i] = a.max[i] > b.max[i] ? a.max[i] : b.max[i];
+			}
+			return box;
+		}
+
+		/** Half the surface area, the insertion cost metric. */
+		float HalfArea() const {
+			float x = max[0] - min[0], y = max[1] - min[1], z = max[2] - min[2];
+			return x * y + y * z + z * x;
+		}
+
+		bool Overlaps(const AABB& other) const {
+			for (int i = 0; i < 3; i++) {
+				if (max[i] < other.min[i] || min[i] > other.max[i])
+					return false;
+			}
+			return true;
+		}
+
+		bool Contains(const AABB& other) const {
+			for (int i = 0; i < 3; i++) {
+				if (other.min[i] < min[i] || other.max[i] > max[i])
+					return false;
+			}
+			return true;
+		}
+	};
+
+	/**
+	 * Dynamic bounding volume hierarchy over AABBs.
+	 *
+	 * Leaves hold a box enlarged by a margin, so objects moving a little
+	 * stay inside their leaf and Move() is free. When a box leaves its
+	 * fat box the leaf is removed and reinserted next to the sibling that
+	 * grows the tree's surface area the least, refitting and rotating the
+	 * ancestors on the way up to keep the tree balanced. Queries descend
+	 * only into overlapping subtrees, O(log n) plus the results.
+	 *
+	 * Nodes live in one array and are recycled through a free list, so
+	 * proxy ids stay valid until removed.
+	 */
+	class AABBTree {
+	public:
+		/** Not a node, returned for no proxy. */
+		static const int32_t Null = -1;
+
+		/** How far leaf boxes are enlarged on each side. */
+		float margin = 0.1f;
+
+		/** Adds a box with some user data, returns its proxy id. */
+		int32_t Insert(const AABB& box, uint64_t userData);
+
+		/** Removes a proxy from Insert(). */
+		void Remove(int32_t proxy);
+
+		/**
+		 * Updates the box of a proxy.
+		 *
+		 * @returns true if it left its fat box and was reinserted.
+		 */
+		bool Move(int32_t proxy, const AABB& box);
+
+		uint64_t GetUserData(int32_t proxy) const {
+			return nodes[proxy].userData;
+		}
+
+		/** The enlarged box stored for a proxy. */
+		const AABB& GetFatAABB(int32_t proxy) const {
+			return nodes[proxy].box;
+		}
+
+		/** Number of proxies in the tree. */
+		size_t Size() const {
+			return proxyCount;
+		}
+
+		/** Height of the tree, 0 for a single leaf. */
+		int32_t GetHeight() const {
+			return root == Null ? 0 : nodes[root].height;
+		}
+
+		/** Removes every proxy. */
+		void Clear();
+
+		/** Calls callback(userData) for every proxy overlapping a box. */
+		template<class Callback>
+		void QueryAABB(const AABB& box, Callback callback) const {
+			Descend([&box](const AABB& node) { return node.Overlaps(box); }, callback);
+		}
+
+		/** Calls callback(userData) for every proxy whose box touches a sphere. */
+		template<class Callback>
+		void QuerySphere(const float* center, float radius, Callback callback) const {
+			float radiusSq = radius * radius;
+			Descend([center, radiusSq](const AABB& node) {
+				float distSq = 0;
+				for (int i = 0; i < 3; i++) {
+					float d = center[i] < node.min[i] ? node.min[i] - center[i] : (center[i] > node.max[i] ? center[i] - node.max[i] : 0.0f);
+					distSq += d * d;
+				}
+				return distSq <= radiusSq;
+			}, callback);
+		}
+
+		/**
+		 * Walks the proxies whose box a ray segment hits, nearest subtree first.
+		 *
+		 * callback(userData, t) gets the entry distance along direction and
+		 * returns the new maximum distance: maxDistance to keep going, the
+		 * hit distance to only look for closer hits, 0 to stop.
+		 */
+		template<class Callback>
+		void QueryRay(const float* origin, const float* direction, float maxDistance, Callback callback) const;
+
+		/**
+		 * Calls callback(userData) for every proxy inside or crossing six
+		 * planes, see MathLib::Mat4::FrustumPlanes(). Subtrees fully inside
+		 * are reported without testing their leaves.
+		 */
+		template<class Callback>
+		void QueryFrustum(const float* planes, Callback callback) const;
+
+	private:
+		struct Node {
+			AABB box;
+			uint64_t userData = 0;
+			/** Parent, or the next free node while on the free list. */
+			int32_t parent = Null;
+			int32_t child1 = Null;
+			int32_t child2 = Null;
+			/** Leaves are 0, free nodes -1. */
+			int32_t height = -1;
+
+			bool IsLeaf() const {
+				return child1 == Null;
+			}
+		};
+
+		int32_t AllocateNode();
+		void FreeNode(int32_t node);
+
+		void InsertLeaf(int32_t leaf);
+		void RemoveLeaf(int32_t leaf);
+
+		/** Recomputes boxes and heights from a node to the root, rotating as needed. */
+		void Refit(int32_t node);
+
+		/** Rotates a node's children if they differ in height by more than one, returns the subtree root. */
+		int32_t Balance(int32_t node);
+
+		/** Depth first walk visiting subtrees that pass a test. */
+		template<class Test, class Callback>
+		void Descend(Test test, Callback callback) const {
+			if (root == Null)
+				return;
+
+			stack.clear();
+			stack.push_back(root);
+			while (!stack.empty()) {
+				const Node& node = nodes[stack.back()];
+				stack.pop_back();
+
+				if (!test(node.box))
+					continue;
+
+				if (node.IsLeaf()) {
+					callback(node.userData);
+				}
+				else {
+					stack.push_back(node.child1);
+					stack.push_back(node.child2);
+				}
+			}
+		}
+
+		/** Entry distance of a ray into a box, or a negative value if it misses within maxDistance. */
+		static float RayEntry(const AABB& box, const float* origin, const float* inverse, float maxDistance) {
+			float tMin = 0, tMax = maxDistance;
+			for (int i = 0; i < 3; i++) {
+				float t1 = (box.min[i] - origin[i]) * inverse[i];
+				float t2 = (box.max[i] - origin[i]) * inverse[i];
+				if (t1 > t2) {
+					float t = t1;
+					t1 = t2;
+					t2 = t;
+				}
+				// Written so a NaN from 0 * inf keeps the old bound.
+				tMin = t1 > tMin ? t1 : tMin;
+				tMax = t2 < tMax ? t2 : tMax;
+				if (tMin > tMax)
+					return -1;
+			}
+			return tMin;
+		}
+
+		std::vector<Node> nodes;
+		int32_t root = Null;
+		int32_t freeList = Null;
+		size_t proxyCount = 0;
+
+		/** Traversal stack, kept to avoid allocating per query. */
+		mutable std::vector<int32_t> stack;
+	};
+
+	template<class Callback>
+	void AABBTree::QueryRay(const float* origin, const float* direction, float maxDistance, Callback callback) const {
+		if (root == Null)
+			return;
+
+		float inverse[3];
+		for (int i = 0; i < 3; i++)
+			inverse[i] = 1.0f / direction[i];
+
+		stack.clear();
+		stack.push_back(root);
+		while (!stack.empty()) {
+			const Node& node = nodes[stack.back()];
+			stack.pop_back();
+
+			float t = RayEntry(node.box, origin, inverse, maxDistance);
+			if (t < 0)
+				continue;
+
+			if (node.IsLeaf()) {
+				maxDistance = callback(node.userData, t);
+				if (maxDistance <= 0)
+					return;
+				continue;
+			}
+
+			// Push the farther child first so the nearer one is popped next.
+			float t1 = RayEntry(nodes[node.child1].box, origin, inverse, maxDistance);
+			float t2 = RayEntry(nodes[node.child2].box, origin, inverse, maxDistance);
+			int32_t near = node.child1, far = node.child2;
+			if (t2 >= 0 && (t1 < 0 || t2 < t1)) {
+				near = node.child2;
+				far = node.child1;
+				float t = t1;
+				t1 = t2;
+				t2 = t;
+			}
+			if (t2 >= 0)
+				stack.push_back(far);
+			if (t1 >= 0)
+				stack.push_back(near);
+		}
+	}
+
+	template<class Callback>
+	void AABBTree::QueryFrustum(const float* planes, Callback callback) const {
+		if (root == Null)
+			return;
+
+		// Nodes are pushed with the sign bit set once known to be inside.
+		stack.clear();
+		stack.push_back(root);
+		while (!stack.empty()) {
+			int32_t entry = stack.back();
+			stack.pop_back();
+
+			bool inside = entry < 0;
+			const Node& node = nodes[inside ? ~entry : entry];
+
+			if (!inside) {
+				float center[3], extents[3];
+				for (int i = 0; i < 3; i++) {
+					center[i] = (node.box.min[i] + node.box.max[i]) * 0.5f;
+					extents[i] = (node.box.max[i] - node.box.min[i]) * 0.5f;
+				}
+
+				bool outside = false;
+				inside = true;
+				for (int p = 0; p < 6 && !outside; p++) {
+					const float* plane = planes + p * 4;
+					float d = center[0] * plane[0] + center[1] * plane[1] + center[2] * plane[2] + plane[3];
+					float r = extents[0] * std::fabs(plane[0]) + extents[1] * std::fabs(plane[1]) + extents[2] * std::fabs(plane[2]);
+					if (d < -r)
+						outside = true;
+					else if (d < r)
+						inside = false;
+				}
+				if (outside)
+					continue;
+			}
+
+			if (node.IsLeaf()) {
+				callback(node.userData);
+			}
+			else if (inside) {
+				stack.push_back(~node.child1);
+				stack.push_back(~node.child2);
+			}
+			else {
+				stack.push_back(node.child1);
+				stack.push_back(node.child2);
+			}
+		}
+	}
+}
@@ -0,0 +1,1169 @@
+#include "Benchmark.h"
+#include "AABBTree.h"
+#include "OcclusionCuller.h"
+#include "GraphicsNode.h"
+#include "ObjParser.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "MeshResource.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "HalfArray.h"
+#include "half.h"
+#include "VertexFormat.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Benchmark {
+
+	/** Milliseconds since a start time. */
+	static double Since(std::chrono::high_resolution_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	int AABBTreeQueries(size_t count) {
+		const int queries = 1000;
+		// Objects 1 to 5 units wide at the same density for every count.
+		const float world = 40.0f * std::cbrt((float)count);
+
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<float> position(0.0f, world);
+		std::uniform_real_distribution<float> size(0.5f, 2.5f);
+		std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+
+		std::vector<ResourceLib::AABB> boxes(count);
+		for (size_t i = 0; i < count; i++) {
+			for (int k = 0; k < 3; k++) {
+				float c = position(rng), e = size(rng);
+				boxes[i].min[k] = c - e;
+				boxes[i].max[k] = c + e;
+			}
+		}
+
+		printf("AABBTree, %zu objects, %d queries per kind\n", count, queries);
+
+		/////////////////////
+		// BUILD AND MOVE  //
+		/////////////////////
+		ResourceLib::AABBTree tree;
+		std::vector<int32_t> proxies(count);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < count; i++)
+			proxies[i] = tree.Insert(boxes[i], i);
+		printf("  insert     %10.2f ms, height %d\n", Since(start), tree.GetHeight());
+
+		// A tenth of the objects move a little, like a frame of animation.
+		size_t reinserted = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < count; i += 10) {
+			float d[3] = { step(rng), step(rng), step(rng) };
+			for (int k = 0; k < 3; k++) {
+				boxes[i].min[k] += d[k];
+				boxes[i].max[k] += d[k];
+			}
+			reinserted += tree.Move(proxies[i], boxes[i]);
+		}
+		printf("  move       %10.2f ms, %zu of %zu reinserted, height %d\n", Since(start), reinserted, (count + 9) / 10, tree.GetHeight());
+
+		// Leaves store fat boxes, the scan has to match them exactly.
+		for (size_t i = 0; i < count; i++)
+			boxes[i] = tree.GetFatAABB(proxies[i]);
+
+		////////////////////
+		// QUERY VS SCAN  //
+		////////////////////
+		int failures = 0;
+		std::vector<uint8_t> hit(count);
+		size_t treeHits = 0, scanHits = 0;
+		double treeTime = 0, scanTime = 0;
+
+		// AABB queries.
+		for (int q = 0; q < queries; q++) {
+			ResourceLib::AABB query;
+			for (int k = 0; k < 3; k++) {
+				query.min[k] = position(rng);
+				query.max[k] = query.min[k] + 20.0f;
+			}
+
+			std::memset(hit.data(), 0, count);
+			start = std::chrono::high_resolution_clock::now();
+			tree.QueryAABB(query, [&](uint64_t i) { hit[i] = 1; treeHits++; });
+			treeTime += Since(start);
+
+			start = std::chrono::high_resolution_clock::now();
+			for (size_t i = 0; i < count; i++) {
+				if (boxes[i].Overlaps(query)) {
+					scanHits++;
+					failures += hit[i] == 0;
+				}
+			}
+			scanTime += Since(start);
+		}
+		failures += treeHits != scanHits;
+		printf("  aabb       %10.2f ms tree, %10.2f ms scan, %zu hits\n", treeTime, scanTime, treeHits);
+
+		// Sphere queries.
+		treeHits = scanHits = 0;
+		treeTime = scanTime = 0;
+		for (int q = 0; q < queries; q++) {
+			float center[3] = { position(rng), position(rng), position(rng) };
+			float radius = 10.0f;
+
+			std::memset(hit.data(), 0, count);
+			start = std::chrono::high_resolution_clock::now();
+			tree.QuerySphere(center, radius, [&](uint64_t i) { hit[i] = 1; treeHits++; });
+			treeTime += Since(start);
+
+			start = std::chrono::high_resolution_clock::now();
+			for (size_t i = 0; i < count; i++) {
+				float distSq = 0;
+				for (int k = 0; k < 3; k++) {
+					float c = center[k];
+					float d = c < boxes[i].min[k] ? boxes[i].min[k] - c : (c > boxes[i].max[k] ? c - boxes[i].max[k] : 0.0f);
+					distSq += d * d;
+				}
+				if (distSq <= radius * radius) {
+					scanHits++;
+					failures += hit[i] == 0;
+				}
+			}
+			scanTime += Since(start);
+		}
+		failures += treeHits != scanHits;
+		printf("  sphere     %10.2f ms tree, %10.2f ms scan, %zu hits\n", treeTime, scanTime, treeHits);
+
+		// Nearest hit ray queries, as used for picking.
+		size_t rayHits = 0;
+		treeTime = scanTime = 0;
+		for (int q = 0; q < queries; q++) {
+			float origin[3] = { position(rng), position(rng), -1.0f };
+			float direction[3] = { step(rng) * 0.2f, step(rng) * 0.2f, 1.0f };
+
+			float nearest = world * 2.0f;
+			start = std::chrono::high_resolution_clock::now();
+			tree.QueryRay(origin, direction, nearest, [&](uint64_t, float t) {
+				if (t < nearest)
+					nearest = t;
+				return nearest;
+			});
+			treeTime += Since(start);
+
+			float scanNearest = world * 2.0f;
+			start = std::chrono::high_resolution_clock::now();
+			for (size_t i = 0; i < count; i++) {
+				float tMin = 0, tMax = scanNearest;
+				for (int k = 0; k < 3; k++) {
+					float inverse = 1.0f / direction[k];
+					float t1 = (boxes[i].min[k] - origin[k]) * inverse;
+					float t2 = (boxes[i].max[k] - origin[k]) * inverse;
+					if (t1 > t2) {
+						float t = t1;
+						t1 = t2;
+						t2 = t;
+					}
+					tMin = t1 > tMin ? t1 : tMin;
+					tMax = t2 < tMax ? t2 : tMax;
+				}
+				if (tMin <= tMax && tMin < scanNearest)
+					scanNearest = tMin;
+			}
+			scanTime += Since(start);
+
+			rayHits += nearest < world * 2.0f;
+			failures += nearest != scanNearest;
+		}
+		printf("  ray        %10.2f ms tree, %10.2f ms scan, %zu hits\n", treeTime, scanTime, rayHits);
+
+		// Frustum queries from random cameras looking into the volume.
+		treeHits = scanHits = 0;
+		treeTime = scanTime = 0;
+		MathLib::Mat4 projection = MathLib::Mat4::Perspective(0.1f, 200.0f, 1.5f, 16.0f / 9.0f);
+		for (int q = 0; q < queries / 10; q++) {
+			MathLib::Vec4 eye(position(rng), position(rng), position(rng));
+			MathLib::Vec4 target(position(rng), position(rng), position(rng));
+			MathLib::Vec4 planes[6];
+			MathLib::Mat4::FrustumPlanes(projection * MathLib::Mat4::LookAt(eye, target, MathLib::Vec4(0, 1, 0)), planes);
+			const float* p = planes[0].Data();
+
+			std::memset(hit.data(), 0, count);
+			start = std::chrono::high_resolution_clock::now();
+			tree.QueryFrustum(p, [&](uint64_t i) { hit[i] = 1; treeHits++; });
+			treeTime += Since(start);
+
+			start = std::chrono::high_resolution_clock::now();
+			for (size_t i = 0; i < count; i++) {
+				bool outside = false;
+				for (int k = 0; k < 6 && !outside; k++) {
+					const float* plane = p + k * 4;
+					float c[3], e[3];
+					for (int a = 0; a < 3; a++) {
+						c[a] = (boxes[i].min[a] + boxes[i].max[a]) * 0.5f;
+						e[a] = (boxes[i].max[a] - boxes[i].min[a]) * 0.5f;
+					}
+					float d = c[0] * plane[0] + c[1] * plane[1] + c[2] * plane[2] + plane[3];
+					float r = e[0] * std::fabs(plane[0]) + e[1] * std::fabs(plane[1]) + e[2] * std::fabs(plane[2]);
+					outside = d < -r;
+				}
+				if (!outside) {
+					scanHits++;
+					failures += hit[i] == 0;
+				}
+			}
+			scanTime += Since(start);
+		}
+		failures += treeHits != scanHits;
+		printf("  frustum    %10.2f ms tree, %10.2f ms scan, %zu hits (%d queries)\n", treeTime, scanTime, treeHits, queries / 10);
+
+		printf(failures == 0 ? "  results match the scan\n" : "  %d MISMATCHES against the scan\n", failures);
+		return failures == 0 ? 0 : 1;
+	}
+
+	int OcclusionQueries(size_t count) {
+		const int frames = 20;
+		const float world = 4.0f * std::sqrt((float)count);
+
+		std::mt19937 rng(2);
+		std::uniform_real_distribution<float> position(0.0f, world);
+		std::uniform_real_distribution<float> size(0.5f, 3.0f);
+
+		// Buildings standing on a plane, y up.
+		std::vector<ResourceLib::AABB> boxes(count);
+		for (size_t i = 0; i < count; i++) {
+			float x = position(rng), z = position(rng), w = size(rng), d = size(rng);
+			boxes[i].min[0] = x - w;
+			boxes[i].max[0] = x + w;
+			boxes[i].min[1] = 0;
+			boxes[i].max[1] = size(rng) * 4.0f;
+			boxes[i].min[2] = z - d;
+			boxes[i].max[2] = z + d;
+		}
+
+		// Unit cube occluder scaled onto each box.
+		const float corners[8 * 3] = {
+			0, 0, 0,  1, 0, 0,  0, 1, 0,  1, 1, 0,
+			0, 0, 1,  1, 0, 1,  0, 1, 1,  1, 1, 1
+		};
+		const uint32_t cube[36] = {
+			0, 2, 1,  1, 2, 3,  4, 5, 6,  5, 7, 6,
+			0, 1, 4,  1, 5, 4,  2, 6, 3,  3, 6, 7,
+			0, 4, 2,  2, 4, 6,  1, 3, 5,  3, 7, 5
+		};
+		std::vector<MathLib::Mat4> worlds(count);
+		for (size_t i = 0; i < count; i++) {
+			const ResourceLib::AABB& b = boxes[i];
+			worlds[i] = MathLib::Mat4::Translate(b.min[0], b.min[1], b.min[2]) *
+				MathLib::Mat4::Scale(b.max[0] - b.min[0], b.max[1] - b.min[1], b.max[2] - b.min[2]);
+		}
+
+		MathLib::Mat4 projection = MathLib::Mat4::Perspective(0.1f, world * 2.0f, 1.5f, 2.0f);
+
+		GG::OcclusionCuller fast;
+		GG::OcclusionCuller slow;
+		slow.reference = true;
+
+		printf("OcclusionCuller, %zu boxes, %dx%d buffer, %d threads, %d views\n", count, fast.GetWidth(), fast.GetHeight(), fast.threadCount, frames);
+
+		int failures = 0;
+		double fastRaster = 0, fastTest = 0, slowRaster = 0, slowTest = 0;
+		size_t fastHidden = 0, slowHidden = 0;
+
+		for (int f = 0; f < frames; f++) {
+			// Street level cameras looking across the city.
+			MathLib::Vec4 eye(position(rng), 1.7f, position(rng));
+			MathLib::Vec4 target(position(rng), 1.7f, position(rng));
+			MathLib::Mat4 viewProjection = projection * MathLib::Mat4::LookAt(eye, target, MathLib::Vec4(0, 1, 0));
+
+			GG::OcclusionCuller* cullers[2] = { &fast, &slow };
+			double* raster[2] = { &fastRaster, &slowRaster };
+			double* test[2] = { &fastTest, &slowTest };
+			size_t* hidden[2] = { &fastHidden, &slowHidden };
+			std::vector<uint8_t> visible[2];
+
+			for (int c = 0; c < 2; c++) {
+				GG::OcclusionCuller& culler = *cullers[c];
+
+				auto start = std::chrono::high_resolution_clock::now();
+				culler.Begin(viewProjection);
+				for (size_t i = 0; i < count; i++)
+					culler.AddOccluder(corners, 3, cube, 36, worlds[i]);
+				culler.Rasterize();
+				*raster[c] += Since(start);
+
+				start = std::chrono::high_resolution_clock::now();
+				visible[c].resize(count);
+				for (size_t i = 0; i < count; i++) {
+					visible[c][i] = culler.IsVisible(boxes[i]);
+					*hidden[c] += !visible[c][i];
+				}
+				*test[c] += Since(start);
+			}
+
+			if (std::memcmp(fast.GetDepth().data(), slow.GetDepth().data(), fast.GetDepth().size() * sizeof(float)) != 0)
+				failures++;
+			for (size_t i = 0; i < count; i++)
+				failures += visible[1][i] && !visible[0][i];
+		}
+
+		printf("  rasterize  %10.2f ms fast, %10.2f ms reference\n", fastRaster, slowRaster);
+		printf("  test       %10.2f ms fast, %10.2f ms reference\n", fastTest, slowTest);
+		printf("  hidden     %10zu fast, %10zu reference of %zu\n", fastHidden, slowHidden, count * frames);
+		printf(failures == 0 ? "  depth matches the reference, no box wrongly hidden\n" : "  %d MISMATCHES against the reference\n", failures);
+		return failures == 0 ? 0 : 1;
+	}
+
+	/**
+	 * The getline, strtok and std::map loader MeshResource::Load() used
+	 * before ObjParser, kept as the reference. Handles triangles and quads
+	 * with full v/vt/vn corners only.
+	 */
+	static bool LegacyLoad(const std::string& filename, std::vector<float>& data, std::vector<unsigned int>& indices) {
+		std::ifstream mesh(filename);
+		if (!mesh)
+			return false;
+
+		std::vector<float> pos, uv, norm;
+		std::map<std::string, int> vertIndexList;
+		int maxIndex = 0;
+		data.clear();
+		indices.clear();
+
+		for (std::string line; std::getline(mesh, line); ) {
+			std::vector<std::string> tokens;
+			char* str = const_cast<char*>(line.c_str());
+			char* tok = strtok(str, " ");
+			while (tok != NULL) {
+				tokens.push_back(tok);
+				tok = strtok(NULL, " ");
+			}
+
+			if (tokens.size() == 0)
+				continue;
+
+			if (tokens[0] == "v") {
+				for (int i = 1; i < 4; i++)
+					pos.push_back(std::stof(tokens[i]));
+			}
+			else if (tokens[0] == "vt") {
+				for (int i = 1; i < 3; i++)
+					uv.push_back(std::stof(tokens[i]));
+			}
+			else if (tokens[0] == "vn") {
+				for (int i = 1; i < 4; i++)
+					norm.push_back(std::stof(tokens[i]));
+			}
+			else if (tokens[0] == "f") {
+				int face[4];
+				for (size_t i = 1; i < tokens.size() && i < 5; i++) {
+					char* cver = const_cast<char*>(tokens[i].c_str());
+					std::map<std::string, int>::iterator existing;
+					if ((existing = vertIndexList.find(cver)) != vertIndexList.end()) {
+						face[i - 1] = existing->second;
+						continue;
+					}
+					vertIndexList[cver] = maxIndex;
+
+					char* svi = strtok(cver, "/");
+					int ix = (std::stoi(svi) - 1) * 3;
+					data.push_back(pos[ix]);
+					data.push_back(pos[ix + 1]);
+					data.push_back(pos[ix + 2]);
+
+					svi = strtok(NULL, "/");
+					ix = (std::stoi(svi) - 1) * 2;
+					data.push_back(uv[ix]);
+					data.push_back(uv[ix + 1]);
+
+					svi = strtok(NULL, "/");
+					ix = (std::stoi(svi) - 1) * 3;
+					data.push_back(norm[ix]);
+					data.push_back(norm[ix + 1]);
+					data.push_back(norm[ix + 2]);
+
+					face[i - 1] = maxIndex++;
+				}
+
+				if (tokens.size() == 4) {
+					indices.push_back(face[0]);
+					indices.push_back(face[1]);
+					indices.push_back(face[2]);
+				}
+				else if (tokens.size() == 5) {
+					indices.push_back(face[0]);
+					indices.push_back(face[1]);
+					indices.push_back(face[3]);
+					indices.push_back(face[1]);
+					indices.push_back(face[2]);
+					indices.push_back(face[3]);
+				}
+			}
+		}
+		return true;
+	}
+
+	/** Writes a wavy grid of side * side quads with unique uvs and normals. */
+	static bool WriteGrid(const std::string& filename, size_t side) {
+		FILE* file = fopen(filename.c_str(), "wb");
+		if (file == nullptr)
+			return false;
+
+		size_t row = side + 1;
+		for (size_t y = 0; y < row; y++) {
+			for (size_t x = 0; x < row; x++) {
+				float fx = (float)x / side, fy = (float)y / side;
+				fprintf(file, "v %f %f %f\n", fx * 100.0f - 50.0f, std::sin(fx * 20.0f) * std::cos(fy * 20.0f), fy * 100.0f - 50.0f);
+			}
+		}
+		for (size_t y = 0; y < row; y++) {
+			for (size_t x = 0; x < row; x++)
+				fprintf(file, "vt %f %f\n", (float)x / side, (float)y / side);
+		}
+		for (size_t y = 0; y < row; y++) {
+			for (size_t x = 0; x < row; x++) {
+				float fx = (float)x / side, fy = (float)y / side;
+				float nx = -std::cos(fx * 20.0f) * 0.2f, nz = std::sin(fy * 20.0f) * 0.2f;
+				float length = std::sqrt(nx * nx + 1.0f + nz * nz);
+				fprintf(file, "vn %f %f %f\n", nx / length, 1.0f / length, nz / length);
+			}
+		}
+		for (size_t y = 0; y < side; y++) {
+			for (size_t x = 0; x < side; x++) {
+				size_t a = y * row + x + 1, b = a + 1, c = a + row + 1, d = a + row;
+				fprintf(file, "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, a, b, b, b, c, c, c, d, d, d);
+			}
+		}
+		return fclose(file) == 0;
+	}
+
+	/** True if two floats are at most one unit in the last place apart. */
+	static bool WithinUlp(float a, float b) {
+		if (a == b)
+			return true;
+		int32_t ia, ib;
+		memcpy(&ia, &a, sizeof(ia));
+		memcpy(&ib, &b, sizeof(ib));
+		if ((ia < 0) != (ib < 0))
+			return false;
+		return ia - ib <= 1 && ib - ia <= 1;
+	}
+
+	/** A mesh's attributes and index size as a string, to compare layouts. */
+	static std::string Layout(const ResourceLib::MeshResource& mesh) {
+		std::string layout = std::to_string(mesh.indexSize);
+		for (size_t i = 0; i < mesh.attributes.size(); i++) {
+			const ResourceLib::Attribute& a = mesh.attributes[i];
+			layout += ";" + a.name + ":" + std::to_string(a.length) + ":" + std::to_string(a.offset) + ":" + std::to_string(a.stride) +
+				":" + std::to_string((int)a.type) + ":" + std::to_string((int)a.normalized);
+		}
+		return layout;
+	}
+
+	/** Loads path every way there is and compares the results. */
+	static int ObjLoadingChecks(const std::string& path) {
+		std::vector<float> oldData, newData;
+		std::vector<unsigned int> oldIndices, newIndices;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		if (!LegacyLoad(path, oldData, oldIndices)) {
+			printf("  could not open %s\n", path.c_str());
+			return 1;
+		}
+		double legacy = Since(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		ResourceLib::MappedFile file(path);
+		double map = Since(start);
+		ResourceLib::ObjParser::Parse(file.Data(), file.Size(), newData, newIndices, 1);
+		double serial = Since(start);
+
+		printf("OBJ loading, %s, %.1f MB\n", path.c_str(), file.Size() / (1024.0 * 1024.0));
+		printf("  legacy     %10.2f ms\n", legacy);
+		printf("  serial     %10.2f ms, %.2f ms of it mapping, %.1fx\n", serial, map, legacy / serial);
+
+		int failures = 0;
+		if (oldIndices != newIndices || oldData.size() != newData.size()) {
+			failures++;
+		}
+		else {
+			for (size_t i = 0; i < oldData.size(); i++)
+				failures += !WithinUlp(oldData[i], newData[i]);
+		}
+
+		// The chunked parser must give exactly the serial output at any thread count.
+		unsigned cores = std::thread::hardware_concurrency();
+		std::vector<float> chunkData;
+		std::vector<unsigned int> chunkIndices;
+		for (unsigned threads = 2; threads <= (cores > 8 ? cores : 8); threads *= 2) {
+			start = std::chrono::high_resolution_clock::now();
+			ResourceLib::ObjParser::Parse(file.Data(), file.Size(), chunkData, chunkIndices, threads);
+			double chunked = Since(start);
+			printf("  %2u threads %10.2f ms, %.1fx serial\n", threads, chunked, serial / chunked);
+			failures += chunkIndices != newIndices || chunkData.size() != newData.size() ||
+				memcmp(chunkData.data(), newData.data(), newData.size() * sizeof(float)) != 0;
+		}
+
+		// Cooking optimizes and writes the cache next to the file, the second load maps it.
+		remove(ResourceLib::MeshCache::PathFor(path).c_str());
+		ResourceLib::MeshResource mesh;
+		start = std::chrono::high_resolution_clock::now();
+		mesh.Load(path);
+		double cook = Since(start);
+		const uint8_t* vertexBytes = mesh.GetVertexData();
+		const uint8_t* indexBytes = (const uint8_t*)mesh.GetIndexData();
+		std::vector<uint8_t> cookedData(vertexBytes, vertexBytes + mesh.GetVertexDataSize());
+		std::vector<uint8_t> cookedIndices(indexBytes, indexBytes + mesh.GetIndexCount() * mesh.indexSize);
+		std::string cookedLayout = Layout(mesh);
+		std::vector<ResourceLib::MeshResource::Lod> cookedLods = mesh.lods;
+		start = std::chrono::high_resolution_clock::now();
+		mesh.Load(path);
+		double cached = Since(start);
+		printf("  cook       %10.2f ms, cached load %.2f ms\n", cook, cached);
+		failures += !mesh.mapping || Layout(mesh) != cookedLayout ||
+			mesh.GetVertexDataSize() != cookedData.size() || mesh.GetIndexCount() * mesh.indexSize != cookedIndices.size() ||
+			memcmp(mesh.GetVertexData(), cookedData.data(), cookedData.size()) != 0 ||
+			memcmp(mesh.GetIndexData(), cookedIndices.data(), cookedIndices.size()) != 0;
+		failures += mesh.GetLodCount() != cookedLods.size();
+		for (size_t i = 0; i < cookedLods.size() && i < mesh.GetLodCount(); i++) {
+			ResourceLib::MeshResource::Lod lod = mesh.GetLod(i);
+			failures += lod.indexOffset != cookedLods[i].indexOffset || lod.indexCount != cookedLods[i].indexCount || lod.error != cookedLods[i].error;
+		}
+
+		printf("  %zu vertices, %zu triangles, %u cores\n", newData.size() / ResourceLib::ObjParser::Stride, newIndices.size() / 3, cores);
+		printf(failures == 0 ? "  serial matches the legacy loader, chunked matches serial, cache matches cooking\n" : "  %d MISMATCHES\n", failures);
+		return failures == 0 ? 0 : 1;
+	}
+
+	int ObjLoading(const char* filename) {
+		if (filename != nullptr)
+			return ObjLoadingChecks(filename);
+
+		// About two million quads, four million triangles.
+		const size_t side = 1450;
+		std::string path = "bench_grid.obj";
+		printf("Writing %zu quads to %s\n", side * side, path.c_str());
+		int result = 1;
+		if (WriteGrid(path, side))
+			result = ObjLoadingChecks(path);
+		else
+			printf("  could not write %s\n", path.c_str());
+
+		// Hundreds of MB, don't leave the grid or its cache behind. The
+		// checks have unmapped both by now.
+		remove(path.c_str());
+		remove(ResourceLib::MeshCache::PathFor(path).c_str());
+		return result;
+	}
+
+	/** Triangles rotated to start at their smallest index, then sorted. */
+	static std::vector<uint64_t> CanonicalTriangles(const std::vector<unsigned int>& indices) {
+		std::vector<uint64_t> keys;
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+			while (a > b || a > c) {
+				unsigned int t = a;
+				a = b;
+				b = c;
+				c = t;
+			}
+			// 21 bits each, enough for the generated sphere.
+			keys.push_back((uint64_t)a << 42 | (uint64_t)b << 21 | c);
+		}
+		std::sort(keys.begin(), keys.end());
+		return keys;
+	}
+
+	/**
+	 * A sphere of about a million triangles in scrambled order, like a
+	 * file written from a hash map.
+	 */
+	static void ScrambledSphere(std::vector<float>& vertices, std::vector<unsigned int>& indices, size_t stacks = 512, size_t slices = 1024) {
+		const size_t stride = ResourceLib::ObjParser::Stride;
+		std::mt19937 rng(3);
+		std::vector<unsigned int> shuffle((stacks + 1) * (slices + 1));
+		for (size_t i = 0; i < shuffle.size(); i++)
+			shuffle[i] = (unsigned int)i;
+		std::shuffle(shuffle.begin(), shuffle.end(), rng);
+
+		vertices.resize(shuffle.size() * stride);
+		for (size_t y = 0; y <= stacks; y++) {
+			for (size_t x = 0; x <= slices; x++) {
+				float theta = 3.14159265f * y / stacks, phi = 6.2831853f * x / slices;
+				// Poles exactly on the axis, float sin(pi) would leave slivers.
+				float ring = (y == 0 || y == stacks) ? 0.0f : std::sin(theta);
+				float n[3] = { ring * std::cos(phi), std::cos(theta), ring * std::sin(phi) };
+				float* v = &vertices[shuffle[y * (slices + 1) + x] * stride];
+				v[0] = n[0] * 10.0f; v[1] = n[1] * 10.0f; v[2] = n[2] * 10.0f;
+				v[3] = (float)x / slices; v[4] = (float)y / stacks;
+				v[5] = n[0]; v[6] = n[1]; v[7] = n[2];
+			}
+		}
+		std::vector<size_t> quads(stacks * slices);
+		for (size_t i = 0; i < quads.size(); i++)
+			quads[i] = i;
+		std::shuffle(quads.begin(), quads.end(), rng);
+		for (size_t i = 0; i < quads.size(); i++) {
+			size_t y = quads[i] / slices, x = quads[i] % slices;
+			unsigned int a = shuffle[y * (slices + 1) + x], b = shuffle[y * (slices + 1) + x + 1];
+			unsigned int c = shuffle[(y + 1) * (slices + 1) + x + 1], d = shuffle[(y + 1) * (slices + 1) + x];
+			const unsigned int quad[6] = { a, c, b, a, d, c };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+
+	int MeshOptimization(const char* filename) {
+		const size_t stride = ResourceLib::ObjParser::Stride;
+		std::vector<float> vertices;
+		std::vector<unsigned int> indices;
+
+		if (filename != nullptr) {
+			if (!ResourceLib::ObjParser::ParseFile(filename, vertices, indices) && indices.empty()) {
+				printf("  could not read %s\n", filename);
+				return 1;
+			}
+		}
+		else
+			ScrambledSphere(vertices, indices);
+
+		size_t vertexCount = vertices.size() / stride;
+		printf("Mesh optimization, %s, %zu vertices, %zu triangles, cache of %zu\n",
+			filename != nullptr ? filename : "scrambled sphere", vertexCount, indices.size() / 3, ResourceLib::MeshOptimizer::CacheSize);
+
+		typedef ResourceLib::MeshOptimizer Optimizer;
+		Optimizer::CacheStats stats = Optimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+		printf("  file order                  ACMR %.3f  ATVR %.3f\n", stats.acmr, stats.atvr);
+		std::vector<uint64_t> original = CanonicalTriangles(indices);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		Optimizer::OptimizeVertexCache(indices.data(), indices.size(), vertexCount);
+		double cacheTime = Since(start);
+		stats = Optimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+		printf("  vertex cache %10.2f ms   ACMR %.3f  ATVR %.3f\n", cacheTime, stats.acmr, stats.atvr);
+
+		start = std::chrono::high_resolution_clock::now();
+		Optimizer::OptimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertexCount, stride, 0);
+		double overdrawTime = Since(start);
+		stats = Optimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+		printf("  overdraw     %10.2f ms   ACMR %.3f  ATVR %.3f\n", overdrawTime, stats.acmr, stats.atvr);
+
+		int failures = CanonicalTriangles(indices) != original;
+
+		std::vector<float> before = vertices;
+		std::vector<unsigned int> beforeIndices = indices;
+		start = std::chrono::high_resolution_clock::now();
+		size_t used = Optimizer::OptimizeVertexFetch(vertices, stride, indices.data(), indices.size());
+		double fetchTime = Since(start);
+		stats = Optimizer::AnalyzeVertexCache(indices.data(), indices.size(), used);
+		printf("  vertex fetch %10.2f ms   ACMR %.3f  ATVR %.3f\n", fetchTime, stats.acmr, stats.atvr);
+
+		// Every corner must still see the same vertex data.
+		for (size_t i = 0; i < indices.size(); i++)
+			failures += memcmp(&vertices[indices[i] * stride], &before[beforeIndices[i] * stride], stride * sizeof(float)) != 0;
+
+		// How far apart consecutive newly fetched vertices are, in vertices.
+		double jumps[2] = { 0, 0 };
+		const std::vector<unsigned int>* lists[2] = { &beforeIndices, &indices };
+		for (int l = 0; l < 2; l++) {
+			for (size_t i = 1; i < lists[l]->size(); i++)
+				jumps[l] += std::fabs((double)(*lists[l])[i] - (double)(*lists[l])[i - 1]);
+			jumps[l] /= lists[l]->size();
+		}
+		printf("  mean index jump %.1f before fetch reorder, %.1f after\n", jumps[0], jumps[1]);
+		printf(failures == 0 ? "  every triangle kept with its winding and data\n" : "  %d MISMATCHES\n", failures);
+		return failures == 0 ? 0 : 1;
+	}
+
+	/** Triangles of a mesh by how they face compared to their vertex normals. */
+	struct Facing {
+		/** Repeating a vertex or out of range. */
+		size_t degenerate = 0;
+		/** Within a degree of edge on, or without area or normals. */
+		size_t edgeOn = 0;
+		size_t flipped = 0;
+	};
+
+	/** Classifies triangles against the sum of their vertex normals times winding. */
+	static Facing CheckTriangles(const unsigned int* indices, size_t indexCount, const float* vertices, size_t vertexCount, size_t stride, float winding) {
+		Facing facing;
+		for (size_t i = 0; i + 2 < indexCount; i += 3) {
+			unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+			if (a >= vertexCount || b >= vertexCount || c >= vertexCount || a == b || b == c || a == c) {
+				facing.degenerate++;
+				continue;
+			}
+			const float* p0 = &vertices[a * stride];
+			const float* p1 = &vertices[b * stride];
+			const float* p2 = &vertices[c * stride];
+			double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			double normal[3], d = 0, lengths = 0;
+			for (int k = 0; k < 3; k++) {
+				normal[k] = p0[5 + k] + p1[5 + k] + p2[5 + k];
+				d += n[k] * normal[k] * winding;
+			}
+			lengths = std::sqrt((n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) * (normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]));
+			// sin of a degree.
+			if (std::fabs(d) <= 0.0175 * lengths)
+				facing.edgeOn++;
+			else if (d < 0)
+				facing.flipped++;
+		}
+		return facing;
+	}
+
+	int LodGeneration(const char* filename) {
+		const size_t stride = ResourceLib::ObjParser::Stride;
+		std::vector<float> vertices;
+		std::vector<unsigned int> indices;
+
+		if (filename != nullptr) {
+			if (!ResourceLib::ObjParser::ParseFile(filename, vertices, indices) && indices.empty()) {
+				printf("  could not read %s\n", filename);
+				return 1;
+			}
+		}
+		else
+			ScrambledSphere(vertices, indices);
+
+		size_t vertexCount = vertices.size() / stride;
+		float scale = ResourceLib::MeshSimplifier::Scale(vertices.data(), vertexCount, stride, 0);
+		printf("Level of detail generation, %s, %zu vertices, %zu triangles\n",
+			filename != nullptr ? filename : "scrambled sphere", vertexCount, indices.size() / 3);
+
+		// Which way the file winds relative to its normals, some winds inward.
+		float winding = 1.0f;
+		Facing source = CheckTriangles(indices.data(), indices.size(), vertices.data(), vertexCount, stride, winding);
+		if (source.flipped > indices.size() / 6) {
+			winding = -1.0f;
+			source = CheckTriangles(indices.data(), indices.size(), vertices.data(), vertexCount, stride, winding);
+		}
+		printf("  source                          %8zu triangles  %zu degenerate  %zu edge on  %zu flipped\n",
+			indices.size() / 3, source.degenerate, source.edgeOn, source.flipped);
+
+		// The same chain ResourceLib::MeshResource builds.
+		const float ratios[] = { 0.5f, 0.25f, 0.125f, 0.0625f };
+		const float maxError = 0.02f;
+		std::vector<unsigned int> previous(indices), level(indices.size());
+		float error = 0;
+		int failures = 0;
+		for (size_t r = 0; r < sizeof(ratios) / sizeof(ratios[0]) && error < maxError; r++) {
+			size_t target = (size_t)(indices.size() / 3 * ratios[r]) * 3;
+			float levelError;
+			auto start = std::chrono::high_resolution_clock::now();
+			size_t count = ResourceLib::MeshSimplifier::Simplify(level.data(), previous.data(), previous.size(),
+				vertices.data(), vertexCount, stride, 0, target, maxError - error, &levelError);
+			double time = Since(start);
+			error += levelError;
+
+			Facing facing = CheckTriangles(level.data(), count, vertices.data(), vertexCount, stride, winding);
+			failures += facing.degenerate > 0 || facing.flipped > 0 || count > previous.size() || levelError > maxError;
+
+			printf("  ratio %.4f %10.2f ms   %8zu triangles  error %.5f (%.4f units)  %zu degenerate  %zu edge on  %zu flipped\n",
+				ratios[r], time, count / 3, error, error * scale, facing.degenerate, facing.edgeOn, facing.flipped);
+			if (count == 0 || count > previous.size() * 9 / 10)
+				break;
+			previous.assign(level.begin(), level.begin() + count);
+		}
+
+		printf(failures == 0 ? "  no level collapsed or flipped a triangle\n" : "  %d BAD LEVELS\n", failures);
+		return failures == 0 ? 0 : 1;
+	}
+
+	/**
+	 * Quantizes parsed vertices as ResourceLib::MeshResource::Load() does,
+	 * checking every decoded attribute against its bound and every index.
+	 *
+	 * @returns the number of attributes off their bound plus wrong indices.
+	 */
+	static int QuantizeMesh(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, bool octahedral) {
+		const size_t stride = ResourceLib::ObjParser::Stride;
+		const float positionError = 1.0f / 4096, uvError = 1.0f / 4096;
+		size_t vertexCount = vertices.size() / stride;
+
+		ResourceLib::MeshResource mesh;
+		mesh.data = vertices;
+		mesh.indices = indices;
+		mesh.indicesCount = indices.size();
+		mesh.attributes.push_back(ResourceLib::Attribute(3, 0, stride * sizeof(float), "pos"));
+		mesh.attributes.push_back(ResourceLib::Attribute(2, 3 * sizeof(float), stride * sizeof(float), "uv"));
+		mesh.attributes.push_back(ResourceLib::Attribute(3, 5 * sizeof(float), stride * sizeof(float), "normal"));
+		size_t before = mesh.GetVertexDataSize() + mesh.GetIndexCount() * mesh.indexSize;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		mesh.Quantize(positionError, uvError, octahedral);
+		mesh.CompactIndices();
+		double time = Since(start);
+		size_t after = mesh.GetVertexDataSize() + mesh.GetIndexCount() * mesh.indexSize;
+		printf("  %-10s %10.2f ms   %2zu -> %2zu bytes per vertex, %zu bytes per index, %.1f -> %.1f MB, %.2fx\n",
+			octahedral ? "octahedral" : "10-10-10-2", time, stride * sizeof(float), mesh.attributes[0].stride, mesh.indexSize,
+			before / (1024.0 * 1024.0), after / (1024.0 * 1024.0), (double)before / after);
+
+		float scale = ResourceLib::MeshSimplifier::Scale(vertices.data(), vertexCount, stride, 0);
+		const size_t offsets[3] = { 0, 3, 5 };
+		int failures = 0;
+		std::vector<float> decoded;
+		for (size_t i = 0; i < mesh.attributes.size() && i < 3; i++) {
+			const ResourceLib::Attribute& a = mesh.attributes[i];
+			size_t length = ResourceLib::VertexFormat::Components(a.type, a.length);
+			length = length < 3 ? length : 3;
+			decoded.resize(vertexCount * length);
+			ResourceLib::VertexFormat::DecodeArray(a.type, a.length, mesh.GetVertexData() + a.offset, a.stride, vertexCount, decoded.data(), length);
+
+			float error = 0;
+			for (size_t v = 0; v < vertexCount; v++) {
+				const float* source = &vertices[v * stride + offsets[i]];
+				float inverse = 1.0f;
+				if (a.type == ResourceLib::Attribute::Type::Octahedral) {
+					float lengthSq = source[0] * source[0] + source[1] * source[1] + source[2] * source[2];
+					inverse = lengthSq > 0 ? 1.0f / std::sqrt(lengthSq) : 0.0f;
+				}
+				for (size_t k = 0; k < length; k++)
+					error = std::max(error, std::fabs(decoded[v * length + k] - source[k] * inverse));
+			}
+
+			float bound = 0;
+			if (a.type != ResourceLib::Attribute::Type::Float)
+				bound = a.name == "pos" ? positionError * scale : (a.name == "uv" ? uvError : ResourceLib::VertexFormat::Precision(a.type));
+			failures += error > bound * 1.001f;
+			const char* types[] = { "float", "half", "snorm16", "unorm8", "octahedral", "10-10-10-2" };
+			printf("    %-6s %zu x %-10s error %.3g of %.3g\n", a.name.c_str(), a.length, types[(int)a.type], error, bound);
+		}
+
+		// 16 bit exactly when every vertex fits.
+		failures += (mesh.indexSize == sizeof(uint16_t)) != (vertexCount <= 65535) || mesh.GetIndexCount() != indices.size();
+		for (size_t i = 0; i < indices.size() && i < mesh.GetIndexCount(); i++)
+			failures += mesh.GetIndex(i) != indices[i];
+		return failures;
+	}
+
+	int VertexQuantization(const char* filename) {
+		std::vector<float> vertices;
+		std::vector<unsigned int> indices;
+
+		if (filename != nullptr) {
+			if (!ResourceLib::ObjParser::ParseFile(filename, vertices, indices) && indices.empty()) {
+				printf("  could not read %s\n", filename);
+				return 1;
+			}
+		}
+		else
+			ScrambledSphere(vertices, indices);
+
+		printf("Vertex quantization, %s, %zu vertices, %zu triangles\n",
+			filename != nullptr ? filename : "scrambled sphere", vertices.size() / ResourceLib::ObjParser::Stride, indices.size() / 3);
+		int failures = QuantizeMesh(vertices, indices, false);
+		failures += QuantizeMesh(vertices, indices, true);
+
+		// Small enough for 16 bit indices.
+		if (filename == nullptr) {
+			vertices.clear();
+			indices.clear();
+			ScrambledSphere(vertices, indices, 128, 256);
+			printf("Vertex quantization, small scrambled sphere, %zu vertices, %zu triangles\n",
+				vertices.size() / ResourceLib::ObjParser::Stride, indices.size() / 3);
+			failures += QuantizeMesh(vertices, indices, false);
+		}
+
+		printf(failures == 0 ? "  every attribute within its bound, every index kept\n" : "  %d MISMATCHES\n", failures);
+		return failures == 0 ? 0 : 1;
+	}
+
+	/** Milliseconds per frame of the passes ExampleApp::Run makes over the scene. */
+	struct ScenePasses {
+		double update = 0;
+		double transforms = 0;
+		double cleanup = 0;
+	};
+
+	/** Runs frames of the update callbacks, transform pass and cleanup. */
+	static ScenePasses SceneFrames(int frames) {
+		ResourceLib::SceneStore& scene = ResourceLib::GraphicsNode::scene;
+		ScenePasses passes;
+		for (int f = 0; f < frames; f++) {
+			auto start = std::chrono::high_resolution_clock::now();
+			for (size_t i = 0; i < scene.Size(); i++) {
+				if (scene.active[i] && scene.updates[i])
+					scene.updates[i]();
+			}
+			passes.update += Since(start);
+
+			start = std::chrono::high_resolution_clock::now();
+			ResourceLib::GraphicsNode::UpdateTransforms();
+			passes.transforms += Since(start);
+
+			start = std::chrono::high_resolution_clock::now();
+			scene.RemoveInactive();
+			passes.cleanup += Since(start);
+		}
+		passes.update /= frames;
+		passes.transforms /= frames;
+		passes.cleanup /= frames;
+		return passes;
+	}
+
+	int SceneUpdates(size_t count) {
+		typedef ResourceLib::GraphicsNode Node;
+		ResourceLib::SceneStore& scene = Node::scene;
+		const int frames = 100;
+		printf("Scene updates, %zu nodes, %d frames\n", count, frames);
+
+		// Groups of a root and three children, every node with a callback.
+		std::vector<std::unique_ptr<Node>> nodes(count);
+		std::vector<uint8_t> moving(count, 0);
+		for (size_t i = 0; i < count; i++) {
+			nodes[i].reset(new Node(nullptr, nullptr, nullptr));
+			// Roots on a grid, children a step off their parent.
+			if (i % 4 == 0)
+				nodes[i]->transform.SetLocation(MathLib::Vec4((float)(i / 4 % 500) * 4.0f, 0.0f, (float)(i / 2000) * 4.0f));
+			else {
+				nodes[i]->transform.SetLocation(MathLib::Vec4((float)(i % 4), 0.0f, 0.0f));
+				nodes[i]->SetParent(nodes[i - i % 4].get());
+			}
+			Node* node = nodes[i].get();
+			const uint8_t* move = &moving[i];
+			float angle = 0;
+			node->SetUpdate([node, move, angle]() mutable {
+				if (*move) {
+					angle += 0.01f;
+					node->transform.SetEulerRotation(0.0f, angle, 0.0f);
+				}
+			});
+		}
+		Node::UpdateTransforms();
+
+		// Every node moving, then one in a hundred, then nothing.
+		const int shares[] = { 1, 100, 0 };
+		for (int s = 0; s < 3; s++) {
+			for (size_t i = 0; i < count; i++)
+				moving[i] = shares[s] > 0 && i % shares[s] == 0;
+			ScenePasses passes = SceneFrames(frames);
+			printf("  %-12s update %7.3f ms  transforms %7.3f ms  cleanup %7.3f ms  total %7.3f ms per frame\n",
+				s == 0 ? "all moving" : (s == 1 ? "1% moving" : "static"),
+				passes.update, passes.transforms, passes.cleanup, passes.update + passes.transforms + passes.cleanup);
+		}
+
+		// The old std::map<GraphicsNode*, bool> walk, for comparison.
+		std::map<Node*, bool> legacy;
+		for (size_t i = 0; i < count; i++)
+			legacy[nodes[i].get()] = true;
+		auto start = std::chrono::high_resolution_clock::now();
+		size_t visited = 0;
+		for (int f = 0; f < frames; f++) {
+			for (std::map<Node*, bool>::iterator it = legacy.begin(); it != legacy.end(); ++it)
+				visited += it->second;
+		}
+		double legacyWalk = Since(start) / frames;
+		start = std::chrono::high_resolution_clock::now();
+		for (int f = 0; f < frames; f++) {
+			for (size_t i = 0; i < scene.Size(); i++)
+				visited += scene.active[i];
+		}
+		double denseWalk = Since(start) / frames;
+		printf("  empty walk   map %7.3f ms  dense %7.3f ms, %.1fx  (%zu visits)\n", legacyWalk, denseWalk, legacyWalk / denseWalk, visited);
+
+		// One in a hundred deleted, cleaned up in one frame.
+		for (size_t i = 0; i < count; i += 100)
+			nodes[i]->Delete();
+		start = std::chrono::high_resolution_clock::now();
+		scene.RemoveInactive();
+		double churn = Since(start);
+		printf("  removing %zu deleted nodes %7.3f ms\n", (count + 99) / 100, churn);
+
+		// The arrays must still mirror every live node.
+		int failures = scene.Size() != count - (count + 99) / 100;
+		for (size_t i = 0; i < count; i++) {
+			size_t index = scene.IndexOf(nodes[i]->GetSceneHandle());
+			if (i % 100 == 0)
+				failures += index != SIZE_MAX;
+			else
+				failures += index == SIZE_MAX || scene.nodes[index] != nodes[i].get() ||
+					memcmp(&scene.world[index], &nodes[i]->GetWorldMatrix(), sizeof(MathLib::Mat4)) != 0;
+		}
+		nodes.clear();
+		failures += scene.Size() != 0;
+
+		printf(failures == 0 ? "  every live node found with its world matrix, deleted ones gone\n" : "  %d MISMATCHES\n", failures);
+		return failures == 0 ? 0 : 1;
+	}
+
+	/** Float bits, NaNs compare equal by their bits too. */
+	static uint32_t FloatBits(float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	static float BitsFloat(uint32_t bits) {
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	int HalfConversion(size_t count) {
+		typedef ResourceLib::HalfArray::Level Level;
+		const std::float_round_style modes[] = { std::round_toward_zero, std::round_to_nearest, std::round_toward_infinity, std::round_toward_neg_infinity };
+		const char* modeNames[] = { "toward zero", "to nearest", "toward +inf", "toward -inf" };
+		Level best = ResourceLib::HalfArray::DetectLevel();
+		printf("Half conversion, %zu values, best instruction set %s\n", count, ResourceLib::HalfArray::LevelName(best));
+
+		// Every half, then floats on and around every rounding boundary.
+		std::vector<uint16_t> everyHalf(65536);
+		for (size_t i = 0; i < everyHalf.size(); i++)
+			everyHalf[i] = (uint16_t)i;
+		std::vector<float> everyHalfFloat(everyHalf.size());
+		for (size_t i = 0; i < everyHalf.size(); i++)
+			everyHalfFloat[i] = half_float::detail::half2float<float>(everyHalf[i]);
+
+		std::vector<float> boundaries;
+		for (uint32_t h = 0; h < 0x7C00; h++) {
+			for (uint32_t sign = 0; sign <= 0x8000; sign += 0x8000) {
+				uint32_t low = FloatBits(everyHalfFloat[h | sign]);
+				// Halfway to the next half is exact in float.
+				uint32_t middle = FloatBits((everyHalfFloat[h | sign] + everyHalfFloat[(h + 1) | sign]) * 0.5f);
+				const uint32_t bits[] = { low, low + 1, low - 1, middle, middle + 1, middle - 1 };
+				for (int k = 0; k < 6; k++)
+					boundaries.push_back(BitsFloat(bits[k]));
+			}
+		}
+		// Overflow, float subnormals, infinities and NaNs with payloads.
+		const uint32_t specials[] = { 0x477FEFFF, 0x477FF000, 0x477FF001, 0x47800000, 0x7F7FFFFF, 0x00000001, 0x007FFFFF, 0x33000000,
+			0x32FFFFFF, 0x337FFFFF, 0x7F800000, 0x7F800001, 0x7FC00000, 0x7FFFFFFF, 0x7F802000, 0x7FBFE000 };
+		for (size_t k = 0; k < sizeof(specials) / sizeof(specials[0]); k++) {
+			boundaries.push_back(BitsFloat(specials[k]));
+			boundaries.push_back(BitsFloat(specials[k] | 0x80000000));
+		}
+		std::mt19937 rng(11);
+		for (size_t i = 0; i < 1000000; i++)
+			boundaries.push_back(BitsFloat((uint32_t)rng()));
+
+		// half.h one value at a time is the reference.
+		std::vector<uint16_t> expected[4];
+		for (int m = 0; m < 4; m++) {
+			expected[m].resize(boundaries.size());
+			for (size_t i = 0; i < boundaries.size(); i++) {
+				half_float::half h;
+				switch (modes[m]) {
+				case std::round_toward_zero: h = half_float::half_cast<half_float::half, std::round_toward_zero>(boundaries[i]); break;
+				case std::round_toward_infinity: h = half_float::half_cast<half_float::half, std::round_toward_infinity>(boundaries[i]); break;
+				case std::round_toward_neg_infinity: h = half_float::half_cast<half_float::half, std::round_toward_neg_infinity>(boundaries[i]); break;
+				default: h = half_float::half_cast<half_float::half, std::round_to_nearest>(boundaries[i]); break;
+				}
+				std::memcpy(&expected[m][i], &h, sizeof(uint16_t));
+			}
+		}
+
+		std::vector<float> floats(count);
+		std::vector<uint16_t> halves(count);
+		std::uniform_real_distribution<float> distribution(-1000.0f, 1000.0f);
+		for (size_t i = 0; i < count; i++)
+			floats[i] = distribution(rng);
+
+		int failures = 0;
+		double scalarTime[2] = { 0, 0 };
+		for (int l = 0; l <= (int)best; l++) {
+			Level level = (Level)l;
+			ResourceLib::HalfArray::SetLevel(level);
+
+			// Every half must widen to half.h's float and come back in every mode.
+			int mismatches = 0;
+			std::vector<float> widened(everyHalf.size());
+			std::vector<uint16_t> narrowed(everyHalf.size());
+			ResourceLib::HalfArray::ToFloat(everyHalf.data(), widened.data(), everyHalf.size());
+			for (size_t i = 0; i < everyHalf.size(); i++) {
+				// F16C widens signaling NaNs quiet, as half.h does when built for it.
+				uint32_t bits = FloatBits(widened[i]), expectedBits = FloatBits(everyHalfFloat[i]);
+				bool nan = (everyHalf[i] & 0x7FFF) > 0x7C00;
+				mismatches += bits != expectedBits && !(nan && bits == (expectedBits | 0x400000));
+			}
+			for (int m = 0; m < 4; m++) {
+				ResourceLib::HalfArray::FromFloat(widened.data(), narrowed.data(), widened.size(), modes[m]);
+				for (size_t i = 0; i < everyHalf.size(); i++) {
+					// NaNs come back quiet.
+					uint16_t h = everyHalf[i];
+					bool nan = (h & 0x7FFF) > 0x7C00;
+					mismatches += narrowed[i] != (nan ? (h | 0x200) : h);
+				}
+			}
+
+			// Narrowing around every boundary must match half.h bit for bit.
+			std::vector<uint16_t> rounded(boundaries.size());
+			for (int m = 0; m < 4; m++) {
+				ResourceLib::HalfArray::FromFloat(boundaries.data(), rounded.data(), boundaries.size(), modes[m]);
+				for (size_t i = 0; i < boundaries.size(); i++)
+					mismatches += rounded[i] != expected[m][i];
+			}
+			failures += mismatches;
+
+			auto start = std::chrono::high_resolution_clock::now();
+			ResourceLib::HalfArray::FromFloat(floats.data(), halves.data(), count);
+			double narrowTime = Since(start);
+			start = std::chrono::high_resolution_clock::now();
+			ResourceLib::HalfArray::ToFloat(halves.data(), floats.data(), count);
+			double widenTime = Since(start);
+			if (level == Level::Scalar) {
+				scalarTime[0] = narrowTime;
+				scalarTime[1] = widenTime;
+			}
+
+			printf("  %-6s  to half %8.2f ms %7.0f M/s %5.1fx   to float %8.2f ms %7.0f M/s %5.1fx   %d mismatches\n",
+				ResourceLib::HalfArray::LevelName(level),
+				narrowTime, count / (narrowTime * 1000.0), scalarTime[0] / narrowTime,
+				widenTime, count / (widenTime * 1000.0), scalarTime[1] / widenTime, mismatches);
+		}
+		ResourceLib::HalfArray::SetLevel(best);
+
+		printf("  checked all 65536 halves and %zu floats rounded %s, %s, %s and %s\n",
+			boundaries.size(), modeNames[0], modeNames[1], modeNames[2], modeNames[3]);
+		printf(failures == 0 ? "  every instruction set matches half.h bit for bit\n" : "  %d MISMATCHES\n", failures);
+		return failures == 0 ? 0 : 1;
+	}
+
+	int Run(int argc, char** argv) {
+		for (int i = 1; i < argc; i++) {
+			if (std::strcmp(argv[i], "--bench-bvh") == 0) {
+				size_t count = i + 1 < argc ? (size_t)std::strtoull(argv[i + 1], nullptr, 10) : 0;
+				if (count > 0)
+					return AABBTreeQueries(count);
+
+				// Default sweep over the sizes the tree is meant for.
+				int result = 0;
+				for (size_t n = 100000; n <= 1000000; n *= 10)
+					result |= AABBTreeQueries(n);
+				return result;
+			}
+			if (std::strcmp(argv[i], "--bench-occlusion") == 0) {
+				size_t count = i + 1 < argc ? (size_t)std::strtoull(argv[i + 1], nullptr, 10) : 0;
+				return OcclusionQueries(count > 0 ? count : 10000);
+			}
+			if (std::strcmp(argv[i], "--bench-obj") == 0)
+				return ObjLoading(i + 1 < argc ? argv[i + 1] : nullptr);
+			if (std::strcmp(argv[i], "--bench-meshopt") == 0)
+				return MeshOptimization(i + 1 < argc ? argv[i + 1] : nullptr);
+			if (std::strcmp(argv[i], "--bench-lod") == 0)
+				return LodGeneration(i + 1 < argc ? argv[i + 1] : nullptr);
+			if (std::strcmp(argv[i], "--bench-quantize") == 0)
+				return VertexQuantization(i + 1 < argc ? argv[i + 1] : nullptr);
+			if (std::strcmp(argv[i], "--bench-scene") == 0) {
+				size_t count = i + 1 < argc ? (size_t)std::strtoull(argv[i + 1], nullptr, 10) : 0;
+				return SceneUpdates(count > 0 ? count : 100000);
+			}
+			if (std::strcmp(argv[i], "--bench-half") == 0) {
+				size_t count = i + 1 < argc ? (size_t)std::strtoull(argv[i + 1], nullptr, 10) : 0;
+				return HalfConversion(count > 0 ? count : 16 * 1024 * 1024);
+			}
+		}
+		return -1;
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Headless benchmarks, run from the command line instead of the app.
+ *
+ *     Lighting --bench-bvh [count]
+ *     Lighting --bench-occlusion [count]
+ *     Lighting --bench-obj [file.obj]
+ *     Lighting --bench-meshopt [file.obj]
+ *     Lighting --bench-lod [file.obj]
+ *     Lighting --bench-quantize [file.obj]
+ *     Lighting --bench-half [count]
+ *     Lighting --bench-scene [count]
+ */
+namespace Benchmark {
+
+	/**
+	 * Times AABBTree insert, move and every query kind against a linear
+	 * scan over count random boxes, checking that both find the same set.
+	 *
+	 * @returns 0 on success, 1 if the tree and the scan disagreed.
+	 */
+	int AABBTreeQueries(size_t count);
+
+	/**
+	 * Times GG::OcclusionCuller on a city of count random boxes, every box
+	 * an occluder and an occludee, against its brute force reference mode.
+	 * The SIMD, threaded depth buffer must match the reference bit for bit
+	 * and the tiles must never hide a box the reference sees.
+	 *
+	 * @returns 0 on success, 1 on a mismatch.
+	 */
+	int OcclusionQueries(size_t count);
+
+	/**
+	 * Times ResourceLib::ObjParser against the old getline and std::map
+	 * loader on a file, or a generated grid of two million quads if none
+	 * is given. The grid and its cache are deleted afterwards. Indices must match exactly and floats within an ulp, and
+	 * the chunked parse must match the serial one bit for bit at 2 to 8
+	 * threads or the core count. Also times cooking a ResourceLib::MeshCache
+	 * against loading from it, which must give the cooked data again.
+	 *
+	 * @returns 0 on success, 1 on a mismatch or if the file can't be read.
+	 */
+	int ObjLoading(const char* filename);
+
+	/**
+	 * Runs the ResourceLib::MeshOptimizer stages on a file, or a sphere of
+	 * a million triangles in scrambled order, reporting ACMR and ATVR
+	 * after each. Every triangle must survive with its winding and every
+	 * corner with its vertex data.
+	 *
+	 * @returns 0 on success, 1 on a mismatch or if the file can't be read.
+	 */
+	int MeshOptimization(const char* filename);
+
+	/**
+	 * Builds a chain of ResourceLib::MeshSimplifier levels of detail from
+	 * a file, or the scrambled sphere, reporting time, triangles and error
+	 * per level. No level may hold a collapsed or flipped triangle.
+	 *
+	 * @returns 0 on success, 1 on a bad level or if the file can't be read.
+	 */
+	int LodGeneration(const char* filename);
+
+	/**
+	 * Quantizes a file, or the scrambled sphere and a small one that fits
+	 * 16 bit indices, with ResourceLib::MeshResource::Quantize(), reporting
+	 * the memory saved with 10-10-10-2 and with octahedral normals. Every
+	 * decoded attribute must be within its stated bound and every index
+	 * must survive.
+	 *
+	 * @returns 0 on success, 1 on a mismatch or if the file can't be read.
+	 */
+	int VertexQuantization(const char* filename);
+
+	/**
+	 * Times ResourceLib::HalfArray both ways on count floats at every
+	 * instruction set the CPU has. Each must widen all 65536 halves to
+	 * half.h's floats and narrow them back in every rounding mode, and
+	 * narrow floats on and around every rounding boundary, plus a million
+	 * random ones, to half.h's bits.
+	 *
+	 * @returns 0 on success, 1 on a mismatch.
+	 */
+	int HalfConversion(size_t count);
+
+	/**
+	 * Times the per frame passes over ResourceLib::GraphicsNode::scene,
+	 * the update callbacks, UpdateTransforms() and RemoveInactive(), on
+	 * count nodes in groups of a parent and three children, with all, one
+	 * in a hundred and none of them moving. Then deletes one in a hundred,
+	 * after which every live node must still be found with its world matrix.
+	 *
+	 * @returns 0 on success, 1 on a mismatch.
+	 */
+	int SceneUpdates(size_t count);
+
+	/** Runs the benchmark named by the arguments, -1 if none was asked for. */
+	int Run(int argc, char** argv);
+}
@@ -0,0 +1,99 @@
+#include "FrustumCuller.h"
+#include "MeshResource.h"
+
+#include <cmath>
+
+void GG::FrustumCuller::Cull(const ResourceLib::SceneStore& scene, const MathLib::Mat4& viewProjection) {
+	MathLib::Vec4 planes[6];
+	MathLib::Mat4::FrustumPlanes(viewProjection, planes);
+
+	if (useTree) {
+		uint32_t activeCount = 0;
+		for (size_t i = 0; i < scene.Size(); i++)
+			activeCount += scene.active[i];
+
+		visible.clear();
+		scene.tree.QueryFrustum(planes[0].Data(), [this, &scene](uint64_t userData) {
+			size_t i = scene.IndexOf(ResourceLib::SceneStore::UnpackHandle(userData));
+			if (i != SIZE_MAX && scene.active[i])
+				visible.push_back((uint32_t)i);
+		});
+
+		stats.visible = (uint32_t)visible.size();
+		stats.culled = activeCount - stats.visible;
+		return;
+	}
+
+	candidates.clear();
+	for (size_t i = 0; i < scene.Size(); i++) {
+		if (scene.active[i])
+			candidates.push_back((uint32_t)i);
+	}
+
+	size_t n = candidates.size();
+	centerX.resize(n);
+	centerY.resize(n);
+	centerZ.resize(n);
+	radius.resize(n);
+	extentX.resize(n);
+	extentY.resize(n);
+	extentZ.resize(n);
+	mask.resize(n);
+
+	///////////////////////////
+	// BOUNDS TO WORLD SPACE //
+	///////////////////////////
+	for (size_t c = 0; c < n; c++) {
+		size_t i = candidates[c];
+		const float* m = scene.world[i].Data();
+		const ResourceLib::MeshResource* mr = scene.meshes[i];
+
+		float center[3] = { 0, 0, 0 };
+		float extents[3] = { 0, 0, 0 };
+		float r = 0;
+		if (mr != nullptr) {
+			for (int k = 0; k < 3; k++) {
+				center[k] = mr->boundsCenter[k];
+				extents[k] = mr->boundsExtents[k];
+			}
+			r = mr->boundsRadius;
+		}
+
+		// Rows of the model matrix, the center is a point.
+		centerX[c] = m[0] * center[0] + m[1] * center[1] + m[2] * center[2] + m[3];
+		centerY[c] = m[4] * center[0] + m[5] * center[1] + m[6] * center[2] + m[7];
+		centerZ[c] = m[8] * center[0] + m[9] * center[1] + m[10] * center[2] + m[11];
+
+		// The box rotated into world space and boxed again.
+		extentX[c] = std::fabs(m[0]) * extents[0] + std::fabs(m[1]) * extents[1] + std::fabs(m[2]) * extents[2];
+		extentY[c] = std::fabs(m[4]) * extents[0] + std::fabs(m[5]) * extents[1] + std::fabs(m[6]) * extents[2];
+		extentZ[c] = std::fabs(m[8]) * extents[0] + std::fabs(m[9]) * extents[1] + std::fabs(m[10]) * extents[2];
+
+		// The sphere grows with the largest axis scale.
+		float scaleSq = 0;
+		for (int k = 0; k < 3; k++) {
+			float s = m[k] * m[k] + m[4 + k] * m[4 + k] + m[8 + k] * m[8 + k];
+			if (s > scaleSq)
+				scaleSq = s;
+		}
+		radius[c] = r * std::sqrt(scaleSq);
+	}
+
+	///////////////////
+	// FRUSTUM TEST  //
+	///////////////////
+	size_t visibleCount = MathLib::SIMD::FrustumCull(planes[0].Data(),
+		centerX.data(), centerY.data(), centerZ.data(), radius.data(),
+		extentX.data(), extentY.data(), extentZ.data(),
+		n, mask.data());
+
+	visible.clear();
+	visible.reserve(visibleCount);
+	for (size_t c = 0; c < n; c++) {
+		if (mask[c])
+			visible.push_back(candidates[c]);
+	}
+
+	stats.visible = (uint32_t)visibleCount;
+	stats.culled = (uint32_t)(n - visibleCount);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "SceneStore.h"
+#include "MathLib.h"
+
+namespace GG {
+
+	/**
+	 * Removes scene entries outside the camera frustum before submission.
+	 *
+	 * Each frame the mesh bounds are moved to world space into SoA arrays
+	 * and tested against the six frustum planes in one batched SIMD pass,
+	 * see MathLib::SIMD::FrustumCull(). The result is a list of dense
+	 * scene indices for RenderQueue::SubmitScene().
+	 *
+	 * With useTree the scene's AABBTree is queried instead, which skips
+	 * whole subtrees and wins when most of a large scene is off screen.
+	 */
+	class FrustumCuller {
+	public:
+		/** Entries tested and their outcome in the last Cull(). */
+		struct Stats {
+			uint32_t visible = 0;
+			uint32_t culled = 0;
+		};
+
+		/** Query SceneStore::tree instead of testing every entry. */
+		bool useTree = false;
+
+		/**
+		 * Culls every active entry of a scene.
+		 *
+		 * @viewProjection is projection * view, as set by
+		 * ResourceHandler::SetCameraMatrices().
+		 */
+		void Cull(const ResourceLib::SceneStore& scene, const MathLib::Mat4& viewProjection);
+
+		/** Dense scene indices that passed the last Cull(). */
+		const std::vector<uint32_t>& GetVisible() const {
+			return visible;
+		}
+
+		const Stats& GetStats() const {
+			return stats;
+		}
+
+	private:
+		/** Active entries, in the order of the bounds arrays. */
+		std::vector<uint32_t> candidates;
+
+		// World space bounds of the candidates.
+		std::vector<float> centerX, centerY, centerZ, radius;
+		std::vector<float> extentX, extentY, extentZ;
+		/** Result per candidate, 1 if visible. */
+		std::vector<uint8_t> mask;
+
+		std::vector<uint32_t> visible;
+		Stats stats;
+	};
+
+}
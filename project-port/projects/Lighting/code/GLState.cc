@@ -0,0 +1,142 @@
+#include "GLState.h"
+
+void GG::GLState::BeginFrame() {
+	lastFrame = frame;
+	frame = Counters();
+	Invalidate();
+}
+
+void GG::GLState::Invalidate() {
+	program = Unknown;
+	vertexArray = Unknown;
+	arrayBuffer = Unknown;
+	elementBuffer = Unknown;
+	uniformBuffer = Unknown;
+	storageBuffer = Unknown;
+	indirectBuffer = Unknown;
+	for (GLuint i = 0; i < MaxUniformBindings; i++)
+		uniformBindings[i] = Unknown;
+	activeUnit = Unknown;
+	for (GLuint i = 0; i < MaxTextureUnits; i++)
+		textures[i] = Unknown;
+}
+
+void GG::GLState::UseProgram(GLuint program) {
+	if (Change(GLState::program, program))
+		glUseProgram(program);
+}
+
+void GG::GLState::BindVertexArray(GLuint vao) {
+	if (Change(vertexArray, vao)) {
+		glBindVertexArray(vao);
+		// The element buffer binding lives in the vertex array.
+		elementBuffer = Unknown;
+	}
+}
+
+void GG::GLState::BindBuffer(GLenum target, GLuint buffer) {
+	GLuint* shadow;
+	switch (target) {
+	case GL_ARRAY_BUFFER:
+		shadow = &arrayBuffer;
+		break;
+	case GL_ELEMENT_ARRAY_BUFFER:
+		shadow = &elementBuffer;
+		break;
+	case GL_UNIFORM_BUFFER:
+		shadow = &uniformBuffer;
+		break;
+	case GL_SHADER_STORAGE_BUFFER:
+		shadow = &storageBuffer;
+		break;
+	case GL_DRAW_INDIRECT_BUFFER:
+		shadow = &indirectBuffer;
+		break;
+	default:
+		frame.issued++;
+		glBindBuffer(target, buffer);
+		return;
+	}
+
+	if (Change(*shadow, buffer))
+		glBindBuffer(target, buffer);
+}
+
+void GG::GLState::BindUniformBufferBase(GLuint index, GLuint buffer) {
+	if (index >= MaxUniformBindings) {
+		frame.issued++;
+		glBindBufferBase(GL_UNIFORM_BUFFER, index, buffer);
+		uniformBuffer = buffer;
+		return;
+	}
+
+	if (Change(uniformBindings[index], buffer)) {
+		glBindBufferBase(GL_UNIFORM_BUFFER, index, buffer);
+		// Indexed binds also bind the generic target.
+		uniformBuffer = buffer;
+	}
+}
+
+void GG::GLState::BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+	frame.issued++;
+	glBindBufferRange(target, index, buffer, offset, size);
+
+	// Indexed binds also bind the generic target.
+	if (target == GL_UNIFORM_BUFFER) {
+		uniformBuffer = buffer;
+		// A later whole buffer bind on this point must not be skipped.
+		if (index < MaxUniformBindings)
+			uniformBindings[index] = Unknown;
+	}
+	else if (target == GL_SHADER_STORAGE_BUFFER) {
+		storageBuffer = buffer;
+	}
+}
+
+void GG::GLState::ActiveTexture(GLuint unit) {
+	if (Change(activeUnit, unit))
+		glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GG::GLState::BindTexture(GLuint unit, GLenum target, GLuint texture) {
+	if (unit >= MaxTextureUnits || target != GL_TEXTURE_2D) {
+		ActiveTexture(unit);
+		frame.issued++;
+		glBindTexture(target, texture);
+		if (unit < MaxTextureUnits)
+			textures[unit] = Unknown;
+		return;
+	}
+
+	if (textures[unit] == texture) {
+		frame.elided++;
+		return;
+	}
+
+	ActiveTexture(unit);
+	Change(textures[unit], texture);
+	glBindTexture(target, texture);
+}
+
+// Initialize shadow state as unknown.
+GLuint GG::GLState::program = GG::GLState::Unknown;
+GLuint GG::GLState::vertexArray = GG::GLState::Unknown;
+GLuint GG::GLState::arrayBuffer = GG::GLState::Unknown;
+GLuint GG::GLState::elementBuffer = GG::GLState::Unknown;
+GLuint GG::GLState::uniformBuffer = GG::GLState::Unknown;
+GLuint GG::GLState::storageBuffer = GG::GLState::Unknown;
+GLuint GG::GLState::indirectBuffer = GG::GLState::Unknown;
+GLuint GG::GLState::uniformBindings[GG::GLState::MaxUniformBindings] = {
+	GG::GLState::Unknown, GG::GLState::Unknown, GG::GLState::Unknown, GG::GLState::Unknown,
+	GG::GLState::Unknown, GG::GLState::Unknown, GG::GLState::Unknown, GG::GLState::Unknown
+};
+GLuint GG::GLState::activeUnit = GG::GLState::Unknown;
+GLuint GG::GLState::textures[GG::GLState::MaxTextureUnits] = {
+	GG::GLState::Unknown, GG::GLState::Unknown, GG::GLState::Unknown, GG::GLState::Unknown,
+	GG::GLState::Unknown, GG::GLState::Unknown, GG::GLState::Unknown, GG::GLState::Unknown,
+	GG::GLState::Unknown, GG::GLState::Unknown, GG::GLState::Unknown, GG::GLState::Unknown,
+	GG::GLState::Unknown, GG::GLState::Unknown, GG::GLState::Unknown, GG::GLState::Unknown
+};
+
+GG::GLState::Counters GG::GLState::frame;
+GG::GLState::Counters GG::GLState::lastFrame;
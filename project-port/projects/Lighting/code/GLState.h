@@ -0,0 +1,101 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+
+namespace GG {
+
+	/**
+	 * Shadow of the GL binding state used by the renderer.
+	 *
+	 * Every bind goes through here and is skipped if GL already has that
+	 * object bound. Code outside the renderer (UI, NanoVG) changes state
+	 * behind our back, so call BeginFrame() before drawing and Invalidate()
+	 * after anything else has touched GL.
+	 */
+	class GLState {
+	public:
+		/** Calls made and skipped during a frame. */
+		struct Counters {
+			uint32_t issued = 0;
+			uint32_t elided = 0;
+		};
+
+		/** Texture units tracked, binds on higher units are always issued. */
+		static const GLuint MaxTextureUnits = 16;
+
+		/** Forgets the shadowed state and starts counting a new frame. */
+		static void BeginFrame();
+
+		/** Forgets the shadowed state, the next bind of every kind is issued. */
+		static void Invalidate();
+
+		/** Counters of the last finished frame. */
+		static const Counters& GetLastFrame() {
+			return lastFrame;
+		}
+
+		/** Counters of the current frame so far. */
+		static const Counters& GetFrame() {
+			return frame;
+		}
+
+		static void UseProgram(GLuint program);
+
+		/** Binds a vertex array, this also switches the element buffer. */
+		static void BindVertexArray(GLuint vao);
+
+		/** Binds array, element, uniform, storage or indirect buffers, others are passed on. */
+		static void BindBuffer(GLenum target, GLuint buffer);
+
+		/** Binds a whole uniform buffer to an indexed binding point. */
+		static void BindUniformBufferBase(GLuint index, GLuint buffer);
+
+		/**
+		 * Binds part of a uniform or storage buffer to an indexed binding point.
+		 *
+		 * Ranges move every draw when streaming, so this is always issued
+		 * and only keeps the shadow of the generic target in step.
+		 */
+		static void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+		static void ActiveTexture(GLuint unit);
+
+		/** Binds a 2D texture to a unit, switching the active unit if needed. */
+		static void BindTexture(GLuint unit, GLenum target, GLuint texture);
+
+	private:
+		/** Value of a shadow slot whose GL state is unknown. */
+		static const GLuint Unknown = 0xFFFFFFFF;
+
+		/** Updates a shadow slot, returns true if the GL call is needed. */
+		static bool Change(GLuint& shadow, GLuint value) {
+			if (shadow == value) {
+				frame.elided++;
+				return false;
+			}
+			shadow = value;
+			frame.issued++;
+			return true;
+		}
+
+		/** Uniform binding points tracked. */
+		static const GLuint MaxUniformBindings = 8;
+
+		static GLuint program;
+		static GLuint vertexArray;
+		static GLuint arrayBuffer;
+		static GLuint elementBuffer;
+		static GLuint uniformBuffer;
+		static GLuint storageBuffer;
+		static GLuint indirectBuffer;
+		static GLuint uniformBindings[MaxUniformBindings];
+		static GLuint activeUnit;
+		static GLuint textures[MaxTextureUnits];
+
+		static Counters frame;
+		static Counters lastFrame;
+	};
+
+}
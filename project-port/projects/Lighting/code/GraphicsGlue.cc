@@ -1,10 +1,9 @@
 #include "GraphicsGlue.h"
+#include "GLState.h"
 //using namespace ResourceLib;
 #include <unordered_map>
 
 
-//GG::ResourceHandler::handles = std::unordered_map<std::string, std::pair<GLenum, GLint>>();
-
 //GG::ResourceHandler::shaders
 
 void GG::ResourceHandler::UploadShaderResource(std::shared_ptr<ResourceLib::ShaderResource> const& sr, bool unloadOnLoad) {
@@ -23,9 +22,10 @@ void GG::ResourceHandler::UploadShaderResource(std::shared_ptr<ResourceLib::Shad
 
 	// Compile shaders.
 	for (size_t i = 0; i < sr->shaders.size(); i++) {
-		GLint length = sr->shaders[i].second.size();
+		std::string source = sr->GetSource(i);
+		GLint length = source.size();
 
-		GLchar const* shad = sr->shaders[i].second.c_str();
+		GLchar const* shad = source.c_str();
 
 		GLenum shaderType;
 
@@ -102,71 +102,118 @@ void GG::ResourceHandler::UploadShaderResource(std::shared_ptr<ResourceLib::Shad
 		glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
 		printf("Active Uniforms: %d\n", count);
 
-		for (GLuint i = 0; i < count; i++)
+		// Reflect once into the semantic table and typed storage.
+		sr->ClearUniforms();
+
+		for (GLuint i = 0; i < (GLuint)count; i++)
 		{
 			glGetActiveUniform(program, i, bufSize, &length, &size, &type, uniformName);
 			GLint address = glGetUniformLocation(program, uniformName);
 			printf("Uniform Name: %s Type: %d Handle: %d\n", uniformName, type, address);
 
-			// Put in uniform map.
-			std::string handleName = sr->filename+uniformName;
-			handleName += std::to_string(program); // append location as well.
-			handles[handleName] = std::pair<GLenum, GLint>(type, address);
-
 			ResourceLib::ShaderResource::UniformType t;
-			std::shared_ptr<void> u;
 
 			switch (type) {
 			case GL_INT:
 				t = ResourceLib::ShaderResource::UniformType::Int;
-				u = std::make_shared<int>();
 				break;
 
 			case GL_FLOAT:
 				t = ResourceLib::ShaderResource::UniformType::Float;
-				u = std::make_shared<float>();
 				break;
 
 			case GL_FLOAT_VEC2:
 				t = ResourceLib::ShaderResource::UniformType::Vec2;
-				u = std::make_shared<MathLib::Vec4>();
 				break;
 
 			case GL_FLOAT_VEC3:
 				t = ResourceLib::ShaderResource::UniformType::Vec3;
-				u = std::make_shared<MathLib::Vec4>();
 				break;
 
 			case GL_FLOAT_VEC4:
 				t = ResourceLib::ShaderResource::UniformType::Vec4;
-				u = std::make_shared<MathLib::Vec4>();
 				break;
 
 			case GL_FLOAT_MAT4:
 				t = ResourceLib::ShaderResource::UniformType::Mat4;
-				u = std::make_shared<MathLib::Mat4>();
 				break;
 
 			case GL_SAMPLER_2D:
 				t = ResourceLib::ShaderResource::UniformType::Sam2;
-				u = std::make_shared<ResourceLib::TextureResource>();
 				break;
 
 			default:
 				t = ResourceLib::ShaderResource::UniformType::None;
-				u = nullptr;
 				printf("BAD UNIFORM TYPE");
 				break;
 			}
 
-			// Push type and (parsed) uniform name to uniform list.
-			sr->uniforms.push_back(
-				std::make_tuple(t, handleName, u, address, "")
-			);
+			// Uniforms in blocks have no location.
+			if (address < 0 || t == ResourceLib::ShaderResource::UniformType::None)
+				continue;
+
+			sr->AddUniform(t, uniformName, address);
+		}
+
+		// Route the shared blocks to their binding points, the shaders
+		// name them but may not carry binding qualifiers.
+		const std::pair<const char*, GLuint> blocks[] = {
+			{ "CameraBlock", CameraBinding },
+			{ "LightBlock", LightBinding },
+			{ "ObjectBlock", ObjectBinding }
+		};
+		for (size_t i = 0; i < 3; i++) {
+			GLuint index = glGetUniformBlockIndex(program, blocks[i].first);
+			if (index != GL_INVALID_INDEX)
+				glUniformBlockBinding(program, index, blocks[i].second);
+		}
+
+		// Samplers get fixed texture units, set once on the program.
+		GLState::UseProgram(program);
+		GLint unit = 0;
+		for (size_t i = 0; i < sr->uniforms.size(); i++) {
+			if (sr->uniforms[i].type == ResourceLib::ShaderResource::UniformType::Sam2) {
+				sr->uniformInts[sr->uniforms[i].offset] = unit;
+				glUniform1i(sr->uniforms[i].location, unit);
+				unit++;
+			}
+		}
+
+		// Replace the program of a reloaded shader, its attribute
+		// locations may have moved so the vertex arrays go with it.
+		GLObject* old = programs.Get(sr->program);
+		if (old != nullptr) {
+			ReleaseVertexArrays(sr->program);
+			glDeleteProgram(old->name);
+			programs.Remove(sr->program);
+
+			// Deleted names may be reused, drop the shadowed bindings.
+			GLState::Invalidate();
+			GLState::UseProgram(program);
+		}
+
+		GLObject obj;
+		obj.target = GL_PROGRAM;
+		obj.name = program;
+		sr->program = programs.Insert(obj);
+
+		// Build the instanced variant from the same source.
+		bool isVariant = std::find(sr->defines.begin(), sr->defines.end(), "INSTANCED") != sr->defines.end();
+		bool hasInstancing = false;
+		for (size_t i = 0; i < sr->shaders.size(); i++)
+			hasInstancing |= sr->shaders[i].second.find("INSTANCED") != std::string::npos;
+
+		if (!isVariant && hasInstancing) {
+			// Reuse the old variant so its program is replaced, not leaked.
+			if (sr->instanced == nullptr)
+				sr->instanced = std::make_shared<ResourceLib::ShaderResource>();
+			sr->instanced->filename = sr->filename;
+			sr->instanced->shaders = sr->shaders;
+			sr->instanced->defines = sr->defines;
+			sr->instanced->defines.push_back("INSTANCED");
+			sr->instanced->loaded = true;
+			UploadShaderResource(sr->instanced);
 		}
-		// Add shader handle to list tbh.
-		handles[sr->filename].first = GL_PROGRAM;
-		handles[sr->filename].second = program;
 	}
 
 	// Shader array.
@@ -176,46 +223,257 @@ void GG::ResourceHandler::UploadShaderResource(std::shared_ptr<ResourceLib::Shad
 
 void GG::ResourceHandler::UploadMeshResource(std::shared_ptr<ResourceLib::MeshResource> const& mr) {
 	if (mr->loaded) {
-		GLuint glhVBO;
-		glGenBuffers(1, &glhVBO);
-		glBindBuffer(GL_ARRAY_BUFFER, glhVBO);
-		glBufferData(
-			GL_ARRAY_BUFFER,
-			mr->data.size() * sizeof(float),
-			&mr->data[0],
-			GL_STATIC_DRAW
+		// Drop the ranges of a re-uploaded mesh.
+		ReleaseMeshResource(mr.get());
+
+		size_t stride = mr->attributes.empty() ? 0 : mr->attributes[0].stride;
+		if (stride == 0 || mr->GetVertexDataSize() == 0 || mr->GetIndexCount() == 0)
+			throw("Mesh resource '"+mr->filename+"' has no vertex layout\n");
+
+		size_t vertexCount = mr->GetVertexDataSize() / stride;
+		size_t indexCount = mr->GetIndexCount();
+
+		///////////////////////
+		// FIND VERTEX ARENA //
+		///////////////////////
+		std::string layout = LayoutKey(mr.get());
+		VertexArena* arena = nullptr;
+		for (size_t i = 0; i < vertexArenas.size(); i++) {
+			if (vertexArenas[i].layout == layout) {
+				arena = &vertexArenas[i];
+				break;
+			}
+		}
+
+		if (arena == nullptr) {
+			VertexArena created;
+			created.layout = layout;
+			created.stride = stride;
+			size_t capacity = std::max(vertexCount, (size_t)(1 << 16));
+			created.buffer = CreateArenaBuffer(GL_ARRAY_BUFFER, capacity * stride);
+			created.vertices.Reset(capacity);
+			vertexArenas.push_back(created);
+			arena = &vertexArenas.back();
+		}
+
+		// 16 bit indices get their own arena, a draw reads one index type.
+		size_t indexSize = mr->indexSize;
+		IndexArena* indexArena = nullptr;
+		for (size_t i = 0; i < indexArenas.size(); i++) {
+			if (indexArenas[i].indexSize == indexSize) {
+				indexArena = &indexArenas[i];
+				break;
+			}
+		}
+
+		if (indexArena == nullptr) {
+			IndexArena created;
+			created.indexSize = indexSize;
+			size_t capacity = std::max(indexCount, (size_t)(1 << 18));
+			created.buffer = CreateArenaBuffer(GL_ELEMENT_ARRAY_BUFFER, capacity * indexSize);
+			created.indices.Reset(capacity);
+			indexArenas.push_back(created);
+			indexArena = &indexArenas.back();
+		}
+
+		////////////////////////
+		// ALLOCATE, GROW     //
+		////////////////////////
+		size_t baseVertex = arena->vertices.Allocate(vertexCount);
+		if (baseVertex == ResourceLib::RangeAllocator::Invalid) {
+			size_t oldCapacity = arena->vertices.GetCapacity();
+			size_t newCapacity = std::max(oldCapacity * 2, oldCapacity + vertexCount);
+			GrowArenaBuffer(arena->buffer, oldCapacity * stride, newCapacity * stride);
+			arena->vertices.Grow(newCapacity);
+			baseVertex = arena->vertices.Allocate(vertexCount);
+		}
+
+		size_t firstIndex = indexArena->indices.Allocate(indexCount);
+		if (firstIndex == ResourceLib::RangeAllocator::Invalid) {
+			size_t oldCapacity = indexArena->indices.GetCapacity();
+			size_t newCapacity = std::max(oldCapacity * 2, oldCapacity + indexCount);
+			GrowArenaBuffer(indexArena->buffer, oldCapacity * indexSize, newCapacity * indexSize);
+			indexArena->indices.Grow(newCapacity);
+			firstIndex = indexArena->indices.Allocate(indexCount);
+		}
+
+		////////////////////////
+		// COPY INTO ARENAS   //
+		////////////////////////
+		// The copy target isn't vertex array state, unlike the element buffer.
+		// Cached meshes are read straight from their mapped pages.
+		GLState::BindBuffer(GL_COPY_WRITE_BUFFER, buffers.Get(arena->buffer)->name);
+		glBufferSubData(
+			GL_COPY_WRITE_BUFFER,
+			baseVertex * stride,
+			vertexCount * stride,
+			mr->GetVertexData()
 		);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-		handles[mr->filename + "_VBO"] = std::pair<GLenum, GLint>(GL_ARRAY_BUFFER, glhVBO);
-
-		GLuint glhIBO;
-		glGenBuffers(1, &glhIBO);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, glhIBO);
-		glBufferData(
-			GL_ELEMENT_ARRAY_BUFFER,
-			mr->indices.size() * sizeof(unsigned int),
-			&mr->indices[0],
-			GL_STATIC_DRAW
+
+		GLState::BindBuffer(GL_COPY_WRITE_BUFFER, buffers.Get(indexArena->buffer)->name);
+		glBufferSubData(
+			GL_COPY_WRITE_BUFFER,
+			firstIndex * indexSize,
+			indexCount * indexSize,
+			mr->GetIndexData()
 		);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-		handles[mr->filename + "_IBO"] = std::pair<GLenum, GLint>(GL_ELEMENT_ARRAY_BUFFER, glhIBO);
-		//mr->indicesIndex = handles.size() - 1;
+		mr->vbo = arena->buffer;
+		mr->ibo = indexArena->buffer;
+		mr->baseVertex = baseVertex;
+		mr->vertexCount = vertexCount;
+		mr->firstIndex = firstIndex;
+		mr->arenaIndexCount = indexCount;
 	}
 	else {
 		throw("Mesh resource '"+mr->filename+"' aint loded yo\n");
 	}
 }
 
+void GG::ResourceHandler::ReleaseMeshResource(ResourceLib::MeshResource* mr) {
+	if (!mr->vbo.IsSet())
+		return;
+
+	// Stale handles mean the arenas were cleared already.
+	if (buffers.Get(mr->vbo) != nullptr) {
+		for (size_t i = 0; i < vertexArenas.size(); i++) {
+			if (vertexArenas[i].buffer == mr->vbo)
+				vertexArenas[i].vertices.Free(mr->baseVertex, mr->vertexCount);
+		}
+	}
+	if (buffers.Get(mr->ibo) != nullptr) {
+		for (size_t i = 0; i < indexArenas.size(); i++) {
+			if (indexArenas[i].buffer == mr->ibo)
+				indexArenas[i].indices.Free(mr->firstIndex, mr->arenaIndexCount);
+		}
+	}
+
+	mr->vbo = ResourceLib::BufferHandle();
+	mr->ibo = ResourceLib::BufferHandle();
+	mr->vertexCount = 0;
+	mr->arenaIndexCount = 0;
+}
+
+std::string GG::ResourceHandler::LayoutKey(const ResourceLib::MeshResource* mr) {
+	std::string key;
+	for (size_t i = 0; i < mr->attributes.size(); i++) {
+		const ResourceLib::Attribute& a = mr->attributes[i];
+		key += a.name + ":" + std::to_string(a.length) + ":" + std::to_string(a.offset) + ":" + std::to_string(a.stride) +
+			":" + std::to_string((int)a.type) + (a.normalized ? "n;" : ";");
+	}
+	return key;
+}
+
+GLenum GG::ResourceHandler::AttributeType(ResourceLib::Attribute::Type type) {
+	switch (type) {
+	case ResourceLib::Attribute::Type::Half:
+		return GL_HALF_FLOAT;
+	case ResourceLib::Attribute::Type::Snorm16:
+	case ResourceLib::Attribute::Type::Octahedral:
+		return GL_SHORT;
+	case ResourceLib::Attribute::Type::Unorm8:
+		return GL_UNSIGNED_BYTE;
+	case ResourceLib::Attribute::Type::Snorm10:
+		return GL_INT_2_10_10_10_REV;
+	default:
+		return GL_FLOAT;
+	}
+}
+
+ResourceLib::BufferHandle GG::ResourceHandler::CreateArenaBuffer(GLenum target, size_t bytes) {
+	GLuint name;
+	glGenBuffers(1, &name);
+	GLState::BindBuffer(GL_COPY_WRITE_BUFFER, name);
+	glBufferData(GL_COPY_WRITE_BUFFER, bytes, nullptr, GL_STATIC_DRAW);
+
+	GLObject obj;
+	obj.target = target;
+	obj.name = name;
+	return buffers.Insert(obj);
+}
+
+void GG::ResourceHandler::GrowArenaBuffer(ResourceLib::BufferHandle buffer, size_t oldBytes, size_t newBytes) {
+	GLObject* obj = buffers.Get(buffer);
+
+	GLuint name;
+	glGenBuffers(1, &name);
+	GLState::BindBuffer(GL_COPY_WRITE_BUFFER, name);
+	glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_STATIC_DRAW);
+
+	GLState::BindBuffer(GL_COPY_READ_BUFFER, obj->name);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+
+	// Vertex arrays recorded the old name.
+	ReleaseVertexArrays(buffer);
+	glDeleteBuffers(1, &obj->name);
+	obj->name = name;
+	GLState::Invalidate();
+}
+
+void GG::ResourceHandler::BeginFrame() {
+	if (!frameData.IsValid()) {
+		GLint alignment;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		uniformAlignment = (size_t)alignment;
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		storageAlignment = (size_t)alignment;
+
+		frameData.Create(FrameDataSize);
+		if (!frameData.IsMapped())
+			printf("ARB_buffer_storage not supported, frame data is not persistently mapped.\n");
+	}
+
+	frameData.BeginFrame();
+	commandOffset = RingBuffer::Invalid;
+}
+
+void GG::ResourceHandler::EndFrame() {
+	frameData.EndFrame();
+}
+
+bool GG::ResourceHandler::StreamUniformBlock(GLuint binding, const void* data, size_t size) {
+	size_t offset = frameData.Write(data, size, uniformAlignment);
+	if (offset == RingBuffer::Invalid)
+		return false;
+
+	GLState::BindBufferRange(GL_UNIFORM_BUFFER, binding, frameData.GetBuffer(), offset, size);
+	return true;
+}
+
 void GG::ResourceHandler::SetCameraMatrices(const MathLib::Mat4& view, const MathLib::Mat4& projection) {
 	cameraView = view;
 	cameraProjection = projection;
+
+	CameraBlock block;
+	block.view = view;
+	block.projection = projection;
+	StreamUniformBlock(CameraBinding, &block, sizeof(CameraBlock));
+}
+
+void GG::ResourceHandler::UpdateLightBlock() {
+	LightBlock block;
+	for (size_t i = 0; i < 3; i++) {
+		block.position[i] = ResourceLib::LightNode::position[i];
+		block.color[i] = ResourceLib::LightNode::color[i];
+	}
+	for (size_t i = 0; i < 4; i++) {
+		block.ambient[i] = ResourceLib::LightNode::ambient[i];
+		block.specular[i] = ResourceLib::LightNode::specular[i];
+	}
+	block.power = ResourceLib::LightNode::power;
+	block.mode = ResourceLib::LightNode::mode;
+
+	StreamUniformBlock(LightBinding, &block, sizeof(LightBlock));
 }
 
 MathLib::Mat4 GG::ResourceHandler::cameraView = MathLib::Mat4::Identity;
 MathLib::Mat4 GG::ResourceHandler::cameraProjection = MathLib::Mat4::Identity;
 
+GG::RingBuffer GG::ResourceHandler::frameData;
+size_t GG::ResourceHandler::uniformAlignment = 256;
+size_t GG::ResourceHandler::storageAlignment = 256;
+size_t GG::ResourceHandler::commandOffset = GG::RingBuffer::Invalid;
+
 void GG::ResourceHandler::UploadTextureResource(std::shared_ptr<ResourceLib::TextureResource> const& tr) {
 	if (tr->loaded) {
 		// Create texture handle.
@@ -223,7 +481,7 @@ void GG::ResourceHandler::UploadTextureResource(std::shared_ptr<ResourceLib::Tex
 		// Generate texture handle.
 		glGenTextures(1, &glhTEX);
 		// Bind texture to do stuff.
-		glBindTexture(GL_TEXTURE_2D, glhTEX);
+		GLState::BindTexture(0, GL_TEXTURE_2D, glhTEX);
 		// Set scaling filtering for shrunk textures.
 		//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
@@ -237,31 +495,117 @@ void GG::ResourceHandler::UploadTextureResource(std::shared_ptr<ResourceLib::Tex
 
 		glGenerateMipmap(GL_TEXTURE_2D);
 
-		// Reset binding of texture
-		glBindTexture(GL_TEXTURE_2D, 0);
-
-		handles[tr->filename + "_TEX"] = std::pair<GLenum, GLint>(GL_TEXTURE_2D, glhTEX);
-		tr->bufferIndex = handles.size() - 1;
+		GLObject tex;
+		tex.target = GL_TEXTURE_2D;
+		tex.name = glhTEX;
+		tr->texture = textures.Insert(tex);
 		
 		tr->Unload();
 	}
 }
 
 
+GLuint GG::ResourceHandler::GetVertexArray(ResourceLib::MeshResource* mr, ResourceLib::ShaderHandle program) {
+	VertexArrayKey key;
+	key.vbo = mr->vbo;
+	key.ibo = mr->ibo;
+	key.program = program;
+
+	auto found = vertexArrays.find(key);
+	if (found != vertexArrays.end())
+		return found->second;
+
+	const GLObject* vbo = buffers.Get(mr->vbo);
+	const GLObject* ibo = buffers.Get(mr->ibo);
+	const GLObject* prog = programs.Get(program);
+	if (vbo == nullptr || ibo == nullptr || prog == nullptr)
+		return 0;
+
+	GLuint vao;
+	glGenVertexArrays(1, &vao);
+	GLState::BindVertexArray(vao);
+
+	// Attribute pointers capture the bound vertex buffer.
+	GLState::BindBuffer(vbo->target, vbo->name);
+	for (size_t i = 0; i < mr->attributes.size(); i++) {
+		GLint location = glGetAttribLocation(prog->name, mr->attributes[i].name.c_str());
+
+		// Not used by this program.
+		if (location < 0)
+			continue;
+
+		const ResourceLib::Attribute& a = mr->attributes[i];
+		glEnableVertexAttribArray((GLuint)location);
+		glVertexAttribPointer(
+			(GLuint)location,
+			(GLint)a.length,
+			AttributeType(a.type),
+			a.normalized ? GL_TRUE : GL_FALSE,
+			(GLsizei)a.stride,
+			(GLvoid*)a.offset
+		);
+	}
+
+	// The index buffer binding is part of the vertex array state.
+	GLState::BindBuffer(ibo->target, ibo->name);
+
+	vertexArrays[key] = vao;
+	return vao;
+}
+
+void GG::ResourceHandler::ReleaseVertexArrays(ResourceLib::ShaderHandle program) {
+	for (auto it = vertexArrays.begin(); it != vertexArrays.end(); ) {
+		if (it->first.program == program) {
+			glDeleteVertexArrays(1, &it->second);
+			it = vertexArrays.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+
+	// A deleted vertex array may have been the bound one.
+	GLState::Invalidate();
+}
+
+void GG::ResourceHandler::ReleaseVertexArrays(ResourceLib::BufferHandle buffer) {
+	for (auto it = vertexArrays.begin(); it != vertexArrays.end(); ) {
+		if (it->first.vbo == buffer || it->first.ibo == buffer) {
+			glDeleteVertexArrays(1, &it->second);
+			it = vertexArrays.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+
+	// A deleted vertex array may have been the bound one.
+	GLState::Invalidate();
+}
+
 void GG::ResourceHandler::DrawMeshTextureMatrix(ResourceLib::MeshResource* mr, ResourceLib::TextureResource* tr, ResourceLib::ShaderResource* sr, MathLib::Mat4* mat) {
 
+	// Uses the default vertex array, cached ones must not be modified.
+	GLState::BindVertexArray(0);
 
 	/////////////////
 	// BIND SHADER //
 	/////////////////
-	glUseProgram(handles[sr->filename].second);
+	const GLObject* program = programs.Get(sr->program);
+	const GLObject* vbo = buffers.Get(mr->vbo);
+	const GLObject* ibo = buffers.Get(mr->ibo);
+	const GLObject* tex = textures.Get(tr->texture);
+	if (program == nullptr || vbo == nullptr || ibo == nullptr || tex == nullptr)
+		return;
+
+	GLState::UseProgram(program->name);
 
 	////////////////////////
 	// BIND VERTEX BUFFER //
 	////////////////////////
 
 	// Bind the vertex buffer for this mesh.
-	glBindBuffer(handles[mr->filename + "_VBO"].first, handles[mr->filename + "_VBO"].second);
+	GLState::BindBuffer(vbo->target, vbo->name);
 	// Loop through each attribute and enable them.
 	for (size_t i = 0; i < mr->attributes.size(); i++) {
 
@@ -272,10 +616,11 @@ void GG::ResourceHandler::DrawMeshTextureMatrix(ResourceLib::MeshResource* mr, R
 		glVertexAttribPointer(
 			(GLuint)i,
 			(GLint)mr->attributes[i].length,
-			GL_FLOAT,
-			GL_TRUE,
-			(GLsizei)(mr->attributes[i].stride * sizeof(float)),
-			(GLvoid*)(mr->attributes[i].offset * sizeof(float))
+			AttributeType(mr->attributes[i].type),
+			mr->attributes[i].normalized ? GL_TRUE : GL_FALSE,
+			(GLsizei)mr->attributes[i].stride,
+			// The mesh starts baseVertex vertices into its arena.
+			(GLvoid*)(mr->baseVertex * mr->attributes[i].stride + mr->attributes[i].offset)
 		);
 	}
 
@@ -320,8 +665,7 @@ void GG::ResourceHandler::DrawMeshTextureMatrix(ResourceLib::MeshResource* mr, R
 	///////////////////
 
 	// Activate and bind texture.
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(handles[tr->filename + "_TEX"].first, handles[tr->filename + "_TEX"].second);
+	GLState::BindTexture(0, tex->target, tex->name);
 	// Give texture to uniform location 1 in shader.
 	glUniform1i(1, 0);
 
@@ -332,8 +676,8 @@ void GG::ResourceHandler::DrawMeshTextureMatrix(ResourceLib::MeshResource* mr, R
 	/////////////////////////////
 
 	// Additionally bind the index buffer.
-	glBindBuffer(handles[mr->filename + "_IBO"].first, handles[mr->filename + "_IBO"].second);
-	glDrawElements(GL_TRIANGLES, mr->indicesCount, GL_UNSIGNED_INT, (void*)0);
+	GLState::BindBuffer(ibo->target, ibo->name);
+	glDrawElements(GL_TRIANGLES, mr->GetLod(0).indexCount, IndexType(mr), (void*)(mr->firstIndex * mr->indexSize));
 
 
 	/////////////////////////////
@@ -341,251 +685,207 @@ void GG::ResourceHandler::DrawMeshTextureMatrix(ResourceLib::MeshResource* mr, R
 	/////////////////////////////
 
 	// Unbind index buffer.
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	// Unbind texture.
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::BindTexture(0, GL_TEXTURE_2D, 0);
 	// Unbind vertex buffer.
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 /**  */
 void GG::ResourceHandler::DrawGraphicsNode(ResourceLib::GraphicsNode* gn) {
+	ResourceLib::ShaderResource* sr = gn->GetShaderResource().get();
 
+	if (!BindProgram(sr))
+		return;
+	BindTextures(sr, gn->GetTextureResource().get());
+	DrawObject(gn);
+}
 
+bool GG::ResourceHandler::BindProgram(ResourceLib::ShaderResource* sr) {
 	/////////////////
 	// BIND SHADER //
 	/////////////////
-	if (handles[gn->GetShaderResource()->filename].first != GL_PROGRAM) {
+	const GLObject* programObject = programs.Get(sr->program);
+	if (programObject == nullptr) {
 		printf("Shader not valid.\n");
-		return;
-	}
-	GLint program = handles[gn->GetShaderResource()->filename].second;
-	glUseProgram(program);
-
-
-	///////////////////////////////////////
-	// CALCULATE AND SET SHADER UNIFORMS //
-	///////////////////////////////////////
-	auto uniSearch = [gn](std::string uniform) {
-		uniform = gn->GetShaderResource()->filename + uniform + std::to_string(handles[gn->GetShaderResource()->filename].second);
-		return std::find_if(
-			gn->GetShaderResource()->uniforms.begin(),
-			gn->GetShaderResource()->uniforms.end(),
-			[uniform](
-				const std::tuple<ResourceLib::ShaderResource::UniformType,
-				std::string, std::shared_ptr<void>,
-				int,
-				std::string>& a) { /*printf((*(std::string*)&std::get<1>(a)).c_str()); printf("\n");*/ return std::get<1>(a) == uniform; });
-	};
-
-	// Find pointer to uniform with the name projection.
-	auto iter = uniSearch("projection");
-	// Set the uniform.
-	if (iter != gn->GetShaderResource()->uniforms.end()) {
-		**(std::shared_ptr<MathLib::Mat4>*)&std::get<2>(*iter) =
-			GG::ResourceHandler::GetCameraProjection();
+		return false;
 	}
-
-	// Find pointer to uniform with the name projection.
-	iter = uniSearch("modelView");
-	// Set the uniform.		
-	if (iter != gn->GetShaderResource()->uniforms.end()) {
-		**(std::shared_ptr<MathLib::Mat4>*)&std::get<2>(*iter) =
-			GG::ResourceHandler::GetCameraView() * gn->transform.GetTransform();
+	GLState::UseProgram(programObject->name);
+
+	///////////////////////////
+	// SET SEMANTIC UNIFORMS //
+	///////////////////////////
+	// Only for shaders still using loose uniforms instead of the blocks.
+	typedef ResourceLib::ShaderResource::Semantic Semantic;
+	const int* semantic = sr->semanticLocations;
+
+	if (semantic[(size_t)Semantic::Projection] >= 0)
+		glUniformMatrix4fv(semantic[(size_t)Semantic::Projection], 1, GL_TRUE, cameraProjection.Data());
+
+	if (semantic[(size_t)Semantic::LightPos] >= 0)
+		glUniform3fv(semantic[(size_t)Semantic::LightPos], 1, ResourceLib::LightNode::position.Data());
+	if (semantic[(size_t)Semantic::LightColor] >= 0)
+		glUniform3fv(semantic[(size_t)Semantic::LightColor], 1, ResourceLib::LightNode::color.Data());
+	if (semantic[(size_t)Semantic::LightPower] >= 0)
+		glUniform1f(semantic[(size_t)Semantic::LightPower], ResourceLib::LightNode::power);
+	if (semantic[(size_t)Semantic::LightAmbi] >= 0)
+		glUniform3fv(semantic[(size_t)Semantic::LightAmbi], 1, ResourceLib::LightNode::ambient.Data());
+	if (semantic[(size_t)Semantic::LightSpec] >= 0)
+		glUniform3fv(semantic[(size_t)Semantic::LightSpec], 1, ResourceLib::LightNode::specular.Data());
+	if (semantic[(size_t)Semantic::Mode] >= 0)
+		glUniform1i(semantic[(size_t)Semantic::Mode], ResourceLib::LightNode::mode);
+
+	/////////////////////////
+	// SET OTHER UNIFORMS  //
+	/////////////////////////
+	for (size_t i = 0; i < sr->uniforms.size(); i++) {
+		const ResourceLib::ShaderResource::UniformBinding& u = sr->uniforms[i];
+		const float* f = sr->uniformFloats.data() + u.offset;
+
+		switch (u.type) {
+		case ResourceLib::ShaderResource::UniformType::Mat4:
+			glUniformMatrix4fv(u.location, 1, GL_TRUE, f);
+			break;
+		case ResourceLib::ShaderResource::UniformType::Vec4:
+			glUniform4fv(u.location, 1, f);
+			break;
+		case ResourceLib::ShaderResource::UniformType::Vec3:
+			glUniform3fv(u.location, 1, f);
+			break;
+		case ResourceLib::ShaderResource::UniformType::Vec2:
+			glUniform2fv(u.location, 1, f);
+			break;
+		case ResourceLib::ShaderResource::UniformType::Float:
+			glUniform1f(u.location, *f);
+			break;
+		case ResourceLib::ShaderResource::UniformType::Int:
+			glUniform1i(u.location, sr->uniformInts[u.offset]);
+			break;
+		default:
+			// Samplers are bound by BindTextures().
+			break;
+		}
 	}
 
-	iter = uniSearch("normalMat");
-	if (iter != gn->GetShaderResource()->uniforms.end()) {
-
-		// Try and invert model matrix.
-		MathLib::Mat4 inverted = MathLib::Mat4::Identity;
-
-		if (!MathLib::Mat4::Inverse(gn->transform.GetTransform(), &inverted))
-			printf("dicks");
+	return true;
+}
 
-		// Set uniform to the transposed inverted matrix.
-		**(std::shared_ptr<MathLib::Mat4>*)&std::get<2>(*iter) =
-			MathLib::Mat4::Transpose(inverted);
-	}
+void GG::ResourceHandler::BindTextures(ResourceLib::ShaderResource* sr, ResourceLib::TextureResource* tr) {
+	const GLObject* texObject = (tr != nullptr) ? textures.Get(tr->texture) : nullptr;
+	if (texObject == nullptr)
+		return;
 
-	iter = uniSearch("light.Pos");
-	if (iter != gn->GetShaderResource()->uniforms.end()) {
-		**(std::shared_ptr<MathLib::Vec4>*)&std::get<2>(*iter) =
-			ResourceLib::LightNode::position;
-	}
-	iter = uniSearch("light.Color");
-	if (iter != gn->GetShaderResource()->uniforms.end()) {
-		**(std::shared_ptr<MathLib::Vec4>*)&std::get<2>(*iter) =
-			ResourceLib::LightNode::color;
-	}
-	iter = uniSearch("light.Power");
-	if (iter != gn->GetShaderResource()->uniforms.end()) {
-		**(std::shared_ptr<float>*)&std::get<2>(*iter) =
-			ResourceLib::LightNode::power;
-	}
-	iter = uniSearch("light.Ambi");
-	if (iter != gn->GetShaderResource()->uniforms.end()) {
-		**(std::shared_ptr<MathLib::Vec4>*)&std::get<2>(*iter) =
-			ResourceLib::LightNode::ambient;
-	}
-	iter = uniSearch("light.Spec");
-	if (iter != gn->GetShaderResource()->uniforms.end()) {
-		**(std::shared_ptr<MathLib::Vec4>*)&std::get<2>(*iter) =
-			ResourceLib::LightNode::specular;
-	}
-	iter = uniSearch("mode");
-	if (iter != gn->GetShaderResource()->uniforms.end()) {
-		**(std::shared_ptr<int>*)&std::get<2>(*iter) =
-			ResourceLib::LightNode::mode;
+	// Units were assigned at upload, nodes only carry one texture.
+	for (size_t i = 0; i < sr->uniforms.size(); i++) {
+		if (sr->uniforms[i].type == ResourceLib::ShaderResource::UniformType::Sam2)
+			GLState::BindTexture(sr->uniformInts[sr->uniforms[i].offset], texObject->target, texObject->name);
 	}
+}
 
+void GG::ResourceHandler::DrawObject(ResourceLib::GraphicsNode* gn, size_t lod) {
+	ResourceLib::MeshResource* mr = gn->GetMeshResource().get();
+	ResourceLib::ShaderResource* sr = gn->GetShaderResource().get();
 
-	////////////////////////
-	// BIND VERTEX BUFFER //
-	////////////////////////
-	// Bind the vertex buffer for this mesh.
-	glBindBuffer(handles[gn->GetMeshResource()->filename + "_VBO"].first, handles[gn->GetMeshResource()->filename + "_VBO"].second);
-	// Loop through each attribute and enable them.
-	for (size_t i = 0; i < gn->GetMeshResource()->attributes.size(); i++) {
+	// Vertex and index buffers with their attribute layout.
+	GLuint vao = GetVertexArray(mr, sr->program);
+	if (vao == 0) {
+		printf("Mesh not uploaded.\n");
+		return;
+	}
 
-		GLint location = glGetAttribLocation(program, gn->GetMeshResource()->attributes[i].name.c_str());
+	///////////////////////////
+	// UPDATE OBJECT BLOCK   //
+	///////////////////////////
+	// Camera and light blocks are shared, this is the only per draw upload.
+	// Each draw gets its own range of the frame data, nothing waits on
+	// the previous draw's block.
+	ObjectBlock object;
+	object.model = gn->GetWorldMatrix();
+	object.normalMat = gn->GetNormalMatrix();
+	if (!StreamUniformBlock(ObjectBinding, &object, sizeof(ObjectBlock)))
+		return;
 
-		//printf("")
+	// Per object loose uniforms.
+	typedef ResourceLib::ShaderResource::Semantic Semantic;
+	const int* semantic = sr->semanticLocations;
 
-		// Enable attribute i.
-		glEnableVertexAttribArray(location);
-
-		// "bind" attribute.
-		glVertexAttribPointer(
-			(GLuint)location,
-			(GLint)gn->GetMeshResource()->attributes[i].length,
-			GL_FLOAT,
-			GL_TRUE,
-			(GLsizei)(gn->GetMeshResource()->attributes[i].stride * sizeof(float)),
-			(GLvoid*)(gn->GetMeshResource()->attributes[i].offset * sizeof(float))
-		);
+	if (semantic[(size_t)Semantic::ModelView] >= 0) {
+		MathLib::Mat4 modelView = cameraView * gn->GetWorldMatrix();
+		glUniformMatrix4fv(semantic[(size_t)Semantic::ModelView], 1, GL_TRUE, modelView.Data());
 	}
 
-	//////////////////
-	// SET UNIFORMS //
-	//////////////////
-	unsigned int tex = 0;
-	// Loop through uniforms.
-	for (size_t i = 0; i < gn->GetShaderResource()->uniforms.size(); i++) {
+	// Cached by the transform pass, only rebuilt when the node moved.
+	if (semantic[(size_t)Semantic::NormalMat] >= 0)
+		glUniformMatrix4fv(semantic[(size_t)Semantic::NormalMat], 1, GL_TRUE, gn->GetNormalMatrix().Data());
 
-		// Pointer to shared_ptr<void>, dereference to resource with **
-		void* sp = (void*)&std::get<2>(gn->GetShaderResource()->uniforms[i]);
+	/////////////////////////////
+	// DRAW USING INDEX BUFFER //
+	/////////////////////////////
 
-		// Uniform type.
-		ResourceLib::ShaderResource::UniformType ut = *(ResourceLib::ShaderResource::UniformType*) & std::get<0>(gn->GetShaderResource()->uniforms[i]);
+	// The vertex array holds attributes and index buffer, nothing to unbind.
+	ResourceLib::MeshResource::Lod level = mr->GetLod(lod);
+	GLState::BindVertexArray(vao);
+	glDrawElementsBaseVertex(
+		GL_TRIANGLES,
+		(GLsizei)level.indexCount,
+		IndexType(mr),
+		(void*)((mr->firstIndex + level.indexOffset) * mr->indexSize),
+		(GLint)mr->baseVertex
+	);
+}
 
-		// Uniform name.
-		std::string un = *(std::string*) & std::get<1>(gn->GetShaderResource()->uniforms[i]);
+void GG::ResourceHandler::UploadDraws(const ObjectBlock* instances, size_t instanceCount, const DrawCommand* commands, size_t commandCount) {
+	commandOffset = RingBuffer::Invalid;
+	if (commandCount == 0 || instanceCount == 0)
+		return;
 
-		// Uniform location.
-		GLint uniformLocation = *(GLint*)&std::get<3>(gn->GetShaderResource()->uniforms[i]);
+	GLuint buffer = frameData.GetBuffer();
+	size_t instanceBytes = instanceCount * sizeof(ObjectBlock);
+	size_t instanceOffset = frameData.Write(instances, instanceBytes, storageAlignment);
 
-		// Switch the type of the uniform union.
-		if (ut == ResourceLib::ShaderResource::UniformType::Mat4) {
-			/*MathLib::Mat4 culvert = MathLib::Mat4::Identity;// = (cameraMatrix * gn->transform.GetTransform());
+	// Storage ranges are the stricter alignment, indirect offsets only need 4.
+	size_t commandBytes = commandCount * sizeof(DrawCommand);
+	size_t offset = frameData.Write(commands, commandBytes, storageAlignment);
+	if (instanceOffset == RingBuffer::Invalid || offset == RingBuffer::Invalid) {
+		printf("Frame data full, indirect draws skipped this frame.\n");
+		return;
+	}
+	commandOffset = offset;
 
-			MathLib::Mat4 m = **(std::shared_ptr<MathLib::Mat4>*)sp;
+	GLState::BindBufferRange(GL_SHADER_STORAGE_BUFFER, InstanceBinding, buffer, instanceOffset, instanceBytes);
+	// The commands are also the per draw data, indexed by gl_DrawID.
+	GLState::BindBufferRange(GL_SHADER_STORAGE_BUFFER, DrawBinding, buffer, commandOffset, commandBytes);
+}
 
-			if (un == "projection") {
-				culvert = cameraProjection;
-			}
-			else if (un == "modelView") {
-				culvert = cameraView * gn->transform.GetTransform();
-			}
-			else if (un == "normalMat") {
-				MathLib::Mat4 inverted;
-				if (MathLib::Mat4::Inverse(gn->transform.GetTransform(), &inverted)) {
-					culvert = MathLib::Mat4::Transpose(inverted);
-				};
-    			//mat4 normalMat = transpose(inverse(model))
-			}*/
-
-			MathLib::Mat4 culvert = **(std::shared_ptr<MathLib::Mat4>*)sp;
-
-			// Bind uniform to shader.
-			glUniformMatrix4fv(
-				uniformLocation, // i when looping.
-				1,
-				GL_TRUE,
-				// &** address of double dereferenced double pointer.
-				(GLfloat*)&culvert // PV*M = MVP
-			);
-		}
-		else if (ut == ResourceLib::ShaderResource::UniformType::Int) {
-			int val = **(std::shared_ptr<int>*)sp;
-			glUniform1i(uniformLocation, val);
-		}
-		else if (ut == ResourceLib::ShaderResource::UniformType::Float) {
-			// Bind uniform to shader.
-			float f = **(std::shared_ptr<float>*)sp;
-			glUniform1f(uniformLocation, f);
-		}
-		else if (ut == ResourceLib::ShaderResource::UniformType::Vec2) {
-			// Bind uniform to shader.
-			MathLib::Vec4 v = **(std::shared_ptr<MathLib::Vec4>*)sp;
-			glUniform2f(uniformLocation, v[0], v[1]);
-		}
-		else if (ut == ResourceLib::ShaderResource::UniformType::Vec3) {
-			// Bind uniform to shader.
-			MathLib::Vec4 v = **(std::shared_ptr<MathLib::Vec4>*)sp;
-			glUniform3f(uniformLocation, v[0], v[1], v[2]);
-		}
-		else if (ut == ResourceLib::ShaderResource::UniformType::Vec4) {
-			// Bind uniform to shader.
-			MathLib::Vec4 v = **(std::shared_ptr<MathLib::Vec4>*)sp;
-			glUniform4f(uniformLocation, v[0], v[1], v[2], v[3]);
-		}
-		else if (ut == ResourceLib::ShaderResource::UniformType::Sam2) {
-			if (gn->GetTextureResource() != nullptr) {
-				/*glActiveTexture(GL_TEXTURE0 + tex);
-				glBindTexture(GL_TEXTURE_2D, textureHandle);
-				glUniform1i(1, tex);*/
-
-				//std::string uniformName = *(std::string*)&std::get<1>(gn->sr->uniforms[i]);
-				//std::string texName = (**(std::shared_ptr<ResourceLib::TextureResource>*)sp).filename;
-
-				// Since we don't have other textures we can ignore this at all times tbh.
-				//if (uniformName == "wakeMeUpInside") {
-					// Activate and bind texture.
-					glActiveTexture(GL_TEXTURE0 + tex);
-					glBindTexture(handles[gn->GetTextureResource()->filename + "_TEX"].first, handles[gn->GetTextureResource()->filename + "_TEX"].second);
-					//glBindTexture(handles[(**(std::shared_ptr<ResourceLib::TextureResource>*)sp).filename + "_TEX"].first, handles[(**(std::shared_ptr<ResourceLib::TextureResource>*)sp).filename + "_TEX"].second);
-					// Give texture to uniform location 1 in shader.
-					glUniform1i(uniformLocation, tex);
-				//}
-
-				tex++;
-			}
-		}
-		else if (ut == ResourceLib::ShaderResource::UniformType::Lights) {
+void GG::ResourceHandler::DrawIndirect(ResourceLib::ShaderResource* sr, ResourceLib::MeshResource* mr, size_t firstCommand, size_t commandCount) {
+	if (commandOffset == RingBuffer::Invalid)
+		return;
 
-		}
+	GLuint vao = GetVertexArray(mr, sr->program);
+	if (vao == 0) {
+		printf("Mesh not uploaded.\n");
+		return;
 	}
 
-	/////////////////////////////
-	// DRAW USING INDEX BUFFER //
-	/////////////////////////////
-
-	// Additionally bind the index buffer.
-	glBindBuffer(handles[gn->GetMeshResource()->filename + "_IBO"].first, handles[gn->GetMeshResource()->filename + "_IBO"].second);
-	glDrawElements(GL_TRIANGLES, gn->GetMeshResource()->indicesCount, GL_UNSIGNED_INT, (void*)0);
-
+	GLState::BindVertexArray(vao);
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, frameData.GetBuffer());
 
-	/////////////////////////////
-	// UNBIND BUFFERS/TEXTURES //
-	/////////////////////////////
+	GLint drawBase = sr->semanticLocations[(size_t)ResourceLib::ShaderResource::Semantic::DrawBase];
 
-	// Unbind index buffer.
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-	// Unbind texture.
-	glBindTexture(GL_TEXTURE_2D, 0);
-	// Unbind vertex buffer.
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	// gl_DrawID needs the extension, otherwise it stays 0 and drawBase walks.
+	if (GLEW_ARB_shader_draw_parameters) {
+		if (drawBase >= 0)
+			glUniform1i(drawBase, (GLint)firstCommand);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, IndexType(mr), (void*)(commandOffset + firstCommand * sizeof(DrawCommand)), (GLsizei)commandCount, 0);
+	}
+	else {
+		for (size_t i = firstCommand; i < firstCommand + commandCount; i++) {
+			if (drawBase >= 0)
+				glUniform1i(drawBase, (GLint)i);
+			glDrawElementsIndirect(GL_TRIANGLES, IndexType(mr), (void*)(commandOffset + i * sizeof(DrawCommand)));
+		}
+	}
 }
 
 
@@ -598,23 +898,40 @@ MathLib::Mat4 GG::ResourceHandler::GetCameraView() {
 }
 
 void GG::ResourceHandler::GPUClean() {
-	/*for (size_t i = 0; i < handles.size(); i++) {
-		if (handles[i].handle != 0) {
-			switch (handles[i].type) {
-			case GLHandle::Type::VBO:
-			case GLHandle::Type::IBO:
-				glDeleteBuffers(1, &handles[i].handle);
-				break;
-			case GLHandle::Type::TEX:
-				glDeleteTextures(1, &handles[i].handle);
-				break;
-			}
-		}
-	}*/
-	// Also zero out the vector when done.
-	handles.clear();
-	//handles.shrink_to_fit();
+	// Waits for the GPU to finish with the last frames.
+	frameData.Destroy();
+	commandOffset = RingBuffer::Invalid;
+
+	GLState::BindVertexArray(0);
+	GLState::UseProgram(0);
+	for (auto it = vertexArrays.begin(); it != vertexArrays.end(); it++)
+		glDeleteVertexArrays(1, &it->second);
+	vertexArrays.clear();
+
+	programs.ForEach([](GLObject& obj) { glDeleteProgram(obj.name); });
+	buffers.ForEach([](GLObject& obj) { glDeleteBuffers(1, &obj.name); });
+	textures.ForEach([](GLObject& obj) { glDeleteTextures(1, &obj.name); });
+
+	// Also invalidate every handle when done.
+	programs.Clear();
+	buffers.Clear();
+	textures.Clear();
+
+	// The arena buffers went with the buffer map.
+	vertexArenas.clear();
+	indexArenas.clear();
+
+	GLState::Invalidate();
 }
 
-// Initialize map.
-std::map<std::string, std::pair<GLenum, GLint>> GG::ResourceHandler::handles = std::map<std::string, std::pair<GLenum, GLint>>();
\ No newline at end of file
+// Initialize slot maps.
+ResourceLib::SlotMap<GG::ResourceHandler::GLObject, ResourceLib::ShaderTag> GG::ResourceHandler::programs;
+ResourceLib::SlotMap<GG::ResourceHandler::GLObject, ResourceLib::BufferTag> GG::ResourceHandler::buffers;
+ResourceLib::SlotMap<GG::ResourceHandler::GLObject, ResourceLib::TextureTag> GG::ResourceHandler::textures;
+
+// Initialize mesh arenas.
+std::vector<GG::ResourceHandler::VertexArena> GG::ResourceHandler::vertexArenas;
+std::vector<GG::ResourceHandler::IndexArena> GG::ResourceHandler::indexArenas;
+
+// Initialize vertex array cache.
+std::unordered_map<GG::ResourceHandler::VertexArrayKey, GLuint, GG::ResourceHandler::VertexArrayKeyHash> GG::ResourceHandler::vertexArrays;
\ No newline at end of file
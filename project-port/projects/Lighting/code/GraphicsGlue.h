@@ -9,61 +9,274 @@
 //#include "config.h"
 #include "exampleapp.h"
 
-#include <map>
+#include "SlotMap.h"
+#include "RangeAllocator.h"
+#include "RingBuffer.h"
+
+#include <unordered_map>
 
 namespace GG {
 
 	class ResourceHandler {
 	public:
-		/** OpenGL specific handle for unloading resources when needed. */
-		struct GLHandle {
-			/** The resource type on the GPU. */
-			enum class Type {
-				VBO,
-				//VAO,
-				IBO,
-				TEX,
-				SHADER
-			};
-			/** The type of this GL handle. */
-			Type type;
-			/** The GPU buffer/sampler on the GPU. */
-			GLuint handle;
+		/** An OpenGL object name and the target it binds to. */
+		struct GLObject {
+			/** Bind target, GL_PROGRAM for shader programs. */
+			GLenum target = 0;
+			/** The buffer/texture/program name on the GPU. */
+			GLuint name = 0;
+		};
+
+		/** Linked shader programs. */
+		static ResourceLib::SlotMap<GLObject, ResourceLib::ShaderTag> programs;
+		/** Vertex and index buffers. */
+		static ResourceLib::SlotMap<GLObject, ResourceLib::BufferTag> buffers;
+		/** Textures. */
+		static ResourceLib::SlotMap<GLObject, ResourceLib::TextureTag> textures;
+
+		/**
+		 * Identifies the vertex array of a mesh drawn with a program.
+		 *
+		 * Attribute locations come from the program and the layout from the
+		 * mesh buffers, so the three handles fully describe the bindings.
+		 */
+		struct VertexArrayKey {
+			ResourceLib::BufferHandle vbo;
+			ResourceLib::BufferHandle ibo;
+			ResourceLib::ShaderHandle program;
+
+			bool operator == (const VertexArrayKey& other) const {
+				return vbo == other.vbo && ibo == other.ibo && program == other.program;
+			}
+		};
+
+		/** Hash for VertexArrayKey. */
+		struct VertexArrayKeyHash {
+			size_t operator () (const VertexArrayKey& k) const {
+				uint64_t h = ((uint64_t)k.vbo.index << 32) ^ k.vbo.generation;
+				h = h * 0x9E3779B97F4A7C15ull ^ (((uint64_t)k.ibo.index << 32) ^ k.ibo.generation);
+				h = h * 0x9E3779B97F4A7C15ull ^ (((uint64_t)k.program.index << 32) ^ k.program.generation);
+				return (size_t)(h ^ (h >> 29));
+			}
+		};
+
+		/** Vertex array objects built on first draw of a mesh/program pair. */
+		static std::unordered_map<VertexArrayKey, GLuint, VertexArrayKeyHash> vertexArrays;
+
+		/**
+		 * Binding points of the shared uniform blocks.
+		 *
+		 * Starts at 1, NanoVG keeps its fragment block on binding 0.
+		 */
+		enum UniformBlockBinding : GLuint {
+			CameraBinding = 1,
+			LightBinding = 2,
+			ObjectBinding = 3
 		};
 
-		/** The vector of opengl handles. */
-		static std::map<std::string, std::pair<GLenum, GLint>> handles;
+		/** std140 CameraBlock, written once per frame. Matrices are row_major. */
+		struct CameraBlock {
+			MathLib::Mat4 view;
+			MathLib::Mat4 projection;
+		};
+
+		/** std140 LightBlock, written once per frame from LightNode. */
+		struct LightBlock {
+			float position[3];
+			float power;
+			float color[3];
+			int mode;
+			float ambient[4];
+			float specular[4];
+		};
+
+		/** Binding points of shader storage blocks. */
+		enum StorageBlockBinding : GLuint {
+			InstanceBinding = 0,
+			DrawBinding = 1
+		};
+
+		/**
+		 * A glMultiDrawElementsIndirect command, laid out as GL reads it.
+		 *
+		 * The command buffer doubles as the per draw storage block, shaders
+		 * read baseInstance of command gl_DrawID to find their instances.
+		 */
+		struct DrawCommand {
+			GLuint count;
+			GLuint instanceCount;
+			GLuint firstIndex;
+			GLint baseVertex;
+			GLuint baseInstance;
+		};
+
+		/** A large vertex buffer shared by every mesh with the same attribute layout. */
+		struct VertexArena {
+			/** Attribute names, lengths, offsets and types, see LayoutKey(). */
+			std::string layout;
+			/** Bytes per vertex. */
+			size_t stride = 0;
+			/** The buffer, its name changes when it grows but the handle stays. */
+			ResourceLib::BufferHandle buffer;
+			/** Vertex ranges of the meshes. */
+			ResourceLib::RangeAllocator vertices;
+		};
+
+		/** A large index buffer shared by every mesh with the same index size. */
+		struct IndexArena {
+			/** Bytes per index, 2 or 4. */
+			size_t indexSize = 0;
+			/** The buffer, its name changes when it grows but the handle stays. */
+			ResourceLib::BufferHandle buffer;
+			/** Index ranges of the meshes. */
+			ResourceLib::RangeAllocator indices;
+		};
+
+		/** Vertex arenas, one per attribute layout. */
+		static std::vector<VertexArena> vertexArenas;
+		/** Index arenas, one per index size. */
+		static std::vector<IndexArena> indexArenas;
+
+		/**
+		 * std140 ObjectBlock, written before each draw. Matrices are row_major.
+		 * Also the std430 element of the instance buffer, same layout.
+		 */
+		struct ObjectBlock {
+			MathLib::Mat4 model;
+			MathLib::Mat4 normalMat;
+		};
 
 		/** Uploads a shader to the GPU and Unloads it from the CPU. */
 		static void UploadShaderResource(std::shared_ptr<ResourceLib::ShaderResource> const& sr, bool unloadOnload = true);
 
-		/** Uploads a mesh to the GPU and Unloads it from the CPU. */
+		/** Places a mesh in the vertex and index arenas. */
 		static void UploadMeshResource(std::shared_ptr<ResourceLib::MeshResource> const& mr);
 
+		/** Returns a mesh's arena ranges, its handles become unset. */
+		static void ReleaseMeshResource(ResourceLib::MeshResource* mr);
+
 		/** Uploads a texture to the GPU and unloads it from the CPU */
 		static void UploadTextureResource(std::shared_ptr<ResourceLib::TextureResource> const& tr);
 
-		/** Sets the camera matrix to be used when drawing objects. */
+		/**
+		 * Starts a frame of streamed data, call before SetCameraMatrices().
+		 *
+		 * Waits if the GPU is still reading the frame data from three
+		 * frames ago, see GetFrameData() for how long.
+		 */
+		static void BeginFrame();
+
+		/** Fences the frame's streamed data, call after the last draw. */
+		static void EndFrame();
+
+		/** The ring holding this frame's uniform blocks, instances and commands. */
+		static const RingBuffer& GetFrameData() {
+			return frameData;
+		}
+
+		/** Sets the camera matrices and uploads them to the camera block. */
 		static void SetCameraMatrices(const MathLib::Mat4& view, const MathLib::Mat4& projection);
 
+		/** Uploads the LightNode parameters to the light block, once per frame. */
+		static void UpdateLightBlock();
+
 		/** Draws a textured mesh multiplied with a matrix. */
 		static void DrawMeshTextureMatrix(ResourceLib::MeshResource* mr, ResourceLib::TextureResource* tr, ResourceLib::ShaderResource* sr, MathLib::Mat4* mat);
 
 		/** Draws a graphical object using a shader. */
 		static void DrawGraphicsNode(ResourceLib::GraphicsNode* gn);
 
+		// DrawGraphicsNode() in steps, so a sorted queue can skip the
+		// program and texture steps while consecutive draws share them.
+
+		/** Binds a program and sets its per frame uniforms, false if not uploaded. */
+		static bool BindProgram(ResourceLib::ShaderResource* sr);
+
+		/** Binds a texture to every sampler of a bound program. */
+		static void BindTextures(ResourceLib::ShaderResource* sr, ResourceLib::TextureResource* tr);
+
+		/** Uploads the object block and draws a level of a node's mesh with the bound program. */
+		static void DrawObject(ResourceLib::GraphicsNode* gn, size_t lod = 0);
+
+		/**
+		 * Streams the frame's instances and indirect commands.
+		 *
+		 * Call once per frame before DrawIndirect(), commands refer to
+		 * instances through baseInstance.
+		 */
+		static void UploadDraws(const ObjectBlock* instances, size_t instanceCount, const DrawCommand* commands, size_t commandCount);
+
+		/**
+		 * Issues uploaded commands with the bound instanced program.
+		 *
+		 * All commands must draw meshes from the same arenas as mr. With
+		 * ARB_shader_draw_parameters this is one glMultiDrawElementsIndirect,
+		 * otherwise one indirect draw per command.
+		 */
+		static void DrawIndirect(ResourceLib::ShaderResource* sr, ResourceLib::MeshResource* mr, size_t firstCommand, size_t commandCount);
+
 		/** Returns the camera projection matrix. */
 		static MathLib::Mat4 GetCameraProjection();
 
 		/** Returns the camera view matrix. */
 		static MathLib::Mat4 GetCameraView();
 
-		/** Removes all GL handles from the internal list of handles, which should cause garbage collector to do its thing. */
+		/** Deletes every GL object that was uploaded and invalidates all handles. */
 		static void GPUClean();
 	private:
+		/**
+		 * Returns the vertex array for a mesh drawn with a program.
+		 *
+		 * Built once with the attribute pointers and index buffer recorded,
+		 * so a draw is a single bind. Returns 0 if the mesh isn't uploaded.
+		 */
+		static GLuint GetVertexArray(ResourceLib::MeshResource* mr, ResourceLib::ShaderHandle program);
+
+		/** Deletes every cached vertex array using a program. */
+		static void ReleaseVertexArrays(ResourceLib::ShaderHandle program);
+
+		/** Deletes every cached vertex array using a buffer. */
+		static void ReleaseVertexArrays(ResourceLib::BufferHandle buffer);
+
+		/** Writes a uniform block to the frame data and binds it, false if out of room. */
+		static bool StreamUniformBlock(GLuint binding, const void* data, size_t size);
+
+		/** Per frame uniform blocks, instances and indirect commands. */
+		static RingBuffer frameData;
+		/** Bytes per frame the ring starts with, it doubles when a frame runs out. */
+		static const size_t FrameDataSize = 1 << 22;
+		/** Offset alignment of uniform block ranges. */
+		static size_t uniformAlignment;
+		/** Offset alignment of shader storage ranges. */
+		static size_t storageAlignment;
+		/** Offset of this frame's commands in frameData, RingBuffer::Invalid if none. */
+		static size_t commandOffset;
+
+		/** Attribute layout of a mesh as a string, meshes with equal keys share an arena. */
+		static std::string LayoutKey(const ResourceLib::MeshResource* mr);
+
+		/** GL type of an attribute type. */
+		static GLenum AttributeType(ResourceLib::Attribute::Type type);
+
+		/** GL type of a mesh's indices. */
+		static GLenum IndexType(const ResourceLib::MeshResource* mr) {
+			return mr->indexSize == sizeof(GLushort) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		}
+
+		/** Creates an arena buffer of a size in bytes. */
+		static ResourceLib::BufferHandle CreateArenaBuffer(GLenum target, size_t bytes);
+
+		/** Moves an arena buffer into a larger one, keeping its handle. */
+		static void GrowArenaBuffer(ResourceLib::BufferHandle buffer, size_t oldBytes, size_t newBytes);
 
 		static MathLib::Mat4 cameraView;
 		static MathLib::Mat4 cameraProjection;
 	};
 
+	// Must match the std140 layouts in the shaders.
+	static_assert(sizeof(ResourceHandler::CameraBlock) == 128, "CameraBlock must be two mat4.");
+	static_assert(sizeof(ResourceHandler::LightBlock) == 64, "LightBlock must match std140.");
+	static_assert(sizeof(ResourceHandler::ObjectBlock) == 128, "ObjectBlock must be two mat4.");
+	static_assert(sizeof(ResourceHandler::DrawCommand) == 20, "DrawCommand must match the GL indirect layout.");
+
 }
\ No newline at end of file
@@ -1,4 +1,53 @@
 #include "GraphicsNode.h"
 
-// Initialize map.
-std::map<ResourceLib::GraphicsNode*, bool> ResourceLib::GraphicsNode::activeGraphicsNodes = std::map<ResourceLib::GraphicsNode*, bool>();
+// Initialize scene.
+ResourceLib::SceneStore ResourceLib::GraphicsNode::scene = ResourceLib::SceneStore();
+
+// Initialize dirty list.
+std::vector<ResourceLib::GraphicsNode*> ResourceLib::GraphicsNode::dirtyNodes = std::vector<ResourceLib::GraphicsNode*>();
+
+void ResourceLib::GraphicsNode::UpdateTransforms() {
+	if (dirtyNodes.empty())
+		return;
+
+	// Parents before children, so each dirty subtree is walked once.
+	std::sort(dirtyNodes.begin(), dirtyNodes.end(), [](const GraphicsNode* a, const GraphicsNode* b) {
+		return a->depth < b->depth;
+	});
+
+	for (size_t i = 0; i < dirtyNodes.size(); i++) {
+		// Already handled as part of a dirty ancestor.
+		if (dirtyNodes[i]->queued)
+			dirtyNodes[i]->UpdateSubtree();
+	}
+
+	dirtyNodes.clear();
+}
+
+void ResourceLib::GraphicsNode::UpdateSubtree() {
+	if (localDirty) {
+		localMatrix = transform.GetTransform();
+		localDirty = false;
+	}
+
+	if (parent != nullptr)
+		worldMatrix = parent->worldMatrix * localMatrix;
+	else
+		worldMatrix = localMatrix;
+
+	if (!MathLib::Mat4::InverseTranspose3x3(worldMatrix, &normalMatrix))
+		normalMatrix = MathLib::Mat4::Identity;
+
+	// Mirror into the scene arrays for the draw passes.
+	size_t i = scene.IndexOf(sceneHandle);
+	if (i != SIZE_MAX) {
+		scene.world[i] = worldMatrix;
+		scene.normal[i] = normalMatrix;
+		scene.UpdateBounds(i);
+	}
+
+	queued = false;
+
+	for (size_t i = 0; i < children.size(); i++)
+		children[i]->UpdateSubtree();
+}
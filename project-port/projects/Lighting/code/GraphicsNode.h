@@ -1,31 +1,104 @@
 #pragma once
 
+#include <algorithm>
 #include <functional>
-#include <map>
 #include <memory>
+#include <vector>
 
 #include "MeshResource.h"
 #include "TextureResource.h"
 #include "ShaderResource.h"
+#include "SceneStore.h"
 
 #include "MathLib.h"
 
 namespace ResourceLib {
 
+	class GraphicsNode;
+
+	/**
+	 * Location, rotation and scale of a node.
+	 *
+	 * Every setter flags the owning node as dirty so its cached matrices
+	 * are rebuilt by the next GraphicsNode::UpdateTransforms() pass.
+	 */
 	class Transform {
 	public:
+		Transform() = default;
+
+		/** Copies location, rotation and scale, a copy belongs to no node. */
+		Transform(const Transform& other) : location(other.location), rotation(other.rotation), scale(other.scale) {
+		}
+
+		/** Copies location, rotation and scale, keeping the owning node. */
+		Transform& operator = (const Transform& other) {
+			location = other.location;
+			rotation = other.rotation;
+			scale = other.scale;
+			MarkDirty();
+			return *this;
+		}
+
+		const MathLib::Vec4& GetLocation() const {
+			return location;
+		}
+		const MathLib::Quat& GetRotation() const {
+			return rotation;
+		}
+		const MathLib::Vec4& GetScale() const {
+			return scale;
+		}
+
+		void SetLocation(const MathLib::Vec4& location) {
+			this->location = location;
+			MarkDirty();
+		}
+
+		/** Moves the location by x/y/z. */
+		void Translate(float x, float y, float z) {
+			location[0] += x;
+			location[1] += y;
+			location[2] += z;
+			MarkDirty();
+		}
+
+		void SetRotation(const MathLib::Quat& rotation) {
+			this->rotation = rotation;
+			MarkDirty();
+		}
+
+		/** Sets the rotation from x/y/z euler angles in radians. */
+		void SetEulerRotation(float x, float y, float z) {
+			SetRotation(MathLib::Quat::Euler(x, y, z));
+		}
+
+		/** Sets the rotation from x/y/z euler angles in radians. */
+		void SetEulerRotation(const MathLib::Vec4& angles) {
+			SetRotation(MathLib::Quat::Euler(angles));
+		}
+
+		void SetScale(const MathLib::Vec4& scale) {
+			this->scale = scale;
+			MarkDirty();
+		}
+
+		/** Returns the local matrix built from location, rotation and scale. */
+		MathLib::Mat4 GetTransform() const {
+			return MathLib::Mat4::ComposeTRS(location, rotation, scale);
+		}
+
+	private:
+		friend class GraphicsNode;
+
+		/** Flags the owning node, defined after GraphicsNode. */
+		void MarkDirty();
+
 		MathLib::Vec4 location;
-		MathLib::Vec4 rotation;
+		MathLib::Quat rotation;
 		MathLib::Vec4 scale = MathLib::Vec4(1.0f, 1.0f, 1.0f);
 
-		MathLib::Mat4 GetTransform() {
-			return
-				MathLib::Mat4::Translate(location[0], location[1], location[2]) *
-				MathLib::Mat4::Scale(scale[0], scale[1], scale[2]) *
-				MathLib::Mat4::RotateEulerX(rotation[0]) *
-				MathLib::Mat4::RotateEulerY(rotation[1]) *
-				MathLib::Mat4::RotateEulerZ(rotation[2]);
-		}
+		/** The node this transform belongs to. */
+		GraphicsNode* owner = nullptr;
 	};
 
 	class GraphicsNode {
@@ -33,30 +106,51 @@ namespace ResourceLib {
 		std::shared_ptr<MeshResource> mr;
 		std::shared_ptr<TextureResource> tr;
 		std::shared_ptr<ShaderResource> sr;
+		/** Occlusion proxy, kept alive here for the scene arrays. */
+		std::shared_ptr<MeshResource> occluder;
 
 	public:
-		// Map of active graphics nodes.
-		static std::map<GraphicsNode*, bool> activeGraphicsNodes;
+		// Dense storage of every live graphics node.
+		static SceneStore scene;
 
 		Transform transform;
-		
+
 		GraphicsNode(std::shared_ptr<MeshResource> mr, std::shared_ptr<TextureResource> tr, std::shared_ptr<ShaderResource> sr) {
 			this->mr = mr;
 			this->tr = tr;
 			this->sr = sr;
 
-			// Activate object when adding to active nodes.
-			activeGraphicsNodes[this] = true;
+			// Hook transform up so setters reach this node.
+			transform.owner = this;
+			MarkTransformDirty();
+
+			// Activate object when adding to the scene.
+			sceneHandle = scene.Add(this, mr.get(), tr.get(), sr.get());
 		}
 
+		// Nodes are tracked by address, copies would leave dangling entries.
+		GraphicsNode(const GraphicsNode&) = delete;
+		GraphicsNode& operator = (const GraphicsNode&) = delete;
+
 		// "Delete" object, ie. disable object until it dies.
 		void Delete() {
-			activeGraphicsNodes[this] = false;
+			size_t i = scene.IndexOf(sceneHandle);
+			if (i != SIZE_MAX)
+				scene.active[i] = 0;
 		}
 
 		// Remove object from draw list when shared pointer reference dies.
 		~GraphicsNode() {
-			activeGraphicsNodes.erase(this);
+			// Children keep their world placement relative to nothing.
+			while (!children.empty())
+				children.back()->SetParent(nullptr);
+			SetParent(nullptr);
+
+			if (queued)
+				dirtyNodes.erase(std::remove(dirtyNodes.begin(), dirtyNodes.end(), this), dirtyNodes.end());
+
+			// No-op if already dropped by SceneStore::RemoveInactive.
+			scene.Remove(sceneHandle);
 		}
 
 		// Getters
@@ -73,21 +167,181 @@ namespace ResourceLib {
 
 		// Setters
 
-		GraphicsNode SetMeshResource(std::shared_ptr<MeshResource> mr) {
+		GraphicsNode& SetMeshResource(std::shared_ptr<MeshResource> mr) {
 			this->mr = mr;
+			size_t i = scene.IndexOf(sceneHandle);
+			if (i != SIZE_MAX) {
+				scene.meshes[i] = mr.get();
+				scene.lods[i] = 0;
+				scene.UpdateBounds(i);
+			}
 			return *this;
 		}
-		GraphicsNode SetTextureResource(std::shared_ptr<TextureResource> tr) {
+		GraphicsNode& SetTextureResource(std::shared_ptr<TextureResource> tr) {
 			this->tr = tr;
+			size_t i = scene.IndexOf(sceneHandle);
+			if (i != SIZE_MAX)
+				scene.textures[i] = tr.get();
 			return *this;
 		}
-		GraphicsNode SetShaderResource(std::shared_ptr<ShaderResource> sr) {
+		GraphicsNode& SetShaderResource(std::shared_ptr<ShaderResource> sr) {
 			this->sr = sr;
+			size_t i = scene.IndexOf(sceneHandle);
+			if (i != SIZE_MAX)
+				scene.shaders[i] = sr.get();
 			return *this;
 		}
 
+		/** Draws this node in the blended pass, sorted back to front. */
+		GraphicsNode& SetTransparent(bool transparent) {
+			size_t i = scene.IndexOf(sceneHandle);
+			if (i != SIZE_MAX)
+				scene.transparent[i] = transparent ? 1 : 0;
+			return *this;
+		}
 
-		// The update function of this object.
-		std::function<void(void)> Update;
+		/**
+		 * Lets this node hide others in GG::OcclusionCuller.
+		 *
+		 * The proxy keeps its CPU data, so it must not be uploaded with
+		 * unloading, and should lie inside the drawn mesh. Null stops the
+		 * node from occluding.
+		 */
+		GraphicsNode& SetOccluder(std::shared_ptr<MeshResource> proxy) {
+			this->occluder = proxy;
+			size_t i = scene.IndexOf(sceneHandle);
+			if (i != SIZE_MAX)
+				scene.occluders[i] = proxy.get();
+			return *this;
+		}
+
+		/**
+		 * Sets the function called for this node every frame while active.
+		 *
+		 * The callback is stored in the scene arrays, so it must not create
+		 * or destroy graphics nodes itself.
+		 */
+		GraphicsNode& SetUpdate(std::function<void(void)> update) {
+			size_t i = scene.IndexOf(sceneHandle);
+			if (i != SIZE_MAX)
+				scene.updates[i] = std::move(update);
+			return *this;
+		}
+
+		/** The handle of this node in the scene store. */
+		SceneHandle GetSceneHandle() const {
+			return sceneHandle;
+		}
+
+		// Hierarchy
+
+		/**
+		 * Attaches this node to a parent, or detaches it with nullptr.
+		 *
+		 * The world matrix becomes parent world * local. Parenting a node
+		 * to itself or one of its descendants is ignored.
+		 */
+		void SetParent(GraphicsNode* parent) {
+			if (parent == this->parent)
+				return;
+
+			// Refuse cycles.
+			for (GraphicsNode* p = parent; p != nullptr; p = p->parent) {
+				if (p == this)
+					return;
+			}
+
+			if (this->parent != nullptr) {
+				std::vector<GraphicsNode*>& siblings = this->parent->children;
+				siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
+			}
+
+			this->parent = parent;
+			if (parent != nullptr)
+				parent->children.push_back(this);
+
+			SetDepth(parent != nullptr ? parent->depth + 1 : 0);
+			MarkTransformDirty();
+		}
+
+		GraphicsNode* GetParent() const {
+			return parent;
+		}
+
+		const std::vector<GraphicsNode*>& GetChildren() const {
+			return children;
+		}
+
+		// Cached matrices, valid after UpdateTransforms().
+
+		/** The local matrix from this node's transform. */
+		const MathLib::Mat4& GetLocalMatrix() const {
+			return localMatrix;
+		}
+
+		/** The model matrix, parent world * local. */
+		const MathLib::Mat4& GetWorldMatrix() const {
+			return worldMatrix;
+		}
+
+		/** The inverse transpose of the world matrix' 3x3 part. */
+		const MathLib::Mat4& GetNormalMatrix() const {
+			return normalMatrix;
+		}
+
+		/** Queues this node and its subtree for the next transform pass. */
+		void MarkTransformDirty() {
+			localDirty = true;
+			if (!queued) {
+				queued = true;
+				dirtyNodes.push_back(this);
+			}
+		}
+
+		/**
+		 * Rebuilds the cached matrices of every dirty subtree.
+		 *
+		 * Dirty nodes are processed parents first, clean nodes outside a
+		 * dirty subtree are never touched, so static geometry costs nothing.
+		 * Call once per frame after updates and before drawing.
+		 */
+		static void UpdateTransforms();
+
+	private:
+		/** Recomputes this node's matrices and all of its descendants. */
+		void UpdateSubtree();
+
+		/** Sets depth for this node and its descendants. */
+		void SetDepth(unsigned int depth) {
+			this->depth = depth;
+			for (size_t i = 0; i < children.size(); i++)
+				children[i]->SetDepth(depth + 1);
+		}
+
+		/** Where this node lives in the scene store. */
+		SceneHandle sceneHandle;
+
+		/** Nodes whose transform changed since the last pass. */
+		static std::vector<GraphicsNode*> dirtyNodes;
+
+		GraphicsNode* parent = nullptr;
+		std::vector<GraphicsNode*> children;
+
+		/** Number of ancestors, used to sort the dirty list. */
+		unsigned int depth = 0;
+
+		/** The transform changed and the local matrix needs rebuilding. */
+		bool localDirty = false;
+		/** This node is in dirtyNodes. */
+		bool queued = false;
+
+		MathLib::Mat4 localMatrix = MathLib::Mat4::Identity;
+		MathLib::Mat4 worldMatrix = MathLib::Mat4::Identity;
+		MathLib::Mat4 normalMatrix = MathLib::Mat4::Identity;
 	};
+
+	inline void Transform::MarkDirty() {
+		if (owner != nullptr)
+			owner->MarkTransformDirty();
+	}
 }
@@ -0,0 +1,332 @@
+#include "HalfArray.h"
+#include "half.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define HALFARRAY_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// Lets single functions use F16C without compiling the whole file for it.
+#if defined(HALFARRAY_X86) && (defined(__GNUC__) || defined(__clang__))
+#define HALFARRAY_TARGET_SSE2 __attribute__((target("sse2")))
+#define HALFARRAY_TARGET_F16C __attribute__((target("avx,f16c")))
+#else
+#define HALFARRAY_TARGET_SSE2
+#define HALFARRAY_TARGET_F16C
+#endif
+
+
+namespace ResourceLib {
+namespace HalfArray {
+
+	////////////////////
+	// SCALAR KERNELS //
+	////////////////////
+
+	template<std::float_round_style R>
+	static void FromFloatScalar(const float* source, uint16_t* destination, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			half_float::half h = half_float::half_cast<half_float::half, R>(source[i]);
+			std::memcpy(&destination[i], &h, sizeof(uint16_t));
+		}
+	}
+
+	static void ToFloatScalar(const uint16_t* source, float* destination, size_t count) {
+		// half_cast's own bit level helper, half has no public way in from bits.
+		for (size_t i = 0; i < count; i++)
+			destination[i] = half_float::detail::half2float<float>(source[i]);
+	}
+
+#ifdef HALFARRAY_X86
+
+	//////////////////
+	// SSE2 KERNELS //
+	//////////////////
+
+	/** a where mask is set, b elsewhere. */
+	HALFARRAY_TARGET_SSE2 static inline __m128i Select(__m128i mask, __m128i a, __m128i b) {
+		return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+	}
+
+	/**
+	 * Four floats to half bits in the low 16 bits of each lane, rounded
+	 * like half.h: truncate to a half, then add one by the guard bit (the
+	 * first one dropped), the sticky bit (any later one) and the sign.
+	 */
+	template<std::float_round_style R>
+	HALFARRAY_TARGET_SSE2 static inline __m128i FromFloat4(__m128 value) {
+		const __m128i one = _mm_set1_epi32(1);
+		__m128i bits = _mm_castps_si128(value);
+		__m128i abs = _mm_and_si128(bits, _mm_set1_epi32(0x7FFFFFFF));
+		__m128i sign = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x8000));
+
+		// Normal halves rebias the exponent and drop 13 mantissa bits.
+		__m128i normal = _mm_srli_epi32(_mm_sub_epi32(abs, _mm_set1_epi32(0x38000000)), 13);
+		__m128i normalGuard = _mm_cmpeq_epi32(_mm_and_si128(abs, _mm_set1_epi32(0x1000)), _mm_set1_epi32(0x1000));
+		__m128i normalSticky = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(abs, _mm_set1_epi32(0xFFF)), _mm_setzero_si128()), _mm_set1_epi32(-1));
+
+		// Subnormal halves count steps of 2^-24, scaling by a power of two
+		// is exact and leaves the dropped bits as an exact remainder.
+		__m128 scaled = _mm_mul_ps(_mm_castsi128_ps(abs), _mm_set1_ps(16777216.0f));
+		__m128i steps = _mm_cvttps_epi32(scaled);
+		__m128 remainder = _mm_sub_ps(scaled, _mm_cvtepi32_ps(steps));
+		__m128 halfStep = _mm_set1_ps(0.5f);
+		__m128i subGuard = _mm_castps_si128(_mm_cmpge_ps(remainder, halfStep));
+		__m128i subSticky = _mm_castps_si128(_mm_and_ps(_mm_cmpneq_ps(remainder, _mm_setzero_ps()), _mm_cmpneq_ps(remainder, halfStep)));
+
+		__m128i isSubnormal = _mm_cmplt_epi32(abs, _mm_set1_epi32(0x38800000));
+		__m128i truncated = Select(isSubnormal, steps, normal);
+		__m128i guard = Select(isSubnormal, subGuard, normalGuard);
+		__m128i sticky = Select(isSubnormal, subSticky, normalSticky);
+
+		// Overflow is the largest finite half with every dropped bit set,
+		// rounding then goes to infinity or stays as the mode says.
+		__m128i isOverflow = _mm_cmpgt_epi32(abs, _mm_set1_epi32(0x477FFFFF));
+		truncated = Select(isOverflow, _mm_set1_epi32(0x7BFF), truncated);
+		guard = _mm_or_si128(guard, isOverflow);
+		sticky = _mm_or_si128(sticky, isOverflow);
+
+		__m128i negative = _mm_srai_epi32(bits, 31);
+		__m128i round = _mm_setzero_si128();
+		if (R == std::round_to_nearest)
+			round = _mm_and_si128(_mm_and_si128(guard, _mm_or_si128(sticky, truncated)), one);
+		else if (R == std::round_toward_infinity)
+			round = _mm_andnot_si128(negative, _mm_and_si128(_mm_or_si128(guard, sticky), one));
+		else if (R == std::round_toward_neg_infinity)
+			round = _mm_and_si128(negative, _mm_and_si128(_mm_or_si128(guard, sticky), one));
+		__m128i rounded = _mm_add_epi32(truncated, round);
+
+		// Infinity, NaNs keep the top of their payload and turn quiet.
+		__m128i isSpecial = _mm_cmpgt_epi32(abs, _mm_set1_epi32(0x7F7FFFFF));
+		__m128i isNaN = _mm_cmpgt_epi32(abs, _mm_set1_epi32(0x7F800000));
+		__m128i payload = _mm_or_si128(_mm_set1_epi32(0x200), _mm_and_si128(_mm_srli_epi32(abs, 13), _mm_set1_epi32(0x3FF)));
+		__m128i special = _mm_or_si128(_mm_set1_epi32(0x7C00), _mm_and_si128(isNaN, payload));
+
+		return _mm_or_si128(Select(isSpecial, special, rounded), sign);
+	}
+
+	/** Whether each of four floats is zero or becomes a normal half. */
+	HALFARRAY_TARGET_SSE2 static inline __m128i IsNormal4(__m128 value) {
+		__m128i abs = _mm_and_si128(_mm_castps_si128(value), _mm_set1_epi32(0x7FFFFFFF));
+		__m128i inRange = _mm_and_si128(_mm_cmpgt_epi32(abs, _mm_set1_epi32(0x387FFFFF)), _mm_cmplt_epi32(abs, _mm_set1_epi32(0x47800000)));
+		return _mm_or_si128(inRange, _mm_cmpeq_epi32(abs, _mm_setzero_si128()));
+	}
+
+	/**
+	 * FromFloat4() for floats that are zero or become normal halves, the
+	 * common case. Rounding is adding just under one step before the
+	 * shift, one more to round a tie up to even.
+	 */
+	template<std::float_round_style R>
+	HALFARRAY_TARGET_SSE2 static inline __m128i FromFloat4Normal(__m128 value) {
+		__m128i bits = _mm_castps_si128(value);
+		__m128i abs = _mm_and_si128(bits, _mm_set1_epi32(0x7FFFFFFF));
+		__m128i sign = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x8000));
+
+		__m128i rebiased = _mm_sub_epi32(abs, _mm_set1_epi32(0x38000000));
+		if (R == std::round_to_nearest) {
+			__m128i odd = _mm_and_si128(_mm_srli_epi32(abs, 13), _mm_set1_epi32(1));
+			rebiased = _mm_add_epi32(rebiased, _mm_add_epi32(odd, _mm_set1_epi32(0xFFF)));
+		}
+		else if (R == std::round_toward_infinity)
+			rebiased = _mm_add_epi32(rebiased, _mm_andnot_si128(_mm_srai_epi32(bits, 31), _mm_set1_epi32(0x1FFF)));
+		else if (R == std::round_toward_neg_infinity)
+			rebiased = _mm_add_epi32(rebiased, _mm_and_si128(_mm_srai_epi32(bits, 31), _mm_set1_epi32(0x1FFF)));
+
+		__m128i isZero = _mm_cmpeq_epi32(abs, _mm_setzero_si128());
+		return _mm_or_si128(_mm_andnot_si128(isZero, _mm_srli_epi32(rebiased, 13)), sign);
+	}
+
+	template<std::float_round_style R>
+	HALFARRAY_TARGET_SSE2 static void FromFloatSSE2(const float* source, uint16_t* destination, size_t count) {
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m128 first = _mm_loadu_ps(source + i);
+			__m128 second = _mm_loadu_ps(source + i + 4);
+			__m128i low, high;
+			if (_mm_movemask_epi8(_mm_and_si128(IsNormal4(first), IsNormal4(second))) == 0xFFFF) {
+				low = FromFloat4Normal<R>(first);
+				high = FromFloat4Normal<R>(second);
+			}
+			else {
+				low = FromFloat4<R>(first);
+				high = FromFloat4<R>(second);
+			}
+			// Sign extend so the saturating pack keeps all 16 bits.
+			low = _mm_srai_epi32(_mm_slli_epi32(low, 16), 16);
+			high = _mm_srai_epi32(_mm_slli_epi32(high, 16), 16);
+			_mm_storeu_si128((__m128i*)(destination + i), _mm_packs_epi32(low, high));
+		}
+		FromFloatScalar<R>(source + i, destination + i, count - i);
+	}
+
+	/** Four half bits in the low 16 bits of each lane to floats. */
+	HALFARRAY_TARGET_SSE2 static inline __m128 ToFloat4(__m128i half) {
+		__m128i sign = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x8000)), 16);
+		__m128i magnitude = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x7FFF)), 13);
+
+		// Rebias the exponent by 127 - 15, twice for infinity and NaNs.
+		__m128i normal = _mm_add_epi32(magnitude, _mm_set1_epi32(0x38000000));
+		__m128i isSpecial = _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(0x0F7FFFFF));
+		__m128i special = _mm_add_epi32(normal, _mm_set1_epi32(0x38000000));
+
+		// Subnormals as 1.m * 2^-14 minus the implicit 2^-14, exact.
+		__m128 subnormal = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(normal, _mm_set1_epi32(0x00800000))), _mm_castsi128_ps(_mm_set1_epi32(0x38800000)));
+		__m128i isSubnormal = _mm_cmplt_epi32(magnitude, _mm_set1_epi32(0x00800000));
+
+		__m128i result = Select(isSpecial, special, Select(isSubnormal, _mm_castps_si128(subnormal), normal));
+		return _mm_castsi128_ps(_mm_or_si128(result, sign));
+	}
+
+	HALFARRAY_TARGET_SSE2 static void ToFloatSSE2(const uint16_t* source, float* destination, size_t count) {
+		const __m128i zero = _mm_setzero_si128();
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m128i halves = _mm_loadu_si128((const __m128i*)(source + i));
+			_mm_storeu_ps(destination + i, ToFloat4(_mm_unpacklo_epi16(halves, zero)));
+			_mm_storeu_ps(destination + i + 4, ToFloat4(_mm_unpackhi_epi16(halves, zero)));
+		}
+		ToFloatScalar(source + i, destination + i, count - i);
+	}
+
+	//////////////////
+	// F16C KERNELS //
+	//////////////////
+
+	template<std::float_round_style R>
+	HALFARRAY_TARGET_F16C static void FromFloatF16C(const float* source, uint16_t* destination, size_t count) {
+		const int rounding =
+			(R == std::round_toward_zero) ? _MM_FROUND_TO_ZERO :
+			(R == std::round_toward_infinity) ? _MM_FROUND_TO_POS_INF :
+			(R == std::round_toward_neg_infinity) ? _MM_FROUND_TO_NEG_INF :
+			_MM_FROUND_TO_NEAREST_INT;
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+			_mm_storeu_si128((__m128i*)(destination + i), _mm256_cvtps_ph(_mm256_loadu_ps(source + i), rounding | _MM_FROUND_NO_EXC));
+		_mm256_zeroupper();
+
+		FromFloatScalar<R>(source + i, destination + i, count - i);
+	}
+
+	HALFARRAY_TARGET_F16C static void ToFloatF16C(const uint16_t* source, float* destination, size_t count) {
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+			_mm256_storeu_ps(destination + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(source + i))));
+		_mm256_zeroupper();
+
+		ToFloatScalar(source + i, destination + i, count - i);
+	}
+
+#endif
+
+	////////////////////
+	// CPU DETECTION  //
+	////////////////////
+
+	Level DetectLevel() {
+#if defined(HALFARRAY_X86) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		bool sse2 = (info[3] & (1 << 26)) != 0;
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		bool f16c = (info[2] & (1 << 29)) != 0;
+		// The 256 bit forms need the OS to save the upper ymm registers.
+		if (osxsave && avx && f16c && (_xgetbv(0) & 0x6) == 0x6)
+			return Level::F16C;
+		return sse2 ? Level::SSE2 : Level::Scalar;
+#elif defined(HALFARRAY_X86) && (defined(__GNUC__) || defined(__clang__))
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c"))
+			return Level::F16C;
+		if (__builtin_cpu_supports("sse2"))
+			return Level::SSE2;
+		return Level::Scalar;
+#else
+		return Level::Scalar;
+#endif
+	}
+
+	/** The dispatch table, conversions from float by std::float_round_style. */
+	struct Kernels {
+		Level level;
+		void (*fromFloat[4])(const float*, uint16_t*, size_t);
+		void (*toFloat)(const uint16_t*, float*, size_t);
+	};
+
+	// Constant initialized so anything running before static init still
+	// gets the (bit identical) scalar path.
+	static Kernels active = {
+		Level::Scalar,
+		{
+			FromFloatScalar<std::round_toward_zero>,
+			FromFloatScalar<std::round_to_nearest>,
+			FromFloatScalar<std::round_toward_infinity>,
+			FromFloatScalar<std::round_toward_neg_infinity>
+		},
+		ToFloatScalar
+	};
+
+	void SetLevel(Level level) {
+		Level supported = DetectLevel();
+		if ((int)level > (int)supported)
+			level = supported;
+
+		active.level = level;
+		active.fromFloat[std::round_toward_zero] = FromFloatScalar<std::round_toward_zero>;
+		active.fromFloat[std::round_to_nearest] = FromFloatScalar<std::round_to_nearest>;
+		active.fromFloat[std::round_toward_infinity] = FromFloatScalar<std::round_toward_infinity>;
+		active.fromFloat[std::round_toward_neg_infinity] = FromFloatScalar<std::round_toward_neg_infinity>;
+		active.toFloat = ToFloatScalar;
+
+#ifdef HALFARRAY_X86
+		if (level >= Level::SSE2) {
+			active.fromFloat[std::round_toward_zero] = FromFloatSSE2<std::round_toward_zero>;
+			active.fromFloat[std::round_to_nearest] = FromFloatSSE2<std::round_to_nearest>;
+			active.fromFloat[std::round_toward_infinity] = FromFloatSSE2<std::round_toward_infinity>;
+			active.fromFloat[std::round_toward_neg_infinity] = FromFloatSSE2<std::round_toward_neg_infinity>;
+			active.toFloat = ToFloatSSE2;
+		}
+		if (level >= Level::F16C) {
+			active.fromFloat[std::round_toward_zero] = FromFloatF16C<std::round_toward_zero>;
+			active.fromFloat[std::round_to_nearest] = FromFloatF16C<std::round_to_nearest>;
+			active.fromFloat[std::round_toward_infinity] = FromFloatF16C<std::round_toward_infinity>;
+			active.fromFloat[std::round_toward_neg_infinity] = FromFloatF16C<std::round_toward_neg_infinity>;
+			active.toFloat = ToFloatF16C;
+		}
+#endif
+	}
+
+	Level GetLevel() {
+		return active.level;
+	}
+
+	const char* LevelName(Level level) {
+		switch (level) {
+		case Level::SSE2: return "SSE2";
+		case Level::F16C: return "F16C";
+		default: return "Scalar";
+		}
+	}
+
+	// Pick the best kernels once at startup.
+	static struct LevelInit {
+		LevelInit() { SetLevel(DetectLevel()); }
+	} levelInit;
+
+	void FromFloat(const float* source, uint16_t* destination, size_t count, std::float_round_style round) {
+		if (round < std::round_toward_zero || round > std::round_toward_neg_infinity)
+			round = std::round_to_nearest;
+		active.fromFloat[round](source, destination, count);
+	}
+
+	void ToFloat(const uint16_t* source, float* destination, size_t count) {
+		active.toFloat(source, destination, count);
+	}
+}
+}
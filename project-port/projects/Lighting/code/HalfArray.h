@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace ResourceLib {
+
+	/**
+	 * Bulk conversion between float and IEEE half arrays, for vertex and
+	 * texture data too large to convert through half_float::half one value
+	 * at a time.
+	 *
+	 * Every instruction set gives the exact bits half.h's half_cast gives
+	 * for the same rounding mode, NaNs included. Like MathLib::SIMD the
+	 * instruction set is picked once at startup from the CPU features.
+	 */
+	namespace HalfArray {
+
+		/** The instruction set used by the kernels. */
+		enum class Level {
+			/** half.h, one value at a time. */
+			Scalar,
+			/** SSE2 integer bit twiddling, 8 values at a time. */
+			SSE2,
+			/** F16C conversion instructions, 8 values at a time. */
+			F16C
+		};
+
+		/** Returns the best instruction set supported by this CPU. */
+		Level DetectLevel();
+
+		/** Returns the instruction set currently used by the kernels. */
+		Level GetLevel();
+
+		/**
+		 * Forces the kernels to a specific instruction set.
+		 *
+		 * Levels not supported by the CPU are clamped to the detected level.
+		 */
+		void SetLevel(Level level);
+
+		/** Returns a printable name of an instruction set. */
+		const char* LevelName(Level level);
+
+		/**
+		 * Converts count floats to half bits.
+		 *
+		 * @param round is one of the rounding modes half.h takes, overflow
+		 * saturates to the largest finite half when rounding away from
+		 * infinity. std::round_indeterminate rounds to nearest.
+		 */
+		void FromFloat(const float* source, uint16_t* destination, size_t count, std::float_round_style round = std::round_to_nearest);
+
+		/** Converts count half bits to floats, which is always exact. */
+		void ToFloat(const uint16_t* source, float* destination, size_t count);
+	}
+}
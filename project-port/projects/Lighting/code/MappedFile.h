@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace ResourceLib {
+
+	/**
+	 * A whole file mapped read only into memory.
+	 *
+	 * Pages are loaded by the OS on first touch and shared with the file
+	 * cache, so parsing or uploading straight from Data() copies nothing.
+	 * The mapping lives until Close() or destruction.
+	 */
+	class MappedFile {
+	public:
+		MappedFile() {}
+
+		MappedFile(const std::string& filename) {
+			Open(filename);
+		}
+
+		~MappedFile() {
+			Close();
+		}
+
+		// Owns the mapping, copies would unmap it twice.
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator = (const MappedFile&) = delete;
+
+		/** Maps a file, false if it could not be opened. Empty files map to no data. */
+		bool Open(const std::string& filename);
+
+		/** Unmaps the file. */
+		void Close();
+
+		bool IsOpen() const {
+			return open;
+		}
+
+		const char* Data() const {
+			return (const char*)data;
+		}
+
+		size_t Size() const {
+			return size;
+		}
+
+	private:
+		void* data = nullptr;
+		size_t size = 0;
+		bool open = false;
+
+#ifdef _WIN32
+		void* file = nullptr;
+		void* mapping = nullptr;
+#endif
+	};
+}
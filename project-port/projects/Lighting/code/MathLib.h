@@ -43,9 +43,22 @@
 // C headers
 #include <cmath>
 
+// Vectorized kernels.
+#include "MathSIMD.h"
+
 
 namespace MathLib {
 
+	/** Computes sine and cosine of an angle in radians in one go. */
+	inline void SinCos(float a, float* s, float* c) {
+#if defined(__GNUC__) && !defined(__clang__)
+		__builtin_sincosf(a, s, c);
+#else
+		*s = std::sin(a);
+		*c = std::cos(a);
+#endif
+	}
+
 	/**
 	 * A four dimensional homogenous vector.
 	 * 
@@ -178,6 +191,16 @@ namespace MathLib {
 			);
 		}
 
+		/** Raw pointer to the four 16 byte aligned floats. */
+		float* Data() {
+			return values;
+		}
+
+		/** Raw pointer to the four 16 byte aligned floats. */
+		const float* Data() const {
+			return values;
+		}
+
 		void Print() {
 			printf("%f ", values[0]);
 			printf("%f ", values[1]);
@@ -187,8 +210,131 @@ namespace MathLib {
 		}
 
 	private:
-		/** The x/y/z/w floats of this vector. */
-		float values[4];
+		/** The x/y/z/w floats of this vector, aligned for SIMD loads. */
+		alignas(16) float values[4];
+	};
+
+
+	/**
+	 * A rotation quaternion, x/y/z is the vector part and w the scalar.
+	 *
+	 * Multiplication composes rotations the same way as Mat4, so
+	 * (a * b).ToMat4() == a.ToMat4() * b.ToMat4().
+	 */
+	class Quat {
+	public:
+		/** Create a quaternion, defaults to the identity rotation. */
+		Quat(float x = 0, float y = 0, float z = 0, float w = 1) {
+			values[0] = x;
+			values[1] = y;
+			values[2] = z;
+			values[3] = w;
+		}
+
+		/** Index overload with security bounds. */
+		float operator [] (int index) const {
+			if (index >= 0 && index <= 3) {
+				return values[index];
+			}
+			else {
+				throw std::out_of_range("Index out of range.");
+			}
+		}
+
+		/** Index overload with security bounds. */
+		float & operator [] (int index) {
+			if (index >= 0 && index <= 3) {
+				return values[index];
+			}
+			else {
+				throw std::out_of_range("Index out of range.");
+			}
+		}
+
+		/** Hamilton product, applies other first and then this. */
+		Quat operator * (const Quat& other) const {
+			const float* a = values;
+			const float* b = other.values;
+			return Quat(
+				a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1],
+				a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0],
+				a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3],
+				a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2]
+			);
+		}
+
+		/** Normalizes this quaternion. */
+		Quat& Normalize() {
+			float len = std::sqrt(
+				values[0] * values[0] + values[1] * values[1] +
+				values[2] * values[2] + values[3] * values[3]);
+			if (len > 0) {
+				float inv = 1.0f / len;
+				values[0] *= inv;
+				values[1] *= inv;
+				values[2] *= inv;
+				values[3] *= inv;
+			}
+			return *this;
+		}
+
+		/** Returns the inverse rotation of a unit quaternion. */
+		Quat Conjugate() const {
+			return Quat(-values[0], -values[1], -values[2], values[3]);
+		}
+
+		/**
+		 * Create a rotation around a vector axis.
+		 *
+		 * @param axis has the x, y and z components of the axis vector.
+		 * @param angle is the right hand rotation in radians.
+		 */
+		static Quat AxisAngle(const Vec4& axis, float angle) {
+			Vec4 a(axis[0], axis[1], axis[2]);
+			a.Normalize();
+
+			float s, c;
+			SinCos(angle * 0.5f, &s, &c);
+			return Quat(a[0] * s, a[1] * s, a[2] * s, c);
+		}
+
+		/**
+		 * Create a rotation from euler angles in radians.
+		 *
+		 * Matches RotateEulerX(x) * RotateEulerY(y) * RotateEulerZ(z), using
+		 * a single sincos per axis.
+		 */
+		static Quat Euler(float x, float y, float z) {
+			float sx, cx, sy, cy, sz, cz;
+			SinCos(x * 0.5f, &sx, &cx);
+			SinCos(y * 0.5f, &sy, &cy);
+			SinCos(z * 0.5f, &sz, &cz);
+
+			return Quat(
+				sx * cy * cz + cx * sy * sz,
+				cx * sy * cz - sx * cy * sz,
+				cx * cy * sz + sx * sy * cz,
+				cx * cy * cz - sx * sy * sz
+			);
+		}
+
+		/** Create a rotation from x/y/z euler angles in radians. */
+		static Quat Euler(const Vec4& angles) {
+			return Euler(angles[0], angles[1], angles[2]);
+		}
+
+		/** Raw pointer to the x/y/z/w floats. */
+		const float* Data() const {
+			return values;
+		}
+
+		void Print() {
+			printf("%f %f %f %f\n", values[0], values[1], values[2], values[3]);
+		}
+
+	private:
+		/** The x/y/z/w floats of this quaternion. */
+		alignas(16) float values[4];
 	};
 
 
@@ -247,72 +393,64 @@ namespace MathLib {
 		}
 
 		/** Matrix-matrix multiplication. */
-		Mat4 operator * (const Mat4& other) {
-			// Do stuff.
-			Mat4 t = Mat4::Transpose(other);
+		Mat4 operator * (const Mat4& other) const {
+			Mat4 m;
+			SIMD::MatMul(Data(), other.Data(), m.Data());
+			return m;
+		}
 
-			return Mat4(
-				columns[0][0] * t[0][0] + columns[0][1] * t[0][1] + columns[0][2] * t[0][2] + columns[0][3] * t[0][3],
-				columns[0][0] * t[1][0] + columns[0][1] * t[1][1] + columns[0][2] * t[1][2] + columns[0][3] * t[1][3],
-				columns[0][0] * t[2][0] + columns[0][1] * t[2][1] + columns[0][2] * t[2][2] + columns[0][3] * t[2][3],
-				columns[0][0] * t[3][0] + columns[0][1] * t[3][1] + columns[0][2] * t[3][2] + columns[0][3] * t[3][3],
+		/** Matrix-vector multiplication. */
+		Vec4 operator * (const Vec4& other) const {
+			Vec4 v;
+			SIMD::MatVec(Data(), other.Data(), v.Data());
+			return v;
+		}
 
-				columns[1][0] * t[0][0] + columns[1][1] * t[0][1] + columns[1][2] * t[0][2] + columns[1][3] * t[0][3],
-				columns[1][0] * t[1][0] + columns[1][1] * t[1][1] + columns[1][2] * t[1][2] + columns[1][3] * t[1][3],
-				columns[1][0] * t[2][0] + columns[1][1] * t[2][1] + columns[1][2] * t[2][2] + columns[1][3] * t[2][3],
-				columns[1][0] * t[3][0] + columns[1][1] * t[3][1] + columns[1][2] * t[3][2] + columns[1][3] * t[3][3],
+		/** Matrix-scalar multiplication. */
+		Mat4 operator * (const float& other) const {
+			Mat4 m;
+			SIMD::MatScale(Data(), other, m.Data());
+			return m;
+		}
 
-				columns[2][0] * t[0][0] + columns[2][1] * t[0][1] + columns[2][2] * t[0][2] + columns[2][3] * t[0][3],
-				columns[2][0] * t[1][0] + columns[2][1] * t[1][1] + columns[2][2] * t[1][2] + columns[2][3] * t[1][3],
-				columns[2][0] * t[2][0] + columns[2][1] * t[2][1] + columns[2][2] * t[2][2] + columns[2][3] * t[2][3],
-				columns[2][0] * t[3][0] + columns[2][1] * t[3][1] + columns[2][2] * t[3][2] + columns[2][3] * t[3][3],
+		/**
+		 * Transforms an array of xyz points by this matrix.
+		 *
+		 * Strides are in floats, so interleaved float vertex data can be
+		 * passed without repacking by dividing a Type::Float attribute's
+		 * byte offset and stride by sizeof(float).
+		 *
+		 * @param perspectiveDivide divides the result by its w when true.
+		 */
+		void TransformPoints(const float* in, size_t inStride, float* out, size_t outStride, size_t count, bool perspectiveDivide = false) const {
+			SIMD::TransformAoS(Data(), in, inStride, out, outStride, count,
+				perspectiveDivide ? SIMD::TransformMode::ProjectPoint : SIMD::TransformMode::Point);
+		}
 
-				columns[3][0] * t[0][0] + columns[3][1] * t[0][1] + columns[3][2] * t[0][2] + columns[3][3] * t[0][3],
-				columns[3][0] * t[1][0] + columns[3][1] * t[1][1] + columns[3][2] * t[1][2] + columns[3][3] * t[1][3],
-				columns[3][0] * t[2][0] + columns[3][1] * t[2][1] + columns[3][2] * t[2][2] + columns[3][3] * t[2][3],
-				columns[3][0] * t[3][0] + columns[3][1] * t[3][1] + columns[3][2] * t[3][2] + columns[3][3] * t[3][3]);
+		/** Transforms an array of xyz directions by this matrix, ignoring translation. */
+		void TransformVectors(const float* in, size_t inStride, float* out, size_t outStride, size_t count) const {
+			SIMD::TransformAoS(Data(), in, inStride, out, outStride, count, SIMD::TransformMode::Vector);
 		}
 
-		/** Matrix-vector multiplication. */
-		Vec4 operator * (const Vec4& other) {
-			Vec4 v;
+		/** Transforms points stored as separate x, y and z arrays. */
+		void TransformPoints(const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, size_t count, bool perspectiveDivide = false) const {
+			SIMD::TransformSoA(Data(), x, y, z, outX, outY, outZ, count,
+				perspectiveDivide ? SIMD::TransformMode::ProjectPoint : SIMD::TransformMode::Point);
+		}
 
-			// Do stuff.
-			v[0] =
-				other[0] * columns[0][0] +
-				other[1] * columns[0][1] +
-				other[2] * columns[0][2] +
-				other[3] * columns[0][3];
-				
-			v[1] =
-				other[0] * columns[1][0] +
-				other[1] * columns[1][1] +
-				other[2] * columns[1][2] +
-				other[3] * columns[1][3];
-				
-			v[2] =
-				other[0] * columns[2][0] +
-				other[1] * columns[2][1] +
-				other[2] * columns[2][2] +
-				other[3] * columns[2][3];
-				
-			v[3] =
-				other[0] * columns[3][0] +
-				other[1] * columns[3][1] +
-				other[2] * columns[3][2] +
-				other[3] * columns[3][3];
+		/** Transforms directions stored as separate x, y and z arrays. */
+		void TransformVectors(const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, size_t count) const {
+			SIMD::TransformSoA(Data(), x, y, z, outX, outY, outZ, count, SIMD::TransformMode::Vector);
+		}
 
-			return v;
+		/** Raw pointer to the 16 row major, 16 byte aligned floats. */
+		float* Data() {
+			return columns[0].Data();
 		}
 
-		/** Matrix-scalar multiplication. */
-		Mat4 operator * (const float& other) {
-			return Mat4(
-				columns[0][0] * other, columns[0][1] * other, columns[0][2] * other, columns[0][3] * other,
-				columns[1][0] * other, columns[1][1] * other, columns[1][2] * other, columns[1][3] * other,
-				columns[2][0] * other, columns[2][1] * other, columns[2][2] * other, columns[2][3] * other,
-				columns[3][0] * other, columns[3][1] * other, columns[3][2] * other, columns[3][3] * other
-			);
+		/** Raw pointer to the 16 row major, 16 byte aligned floats. */
+		const float* Data() const {
+			return columns[0].Data();
 		}
 
 		static const Mat4 Identity;
@@ -404,7 +542,7 @@ namespace MathLib {
 		 * Code shamelessly copied from stackoverflow:
 		 * https://stackoverflow.com/questions/2937702/i-want-to-find-determinant-of-4x4-matrix-in-c-sharp
 		 */
-		static float Determinant(Mat4 matrix) {
+		static float Determinant(const Mat4& matrix) {
 			return
 				matrix[0][3] * matrix[1][2] * matrix[2][1] * matrix[3][0] - matrix[0][2] * matrix[1][3] * matrix[2][1] * matrix[3][0] -
 				matrix[0][3] * matrix[1][1] * matrix[2][2] * matrix[3][0] + matrix[0][1] * matrix[1][3] * matrix[2][2] * matrix[3][0] +
@@ -425,149 +563,234 @@ namespace MathLib {
 			return Mat4::Determinant(*this);
 		}
 
+		/** The inverse path that was used by Inverse. */
+		enum class InverseType {
+			/** The matrix could not be inverted. */
+			Singular,
+			/** Full 4x4 inverse. */
+			General,
+			/** Last row is 0 0 0 1, only the 3x3 part needed inverting. */
+			Affine,
+			/** Orthonormal 3x3 and translation, inverted by transposing. */
+			Rigid
+		};
+
+		/** Returns true if the last row is exactly 0 0 0 1. */
+		bool IsAffine() const {
+			const float* m = Data();
+			return m[12] == 0 && m[13] == 0 && m[14] == 0 && m[15] == 1;
+		}
+
+		/**
+		 * Returns true if this is an affine matrix with an orthonormal 3x3
+		 * part, ie. only rotation and translation.
+		 */
+		bool IsRigid(float epsilon = 1e-5f) const {
+			if (!IsAffine())
+				return false;
+
+			const float* m = Data();
+			for (int i = 0; i < 3; i++) {
+				for (int j = i; j < 3; j++) {
+					float dot = m[i * 4] * m[j * 4] + m[i * 4 + 1] * m[j * 4 + 1] + m[i * 4 + 2] * m[j * 4 + 2];
+					float expected = (i == j) ? 1.0f : 0.0f;
+					if (std::fabs(dot - expected) > epsilon)
+						return false;
+				}
+			}
+			return true;
+		}
+
 		/**
 		 * Tries to invert a matrix.
 		 *
-		 * Code shamelessly copied from stackoverflow:
-		 * https://stackoverflow.com/questions/1148309/inverting-a-4x4-matrix
+		 * Uses the vectorized general inverse, the cofactors are reused for
+		 * the determinant so there is no separate Determinant() call.
 		 * 
 		 * @param matrix is the matrix to be inverted.
 		 * @param invertableOut is a pointer to the resulting inverted matrix.
 		 * 
 		 * @returns if matrix was successfully inverted.
 		 */
-		static bool Inverse(Mat4 matrix, Mat4* invertedOut) {
-			float det = matrix.Determinant();
+		static bool Inverse(const Mat4& matrix, Mat4* invertedOut) {
+			return SIMD::Inverse(matrix.Data(), invertedOut->Data());
+		}
+
+		/**
+		 * Tries to invert a matrix using the cheapest path that fits it.
+		 *
+		 * @param typeOut receives which path was used, Singular on failure.
+		 *
+		 * @returns if matrix was successfully inverted.
+		 */
+		static bool Inverse(const Mat4& matrix, Mat4* invertedOut, InverseType* typeOut) {
+			InverseType type = InverseType::Singular;
+
+			if (matrix.IsRigid()) {
+				InverseRigid(matrix, invertedOut);
+				type = InverseType::Rigid;
+			}
+			else if (matrix.IsAffine()) {
+				if (InverseAffine(matrix, invertedOut))
+					type = InverseType::Affine;
+			}
+			else if (Inverse(matrix, invertedOut)) {
+				type = InverseType::General;
+			}
+
+			if (typeOut != nullptr)
+				*typeOut = type;
+
+			return type != InverseType::Singular;
+		}
+
+		/**
+		 * Inverts a matrix whose last row is 0 0 0 1.
+		 *
+		 * Only the 3x3 part is inverted, translation becomes -A^-1 * t.
+		 *
+		 * @returns false if the 3x3 part is singular.
+		 */
+		static bool InverseAffine(const Mat4& matrix, Mat4* invertedOut) {
+			const float* m = matrix.Data();
+
+			// Cofactors of the 3x3 part.
+			float c00 = m[5] * m[10] - m[6] * m[9];
+			float c01 = m[6] * m[8] - m[4] * m[10];
+			float c02 = m[4] * m[9] - m[5] * m[8];
+
+			float det = m[0] * c00 + m[1] * c01 + m[2] * c02;
+			if (det == 0)
+				return false;
+
+			float c10 = m[2] * m[9] - m[1] * m[10];
+			float c11 = m[0] * m[10] - m[2] * m[8];
+			float c12 = m[1] * m[8] - m[0] * m[9];
+			float c20 = m[1] * m[6] - m[2] * m[5];
+			float c21 = m[2] * m[4] - m[0] * m[6];
+			float c22 = m[0] * m[5] - m[1] * m[4];
+
+			float id = 1.0f / det;
+
+			// Inverse is the transposed cofactor matrix over the determinant.
+			float a00 = c00 * id, a01 = c10 * id, a02 = c20 * id;
+			float a10 = c01 * id, a11 = c11 * id, a12 = c21 * id;
+			float a20 = c02 * id, a21 = c12 * id, a22 = c22 * id;
+
+			float tx = m[3], ty = m[7], tz = m[11];
+
+			*invertedOut = Mat4(
+				a00, a01, a02, -(a00 * tx + a01 * ty + a02 * tz),
+				a10, a11, a12, -(a10 * tx + a11 * ty + a12 * tz),
+				a20, a21, a22, -(a20 * tx + a21 * ty + a22 * tz),
+				0, 0, 0, 1
+			);
+
+			return true;
+		}
+
+		/**
+		 * Inverts a rotation + translation matrix.
+		 *
+		 * The caller is responsible for the matrix actually being rigid,
+		 * see IsRigid(). The rotation is transposed and translation
+		 * becomes -R^T * t.
+		 */
+		static void InverseRigid(const Mat4& matrix, Mat4* invertedOut) {
+			const float* m = matrix.Data();
+			float tx = m[3], ty = m[7], tz = m[11];
+
+			*invertedOut = Mat4(
+				m[0], m[4], m[8], -(m[0] * tx + m[4] * ty + m[8] * tz),
+				m[1], m[5], m[9], -(m[1] * tx + m[5] * ty + m[9] * tz),
+				m[2], m[6], m[10], -(m[2] * tx + m[6] * ty + m[10] * tz),
+				0, 0, 0, 1
+			);
+		}
+
+		/**
+		 * Computes the normal matrix, the inverse transpose of the 3x3 part.
+		 *
+		 * The inverse transpose of a 3x3 matrix is its cofactor matrix over
+		 * the determinant, so no full inverse or transpose is needed. Rigid
+		 * matrices return their own 3x3 part. The result has no translation
+		 * and 0 0 0 1 as its last row.
+		 *
+		 * @param typeOut receives Rigid, Affine or Singular if not null.
+		 *
+		 * @returns false if the 3x3 part is singular.
+		 */
+		static bool InverseTranspose3x3(const Mat4& matrix, Mat4* normalOut, InverseType* typeOut = nullptr) {
+			const float* m = matrix.Data();
+
+			if (matrix.IsRigid()) {
+				*normalOut = Mat4(
+					m[0], m[1], m[2], 0,
+					m[4], m[5], m[6], 0,
+					m[8], m[9], m[10], 0,
+					0, 0, 0, 1
+				);
+				if (typeOut != nullptr)
+					*typeOut = InverseType::Rigid;
+				return true;
+			}
+
+			float c00 = m[5] * m[10] - m[6] * m[9];
+			float c01 = m[6] * m[8] - m[4] * m[10];
+			float c02 = m[4] * m[9] - m[5] * m[8];
 
-			// Sanity check for non invertable matrix.
+			float det = m[0] * c00 + m[1] * c01 + m[2] * c02;
 			if (det == 0) {
+				if (typeOut != nullptr)
+					*typeOut = InverseType::Singular;
 				return false;
 			}
 
-			Mat4 m;
+			float id = 1.0f / det;
 
-			m[0][0] = matrix[1][1] * matrix[2][2] * matrix[3][3] -
-				matrix[1][1] * matrix[2][3] * matrix[3][2] -
-				matrix[2][1] * matrix[1][2] * matrix[3][3] +
-				matrix[2][1] * matrix[1][3] * matrix[3][2] +
-				matrix[3][1] * matrix[1][2] * matrix[2][3] -
-				matrix[3][1] * matrix[1][3] * matrix[2][2];
-
-			m[1][0] = -matrix[1][0] * matrix[2][2] * matrix[3][3] +
-				matrix[1][0] * matrix[2][3] * matrix[3][2] +
-				matrix[2][0] * matrix[1][2] * matrix[3][3] -
-				matrix[2][0] * matrix[1][3] * matrix[3][2] -
-				matrix[3][0] * matrix[1][2] * matrix[2][3] +
-				matrix[3][0] * matrix[1][3] * matrix[2][2];
-
-			m[2][0] = matrix[1][0] * matrix[2][1] * matrix[3][3] -
-				matrix[1][0] * matrix[2][3] * matrix[3][1] -
-				matrix[2][0] * matrix[1][1] * matrix[3][3] +
-				matrix[2][0] * matrix[1][3] * matrix[3][1] +
-				matrix[3][0] * matrix[1][1] * matrix[2][3] -
-				matrix[3][0] * matrix[1][3] * matrix[2][1];
-
-			m[3][0] = -matrix[1][0] * matrix[2][1] * matrix[3][2] +
-				matrix[1][0] * matrix[2][2] * matrix[3][1] +
-				matrix[2][0] * matrix[1][1] * matrix[3][2] -
-				matrix[2][0] * matrix[1][2] * matrix[3][1] -
-				matrix[3][0] * matrix[1][1] * matrix[2][2] +
-				matrix[3][0] * matrix[1][2] * matrix[2][1];
-
-			m[0][1] = -matrix[0][1] * matrix[2][2] * matrix[3][3] +
-				matrix[0][1] * matrix[2][3] * matrix[3][2] +
-				matrix[2][1] * matrix[0][2] * matrix[3][3] -
-				matrix[2][1] * matrix[0][3] * matrix[3][2] -
-				matrix[3][1] * matrix[0][2] * matrix[2][3] +
-				matrix[3][1] * matrix[0][3] * matrix[2][2];
-
-			m[1][1] = matrix[0][0] * matrix[2][2] * matrix[3][3] -
-				matrix[0][0] * matrix[2][3] * matrix[3][2] -
-				matrix[2][0] * matrix[0][2] * matrix[3][3] +
-				matrix[2][0] * matrix[0][3] * matrix[3][2] +
-				matrix[3][0] * matrix[0][2] * matrix[2][3] -
-				matrix[3][0] * matrix[0][3] * matrix[2][2];
-
-			m[2][1] = -matrix[0][0] * matrix[2][1] * matrix[3][3] +
-				matrix[0][0] * matrix[2][3] * matrix[3][1] +
-				matrix[2][0] * matrix[0][1] * matrix[3][3] -
-				matrix[2][0] * matrix[0][3] * matrix[3][1] -
-				matrix[3][0] * matrix[0][1] * matrix[2][3] +
-				matrix[3][0] * matrix[0][3] * matrix[2][1];
-
-			m[3][1] = matrix[0][0] * matrix[2][1] * matrix[3][2] -
-				matrix[0][0] * matrix[2][2] * matrix[3][1] -
-				matrix[2][0] * matrix[0][1] * matrix[3][2] +
-				matrix[2][0] * matrix[0][2] * matrix[3][1] +
-				matrix[3][0] * matrix[0][1] * matrix[2][2] -
-				matrix[3][0] * matrix[0][2] * matrix[2][1];
-
-			m[0][2] = matrix[0][1] * matrix[1][2] * matrix[3][3] -
-				matrix[0][1] * matrix[1][3] * matrix[3][2] -
-				matrix[1][1] * matrix[0][2] * matrix[3][3] +
-				matrix[1][1] * matrix[0][3] * matrix[3][2] +
-				matrix[3][1] * matrix[0][2] * matrix[1][3] -
-				matrix[3][1] * matrix[0][3] * matrix[1][2];
-
-			m[1][2] = -matrix[0][0] * matrix[1][2] * matrix[3][3] +
-				matrix[0][0] * matrix[1][3] * matrix[3][2] +
-				matrix[1][0] * matrix[0][2] * matrix[3][3] -
-				matrix[1][0] * matrix[0][3] * matrix[3][2] -
-				matrix[3][0] * matrix[0][2] * matrix[1][3] +
-				matrix[3][0] * matrix[0][3] * matrix[1][2];
-
-			m[2][2] = matrix[0][0] * matrix[1][1] * matrix[3][3] -
-				matrix[0][0] * matrix[1][3] * matrix[3][1] -
-				matrix[1][0] * matrix[0][1] * matrix[3][3] +
-				matrix[1][0] * matrix[0][3] * matrix[3][1] +
-				matrix[3][0] * matrix[0][1] * matrix[1][3] -
-				matrix[3][0] * matrix[0][3] * matrix[1][1];
-
-			m[3][2] = -matrix[0][0] * matrix[1][1] * matrix[3][2] +
-				matrix[0][0] * matrix[1][2] * matrix[3][1] +
-				matrix[1][0] * matrix[0][1] * matrix[3][2] -
-				matrix[1][0] * matrix[0][2] * matrix[3][1] -
-				matrix[3][0] * matrix[0][1] * matrix[1][2] +
-				matrix[3][0] * matrix[0][2] * matrix[1][1];
-
-			m[0][3] = -matrix[0][1] * matrix[1][2] * matrix[2][3] +
-				matrix[0][1] * matrix[1][3] * matrix[2][2] +
-				matrix[1][1] * matrix[0][2] * matrix[2][3] -
-				matrix[1][1] * matrix[0][3] * matrix[2][2] -
-				matrix[2][1] * matrix[0][2] * matrix[1][3] +
-				matrix[2][1] * matrix[0][3] * matrix[1][2];
-
-			m[1][3] = matrix[0][0] * matrix[1][2] * matrix[2][3] -
-				matrix[0][0] * matrix[1][3] * matrix[2][2] -
-				matrix[1][0] * matrix[0][2] * matrix[2][3] +
-				matrix[1][0] * matrix[0][3] * matrix[2][2] +
-				matrix[2][0] * matrix[0][2] * matrix[1][3] -
-				matrix[2][0] * matrix[0][3] * matrix[1][2];
-
-			m[2][3] = -matrix[0][0] * matrix[1][1] * matrix[2][3] +
-				matrix[0][0] * matrix[1][3] * matrix[2][1] +
-				matrix[1][0] * matrix[0][1] * matrix[2][3] -
-				matrix[1][0] * matrix[0][3] * matrix[2][1] -
-				matrix[2][0] * matrix[0][1] * matrix[1][3] +
-				matrix[2][0] * matrix[0][3] * matrix[1][1];
-
-			m[3][3] = matrix[0][0] * matrix[1][1] * matrix[2][2] -
-				matrix[0][0] * matrix[1][2] * matrix[2][1] -
-				matrix[1][0] * matrix[0][1] * matrix[2][2] +
-				matrix[1][0] * matrix[0][2] * matrix[2][1] +
-				matrix[2][0] * matrix[0][1] * matrix[1][2] -
-				matrix[2][0] * matrix[0][2] * matrix[1][1];
-
-			// Scale matrix by the inverse of the determinant.
-			m = m * (1.0f / det);
-
-			// Done with matrix, send it out to the world
-			*invertedOut = m;
-
-			// Return true indicating successful inverting of matrix.
+			*normalOut = Mat4(
+				c00 * id, c01 * id, c02 * id, 0,
+				(m[2] * m[9] - m[1] * m[10]) * id, (m[0] * m[10] - m[2] * m[8]) * id, (m[1] * m[8] - m[0] * m[9]) * id, 0,
+				(m[1] * m[6] - m[2] * m[5]) * id, (m[2] * m[4] - m[0] * m[6]) * id, (m[0] * m[5] - m[1] * m[4]) * id, 0,
+				0, 0, 0, 1
+			);
+			if (typeOut != nullptr)
+				*typeOut = InverseType::Affine;
 			return true;
 		}
 
+		/** Creates a rotation matrix from a unit quaternion. */
+		static Mat4 Rotate(const Quat& q) {
+			return ComposeTRS(Vec4(0, 0, 0), q, Vec4(1, 1, 1));
+		}
+
+		/**
+		 * Writes Translate(location) * Scale(scale) * Rotate(rotation)
+		 * directly, without building and multiplying the separate matrices.
+		 *
+		 * @param location is the x/y/z translation.
+		 * @param rotation is a unit quaternion.
+		 * @param scale is the x/y/z scale.
+		 */
+		static Mat4 ComposeTRS(const Vec4& location, const Quat& rotation, const Vec4& scale) {
+			const float* q = rotation.Data();
+			const float* s = scale.Data();
+			const float* t = location.Data();
+
+			float x2 = q[0] + q[0], y2 = q[1] + q[1], z2 = q[2] + q[2];
+			float xx = q[0] * x2, yy = q[1] * y2, zz = q[2] * z2;
+			float xy = q[0] * y2, xz = q[0] * z2, yz = q[1] * z2;
+			float wx = q[3] * x2, wy = q[3] * y2, wz = q[3] * z2;
+
+			// Scale is applied after rotation, so it scales rows.
+			return Mat4(
+				s[0] * (1 - (yy + zz)), s[0] * (xy - wz), s[0] * (xz + wy), t[0],
+				s[1] * (xy + wz), s[1] * (1 - (xx + zz)), s[1] * (yz - wx), t[1],
+				s[2] * (xz - wy), s[2] * (yz + wx), s[2] * (1 - (xx + yy)), t[2],
+				0, 0, 0, 1
+			);
+		}
+
 		/** Creates a translation matrix. */
 		static Mat4 Translate(float x, float y, float z) {
 			return Mat4(
@@ -645,6 +868,41 @@ namespace MathLib {
 			);
 		}
 
+		/**
+		 * Extracts the six frustum planes of a view projection matrix.
+		 *
+		 * Planes are left, right, bottom, top, near and far as (a, b, c, d)
+		 * with a unit length normal pointing inwards, so a point p is inside
+		 * when a*x + b*y + c*z + d >= 0 for every plane. The planes are in
+		 * the space the matrix takes its input from, world space for
+		 * projection * view.
+		 */
+		static void FrustumPlanes(const Mat4& viewProjection, Vec4* planesOut) {
+			const Vec4& r0 = viewProjection.columns[0];
+			const Vec4& r1 = viewProjection.columns[1];
+			const Vec4& r2 = viewProjection.columns[2];
+			const Vec4& r3 = viewProjection.columns[3];
+
+			// -w <= x, y, z <= w for every row of the clip space position.
+			for (int i = 0; i < 4; i++) {
+				planesOut[0][i] = r3[i] + r0[i];
+				planesOut[1][i] = r3[i] - r0[i];
+				planesOut[2][i] = r3[i] + r1[i];
+				planesOut[3][i] = r3[i] - r1[i];
+				planesOut[4][i] = r3[i] + r2[i];
+				planesOut[5][i] = r3[i] - r2[i];
+			}
+
+			for (int p = 0; p < 6; p++) {
+				Vec4& plane = planesOut[p];
+				float length = sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+				if (length > 0) {
+					for (int i = 0; i < 4; i++)
+						plane[i] /= length;
+				}
+			}
+		}
+
 		void Print() {
 			this->columns[0].Print();
 			this->columns[1].Print();
@@ -657,4 +915,8 @@ namespace MathLib {
 		/** The columns of this matrix. */
 		Vec4 columns[4];
 	};
-}
+
+	// The kernels treat these as flat float arrays.
+	static_assert(sizeof(Vec4) == 4 * sizeof(float), "Vec4 must be four tightly packed floats.");
+	static_assert(sizeof(Mat4) == 16 * sizeof(float), "Mat4 must be sixteen tightly packed floats.");
+}
\ No newline at end of file
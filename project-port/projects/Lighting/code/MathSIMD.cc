@@ -0,0 +1,752 @@
+#include "MathSIMD.h"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MATHLIB_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// Lets single functions use AVX without compiling the whole file for it.
+#if defined(MATHLIB_X86) && (defined(__GNUC__) || defined(__clang__))
+#define MATHLIB_TARGET_AVX __attribute__((target("avx")))
+#else
+#define MATHLIB_TARGET_AVX
+#endif
+
+
+namespace MathLib {
+namespace SIMD {
+
+	////////////////////
+	// SCALAR KERNELS //
+	////////////////////
+
+	static void MatMulScalar(const float* a, const float* b, float* out) {
+		float r[16];
+		for (int i = 0; i < 4; i++) {
+			const float* row = a + i * 4;
+			for (int j = 0; j < 4; j++) {
+				r[i * 4 + j] =
+					row[0] * b[j] +
+					row[1] * b[4 + j] +
+					row[2] * b[8 + j] +
+					row[3] * b[12 + j];
+			}
+		}
+		for (int i = 0; i < 16; i++)
+			out[i] = r[i];
+	}
+
+	static void MatVecScalar(const float* m, const float* v, float* out) {
+		float r[4];
+		for (int i = 0; i < 4; i++) {
+			r[i] =
+				v[0] * m[i * 4 + 0] +
+				v[1] * m[i * 4 + 1] +
+				v[2] * m[i * 4 + 2] +
+				v[3] * m[i * 4 + 3];
+		}
+		for (int i = 0; i < 4; i++)
+			out[i] = r[i];
+	}
+
+	static void MatScaleScalar(const float* m, float s, float* out) {
+		for (int i = 0; i < 16; i++)
+			out[i] = m[i] * s;
+	}
+
+	// 2x2 row major blocks for the inverse below, lane for lane the same
+	// operations as the SSE helpers.
+
+	/** 2x2 block product a * b. */
+	static inline void Mat2MulScalar(const float* a, const float* b, float* out) {
+		out[0] = a[0] * b[0] + a[1] * b[2];
+		out[1] = a[1] * b[3] + a[0] * b[1];
+		out[2] = a[2] * b[0] + a[3] * b[2];
+		out[3] = a[3] * b[3] + a[2] * b[1];
+	}
+
+	/** 2x2 block product adj(a) * b. */
+	static inline void Mat2AdjMulScalar(const float* a, const float* b, float* out) {
+		out[0] = a[3] * b[0] - a[1] * b[2];
+		out[1] = a[3] * b[1] - a[1] * b[3];
+		out[2] = a[0] * b[2] - a[2] * b[0];
+		out[3] = a[0] * b[3] - a[2] * b[1];
+	}
+
+	/** 2x2 block product a * adj(b). */
+	static inline void Mat2MulAdjScalar(const float* a, const float* b, float* out) {
+		out[0] = a[0] * b[3] - a[1] * b[2];
+		out[1] = a[1] * b[0] - a[0] * b[1];
+		out[2] = a[2] * b[3] - a[3] * b[2];
+		out[3] = a[3] * b[0] - a[2] * b[1];
+	}
+
+	/**
+	 * Block wise inverse like InverseSSE, a cofactor expansion would round
+	 * differently and could even disagree on which matrices are singular.
+	 */
+	static bool InverseScalar(const float* m, float* out) {
+		const float A[4] = { m[0], m[1], m[4], m[5] };
+		const float B[4] = { m[2], m[3], m[6], m[7] };
+		const float C[4] = { m[8], m[9], m[12], m[13] };
+		const float D[4] = { m[10], m[11], m[14], m[15] };
+
+		float detA = m[0] * m[5] - m[1] * m[4];
+		float detB = m[2] * m[7] - m[3] * m[6];
+		float detC = m[8] * m[13] - m[9] * m[12];
+		float detD = m[10] * m[15] - m[11] * m[14];
+
+		float DC[4], AB[4];
+		Mat2AdjMulScalar(D, C, DC);
+		Mat2AdjMulScalar(A, B, AB);
+
+		float X[4], Y[4], Z[4], W[4], t[4];
+		Mat2MulScalar(B, DC, t);
+		for (int i = 0; i < 4; i++)
+			X[i] = detD * A[i] - t[i];
+		Mat2MulScalar(C, AB, t);
+		for (int i = 0; i < 4; i++)
+			W[i] = detA * D[i] - t[i];
+		Mat2MulAdjScalar(D, AB, t);
+		for (int i = 0; i < 4; i++)
+			Y[i] = detB * C[i] - t[i];
+		Mat2MulAdjScalar(A, DC, t);
+		for (int i = 0; i < 4; i++)
+			Z[i] = detC * B[i] - t[i];
+
+		// |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C), summed in the
+		// order of the SSE horizontal add.
+		float tr = (AB[0] * DC[0] + AB[2] * DC[1]) + (AB[1] * DC[2] + AB[3] * DC[3]);
+		float det = (detA * detD + detB * detC) - tr;
+
+		if (det == 0)
+			return false;
+
+		const float rDet[4] = { 1.0f / det, -1.0f / det, -1.0f / det, 1.0f / det };
+		for (int i = 0; i < 4; i++) {
+			X[i] = X[i] * rDet[i];
+			Y[i] = Y[i] * rDet[i];
+			Z[i] = Z[i] * rDet[i];
+			W[i] = W[i] * rDet[i];
+		}
+
+		const float rows[16] = {
+			X[3], X[1], Y[3], Y[1],
+			X[2], X[0], Y[2], Y[0],
+			Z[3], Z[1], W[3], W[1],
+			Z[2], Z[0], W[2], W[0]
+		};
+		for (int i = 0; i < 16; i++)
+			out[i] = rows[i];
+
+		return true;
+	}
+
+	/** Transforms one xyz triplet, shared by all paths for their tails. */
+	template<TransformMode Mode>
+	static inline void TransformOne(const float* m, float x, float y, float z, float* ox, float* oy, float* oz) {
+		float rx = x * m[0] + y * m[1] + z * m[2];
+		float ry = x * m[4] + y * m[5] + z * m[6];
+		float rz = x * m[8] + y * m[9] + z * m[10];
+
+		if (Mode != TransformMode::Vector) {
+			rx = rx + m[3];
+			ry = ry + m[7];
+			rz = rz + m[11];
+		}
+		if (Mode == TransformMode::ProjectPoint) {
+			float w = x * m[12] + y * m[13] + z * m[14] + m[15];
+			rx = rx / w;
+			ry = ry / w;
+			rz = rz / w;
+		}
+
+		*ox = rx;
+		*oy = ry;
+		*oz = rz;
+	}
+
+	template<TransformMode Mode>
+	static void TransformAoSScalar(const float* m, const float* in, size_t inStride, float* out, size_t outStride, size_t count) {
+		for (size_t i = 0; i < count; i++, in += inStride, out += outStride)
+			TransformOne<Mode>(m, in[0], in[1], in[2], out, out + 1, out + 2);
+	}
+
+	template<TransformMode Mode>
+	static void TransformSoAScalar(const float* m,
+		const float* x, const float* y, const float* z,
+		float* outX, float* outY, float* outZ,
+		size_t count) {
+		for (size_t i = 0; i < count; i++)
+			TransformOne<Mode>(m, x[i], y[i], z[i], outX + i, outY + i, outZ + i);
+	}
+
+	/** Tests one volume against the planes, shared by all paths for their tails. */
+	static inline uint8_t CullOne(const float* planes, float x, float y, float z, float radius, float ex, float ey, float ez) {
+		for (int p = 0; p < 6; p++) {
+			const float* plane = planes + p * 4;
+			float d = x * plane[0] + y * plane[1] + z * plane[2] + plane[3];
+			// Projected box radius, the half extents along the plane normal.
+			float extent = ex * std::fabs(plane[0]) + ey * std::fabs(plane[1]) + ez * std::fabs(plane[2]);
+			float r = radius < extent ? radius : extent;
+			if (d < -r)
+				return 0;
+		}
+		return 1;
+	}
+
+	static size_t FrustumCullScalar(const float* planes,
+		const float* x, const float* y, const float* z, const float* radius,
+		const float* ex, const float* ey, const float* ez,
+		size_t count, uint8_t* visible) {
+		size_t visibleCount = 0;
+		for (size_t i = 0; i < count; i++) {
+			visible[i] = CullOne(planes, x[i], y[i], z[i], radius[i], ex[i], ey[i], ez[i]);
+			visibleCount += visible[i];
+		}
+		return visibleCount;
+	}
+
+#ifdef MATHLIB_X86
+
+	/////////////////
+	// SSE KERNELS //
+	/////////////////
+
+	static void MatMulSSE(const float* a, const float* b, float* out) {
+		__m128 b0 = _mm_load_ps(b);
+		__m128 b1 = _mm_load_ps(b + 4);
+		__m128 b2 = _mm_load_ps(b + 8);
+		__m128 b3 = _mm_load_ps(b + 12);
+
+		// Rows are computed before storing so out may alias a or b.
+		__m128 r[4];
+		for (int i = 0; i < 4; i++) {
+			__m128 row = _mm_load_ps(a + i * 4);
+			__m128 acc = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+			r[i] = acc;
+		}
+		for (int i = 0; i < 4; i++)
+			_mm_store_ps(out + i * 4, r[i]);
+	}
+
+	static void MatVecSSE(const float* m, const float* v, float* out) {
+		// Transpose rows into columns so each lane accumulates one row.
+		__m128 c0 = _mm_load_ps(m);
+		__m128 c1 = _mm_load_ps(m + 4);
+		__m128 c2 = _mm_load_ps(m + 8);
+		__m128 c3 = _mm_load_ps(m + 12);
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+		__m128 vec = _mm_load_ps(v);
+		__m128 acc = _mm_mul_ps(_mm_shuffle_ps(vec, vec, _MM_SHUFFLE(0, 0, 0, 0)), c0);
+		acc = _mm_add_ps(acc, _mm_mul_ps(_mm_shuffle_ps(vec, vec, _MM_SHUFFLE(1, 1, 1, 1)), c1));
+		acc = _mm_add_ps(acc, _mm_mul_ps(_mm_shuffle_ps(vec, vec, _MM_SHUFFLE(2, 2, 2, 2)), c2));
+		acc = _mm_add_ps(acc, _mm_mul_ps(_mm_shuffle_ps(vec, vec, _MM_SHUFFLE(3, 3, 3, 3)), c3));
+		_mm_store_ps(out, acc);
+	}
+
+	static void MatScaleSSE(const float* m, float s, float* out) {
+		__m128 scale = _mm_set1_ps(s);
+		for (int i = 0; i < 16; i += 4)
+			_mm_store_ps(out + i, _mm_mul_ps(_mm_load_ps(m + i), scale));
+	}
+
+	// Shuffle helpers for the 2x2 block inverse below.
+#define MATHLIB_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+#define MATHLIB_SWIZZLE(a, x, y, z, w) _mm_shuffle_ps(a, a, _MM_SHUFFLE(w, z, y, x))
+
+	/** 2x2 row major block product a * b. */
+	static inline __m128 Mat2Mul(__m128 a, __m128 b) {
+		return _mm_add_ps(
+			_mm_mul_ps(a, MATHLIB_SWIZZLE(b, 0, 3, 0, 3)),
+			_mm_mul_ps(MATHLIB_SWIZZLE(a, 1, 0, 3, 2), MATHLIB_SWIZZLE(b, 2, 1, 2, 1)));
+	}
+
+	/** 2x2 row major block product adj(a) * b. */
+	static inline __m128 Mat2AdjMul(__m128 a, __m128 b) {
+		return _mm_sub_ps(
+			_mm_mul_ps(MATHLIB_SWIZZLE(a, 3, 3, 0, 0), b),
+			_mm_mul_ps(MATHLIB_SWIZZLE(a, 1, 1, 2, 2), MATHLIB_SWIZZLE(b, 2, 3, 0, 1)));
+	}
+
+	/** 2x2 row major block product a * adj(b). */
+	static inline __m128 Mat2MulAdj(__m128 a, __m128 b) {
+		return _mm_sub_ps(
+			_mm_mul_ps(a, MATHLIB_SWIZZLE(b, 3, 0, 3, 0)),
+			_mm_mul_ps(MATHLIB_SWIZZLE(a, 1, 0, 3, 2), MATHLIB_SWIZZLE(b, 2, 1, 2, 1)));
+	}
+
+	/**
+	 * Block wise inverse, the matrix is split into four 2x2 blocks
+	 * A B / C D and the 2x2 sub determinants are shared between the
+	 * adjugate and the final determinant.
+	 */
+	static bool InverseSSE(const float* m, float* out) {
+		__m128 r0 = _mm_load_ps(m);
+		__m128 r1 = _mm_load_ps(m + 4);
+		__m128 r2 = _mm_load_ps(m + 8);
+		__m128 r3 = _mm_load_ps(m + 12);
+
+		__m128 A = _mm_movelh_ps(r0, r1);
+		__m128 B = _mm_movehl_ps(r1, r0);
+		__m128 C = _mm_movelh_ps(r2, r3);
+		__m128 D = _mm_movehl_ps(r3, r2);
+
+		// Determinants of A, B, C and D in one go.
+		__m128 detSub = _mm_sub_ps(
+			_mm_mul_ps(MATHLIB_SHUFFLE(r0, r2, 0, 2, 0, 2), MATHLIB_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+			_mm_mul_ps(MATHLIB_SHUFFLE(r0, r2, 1, 3, 1, 3), MATHLIB_SHUFFLE(r1, r3, 0, 2, 0, 2)));
+		__m128 detA = MATHLIB_SWIZZLE(detSub, 0, 0, 0, 0);
+		__m128 detB = MATHLIB_SWIZZLE(detSub, 1, 1, 1, 1);
+		__m128 detC = MATHLIB_SWIZZLE(detSub, 2, 2, 2, 2);
+		__m128 detD = MATHLIB_SWIZZLE(detSub, 3, 3, 3, 3);
+
+		__m128 DC = Mat2AdjMul(D, C);
+		__m128 AB = Mat2AdjMul(A, B);
+
+		__m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, DC));
+		__m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, AB));
+		__m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, AB));
+		__m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, DC));
+
+		// |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+		__m128 tr = _mm_mul_ps(AB, MATHLIB_SWIZZLE(DC, 0, 2, 1, 3));
+		tr = _mm_add_ps(tr, MATHLIB_SWIZZLE(tr, 2, 3, 0, 1));
+		tr = _mm_add_ps(tr, MATHLIB_SWIZZLE(tr, 1, 0, 3, 2));
+		__m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+
+		if (_mm_cvtss_f32(det) == 0)
+			return false;
+
+		__m128 rDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+		X = _mm_mul_ps(X, rDet);
+		Y = _mm_mul_ps(Y, rDet);
+		Z = _mm_mul_ps(Z, rDet);
+		W = _mm_mul_ps(W, rDet);
+
+		_mm_store_ps(out, MATHLIB_SHUFFLE(X, Y, 3, 1, 3, 1));
+		_mm_store_ps(out + 4, MATHLIB_SHUFFLE(X, Y, 2, 0, 2, 0));
+		_mm_store_ps(out + 8, MATHLIB_SHUFFLE(Z, W, 3, 1, 3, 1));
+		_mm_store_ps(out + 12, MATHLIB_SHUFFLE(Z, W, 2, 0, 2, 0));
+
+		return true;
+	}
+
+#undef MATHLIB_SHUFFLE
+#undef MATHLIB_SWIZZLE
+
+	template<TransformMode Mode>
+	static void TransformAoSSSE(const float* m, const float* in, size_t inStride, float* out, size_t outStride, size_t count) {
+		__m128 c0 = _mm_loadu_ps(m);
+		__m128 c1 = _mm_loadu_ps(m + 4);
+		__m128 c2 = _mm_loadu_ps(m + 8);
+		__m128 c3 = _mm_loadu_ps(m + 12);
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+		for (size_t i = 0; i < count; i++, in += inStride, out += outStride) {
+			__m128 acc = _mm_mul_ps(_mm_set1_ps(in[0]), c0);
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(in[1]), c1));
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(in[2]), c2));
+
+			if (Mode != TransformMode::Vector)
+				acc = _mm_add_ps(acc, c3);
+			if (Mode == TransformMode::ProjectPoint)
+				acc = _mm_div_ps(acc, _mm_shuffle_ps(acc, acc, _MM_SHUFFLE(3, 3, 3, 3)));
+
+			// Only xyz, a fourth float would step on the next element.
+			_mm_storel_pi((__m64*)out, acc);
+			_mm_store_ss(out + 2, _mm_movehl_ps(acc, acc));
+		}
+	}
+
+	template<TransformMode Mode>
+	static void TransformSoASSE(const float* m,
+		const float* x, const float* y, const float* z,
+		float* outX, float* outY, float* outZ,
+		size_t count) {
+		__m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]), m3 = _mm_set1_ps(m[3]);
+		__m128 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]), m6 = _mm_set1_ps(m[6]), m7 = _mm_set1_ps(m[7]);
+		__m128 m8 = _mm_set1_ps(m[8]), m9 = _mm_set1_ps(m[9]), m10 = _mm_set1_ps(m[10]), m11 = _mm_set1_ps(m[11]);
+		__m128 m12 = _mm_set1_ps(m[12]), m13 = _mm_set1_ps(m[13]), m14 = _mm_set1_ps(m[14]), m15 = _mm_set1_ps(m[15]);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			__m128 vx = _mm_loadu_ps(x + i);
+			__m128 vy = _mm_loadu_ps(y + i);
+			__m128 vz = _mm_loadu_ps(z + i);
+
+			__m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m0), _mm_mul_ps(vy, m1)), _mm_mul_ps(vz, m2));
+			__m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m4), _mm_mul_ps(vy, m5)), _mm_mul_ps(vz, m6));
+			__m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m8), _mm_mul_ps(vy, m9)), _mm_mul_ps(vz, m10));
+
+			if (Mode != TransformMode::Vector) {
+				rx = _mm_add_ps(rx, m3);
+				ry = _mm_add_ps(ry, m7);
+				rz = _mm_add_ps(rz, m11);
+			}
+			if (Mode == TransformMode::ProjectPoint) {
+				__m128 w = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m12), _mm_mul_ps(vy, m13)), _mm_mul_ps(vz, m14)), m15);
+				rx = _mm_div_ps(rx, w);
+				ry = _mm_div_ps(ry, w);
+				rz = _mm_div_ps(rz, w);
+			}
+
+			_mm_storeu_ps(outX + i, rx);
+			_mm_storeu_ps(outY + i, ry);
+			_mm_storeu_ps(outZ + i, rz);
+		}
+		for (; i < count; i++)
+			TransformOne<Mode>(m, x[i], y[i], z[i], outX + i, outY + i, outZ + i);
+	}
+
+	static size_t FrustumCullSSE(const float* planes,
+		const float* x, const float* y, const float* z, const float* radius,
+		const float* ex, const float* ey, const float* ez,
+		size_t count, uint8_t* visible) {
+		__m128 a[6], b[6], c[6], d[6], absA[6], absB[6], absC[6];
+		for (int p = 0; p < 6; p++) {
+			a[p] = _mm_set1_ps(planes[p * 4]);
+			b[p] = _mm_set1_ps(planes[p * 4 + 1]);
+			c[p] = _mm_set1_ps(planes[p * 4 + 2]);
+			d[p] = _mm_set1_ps(planes[p * 4 + 3]);
+			absA[p] = _mm_set1_ps(std::fabs(planes[p * 4]));
+			absB[p] = _mm_set1_ps(std::fabs(planes[p * 4 + 1]));
+			absC[p] = _mm_set1_ps(std::fabs(planes[p * 4 + 2]));
+		}
+		__m128 sign = _mm_set1_ps(-0.0f);
+
+		size_t visibleCount = 0;
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			__m128 vx = _mm_loadu_ps(x + i);
+			__m128 vy = _mm_loadu_ps(y + i);
+			__m128 vz = _mm_loadu_ps(z + i);
+			__m128 vr = _mm_loadu_ps(radius + i);
+			__m128 vex = _mm_loadu_ps(ex + i);
+			__m128 vey = _mm_loadu_ps(ey + i);
+			__m128 vez = _mm_loadu_ps(ez + i);
+
+			__m128 outside = _mm_setzero_ps();
+			for (int p = 0; p < 6; p++) {
+				__m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, a[p]), _mm_mul_ps(vy, b[p])), _mm_mul_ps(vz, c[p])), d[p]);
+				__m128 extent = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vex, absA[p]), _mm_mul_ps(vey, absB[p])), _mm_mul_ps(vez, absC[p]));
+				__m128 r = _mm_min_ps(vr, extent);
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, _mm_xor_ps(r, sign)));
+			}
+
+			int mask = _mm_movemask_ps(outside);
+			for (int k = 0; k < 4; k++) {
+				visible[i + k] = (uint8_t)(((mask >> k) & 1) ^ 1);
+				visibleCount += visible[i + k];
+			}
+		}
+		for (; i < count; i++) {
+			visible[i] = CullOne(planes, x[i], y[i], z[i], radius[i], ex[i], ey[i], ez[i]);
+			visibleCount += visible[i];
+		}
+		return visibleCount;
+	}
+
+	/////////////////
+	// AVX KERNELS //
+	/////////////////
+
+	// No FMA on purpose, fused rounding would break bit identical results.
+
+	MATHLIB_TARGET_AVX
+	static void MatMulAVX(const float* a, const float* b, float* out) {
+		// Every row of b duplicated into both 128 bit lanes.
+		__m256 b0 = _mm256_broadcast_ps((const __m128*)(b));
+		__m256 b1 = _mm256_broadcast_ps((const __m128*)(b + 4));
+		__m256 b2 = _mm256_broadcast_ps((const __m128*)(b + 8));
+		__m256 b3 = _mm256_broadcast_ps((const __m128*)(b + 12));
+
+		// Two rows of a per register.
+		__m256 a01 = _mm256_loadu_ps(a);
+		__m256 a23 = _mm256_loadu_ps(a + 8);
+
+		__m256 r01 = _mm256_mul_ps(_mm256_permute_ps(a01, 0x00), b0);
+		r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_permute_ps(a01, 0x55), b1));
+		r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_permute_ps(a01, 0xAA), b2));
+		r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_permute_ps(a01, 0xFF), b3));
+
+		__m256 r23 = _mm256_mul_ps(_mm256_permute_ps(a23, 0x00), b0);
+		r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_permute_ps(a23, 0x55), b1));
+		r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_permute_ps(a23, 0xAA), b2));
+		r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_permute_ps(a23, 0xFF), b3));
+
+		_mm256_storeu_ps(out, r01);
+		_mm256_storeu_ps(out + 8, r23);
+		_mm256_zeroupper();
+	}
+
+	MATHLIB_TARGET_AVX
+	static void MatScaleAVX(const float* m, float s, float* out) {
+		__m256 scale = _mm256_set1_ps(s);
+		_mm256_storeu_ps(out, _mm256_mul_ps(_mm256_loadu_ps(m), scale));
+		_mm256_storeu_ps(out + 8, _mm256_mul_ps(_mm256_loadu_ps(m + 8), scale));
+		_mm256_zeroupper();
+	}
+
+	template<TransformMode Mode>
+	MATHLIB_TARGET_AVX
+	static void TransformSoAAVX(const float* m,
+		const float* x, const float* y, const float* z,
+		float* outX, float* outY, float* outZ,
+		size_t count) {
+		__m256 m0 = _mm256_set1_ps(m[0]), m1 = _mm256_set1_ps(m[1]), m2 = _mm256_set1_ps(m[2]), m3 = _mm256_set1_ps(m[3]);
+		__m256 m4 = _mm256_set1_ps(m[4]), m5 = _mm256_set1_ps(m[5]), m6 = _mm256_set1_ps(m[6]), m7 = _mm256_set1_ps(m[7]);
+		__m256 m8 = _mm256_set1_ps(m[8]), m9 = _mm256_set1_ps(m[9]), m10 = _mm256_set1_ps(m[10]), m11 = _mm256_set1_ps(m[11]);
+		__m256 m12 = _mm256_set1_ps(m[12]), m13 = _mm256_set1_ps(m[13]), m14 = _mm256_set1_ps(m[14]), m15 = _mm256_set1_ps(m[15]);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m256 vx = _mm256_loadu_ps(x + i);
+			__m256 vy = _mm256_loadu_ps(y + i);
+			__m256 vz = _mm256_loadu_ps(z + i);
+
+			__m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, m0), _mm256_mul_ps(vy, m1)), _mm256_mul_ps(vz, m2));
+			__m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, m4), _mm256_mul_ps(vy, m5)), _mm256_mul_ps(vz, m6));
+			__m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, m8), _mm256_mul_ps(vy, m9)), _mm256_mul_ps(vz, m10));
+
+			if (Mode != TransformMode::Vector) {
+				rx = _mm256_add_ps(rx, m3);
+				ry = _mm256_add_ps(ry, m7);
+				rz = _mm256_add_ps(rz, m11);
+			}
+			if (Mode == TransformMode::ProjectPoint) {
+				__m256 w = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, m12), _mm256_mul_ps(vy, m13)), _mm256_mul_ps(vz, m14)), m15);
+				rx = _mm256_div_ps(rx, w);
+				ry = _mm256_div_ps(ry, w);
+				rz = _mm256_div_ps(rz, w);
+			}
+
+			_mm256_storeu_ps(outX + i, rx);
+			_mm256_storeu_ps(outY + i, ry);
+			_mm256_storeu_ps(outZ + i, rz);
+		}
+		_mm256_zeroupper();
+
+		for (; i < count; i++)
+			TransformOne<Mode>(m, x[i], y[i], z[i], outX + i, outY + i, outZ + i);
+	}
+
+	MATHLIB_TARGET_AVX
+	static size_t FrustumCullAVX(const float* planes,
+		const float* x, const float* y, const float* z, const float* radius,
+		const float* ex, const float* ey, const float* ez,
+		size_t count, uint8_t* visible) {
+		__m256 a[6], b[6], c[6], d[6], absA[6], absB[6], absC[6];
+		for (int p = 0; p < 6; p++) {
+			a[p] = _mm256_set1_ps(planes[p * 4]);
+			b[p] = _mm256_set1_ps(planes[p * 4 + 1]);
+			c[p] = _mm256_set1_ps(planes[p * 4 + 2]);
+			d[p] = _mm256_set1_ps(planes[p * 4 + 3]);
+			absA[p] = _mm256_set1_ps(std::fabs(planes[p * 4]));
+			absB[p] = _mm256_set1_ps(std::fabs(planes[p * 4 + 1]));
+			absC[p] = _mm256_set1_ps(std::fabs(planes[p * 4 + 2]));
+		}
+		__m256 sign = _mm256_set1_ps(-0.0f);
+
+		size_t visibleCount = 0;
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m256 vx = _mm256_loadu_ps(x + i);
+			__m256 vy = _mm256_loadu_ps(y + i);
+			__m256 vz = _mm256_loadu_ps(z + i);
+			__m256 vr = _mm256_loadu_ps(radius + i);
+			__m256 vex = _mm256_loadu_ps(ex + i);
+			__m256 vey = _mm256_loadu_ps(ey + i);
+			__m256 vez = _mm256_loadu_ps(ez + i);
+
+			__m256 outside = _mm256_setzero_ps();
+			for (int p = 0; p < 6; p++) {
+				__m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, a[p]), _mm256_mul_ps(vy, b[p])), _mm256_mul_ps(vz, c[p])), d[p]);
+				__m256 extent = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vex, absA[p]), _mm256_mul_ps(vey, absB[p])), _mm256_mul_ps(vez, absC[p]));
+				__m256 r = _mm256_min_ps(vr, extent);
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(dist, _mm256_xor_ps(r, sign), _CMP_LT_OQ));
+			}
+
+			int mask = _mm256_movemask_ps(outside);
+			for (int k = 0; k < 8; k++) {
+				visible[i + k] = (uint8_t)(((mask >> k) & 1) ^ 1);
+				visibleCount += visible[i + k];
+			}
+		}
+		_mm256_zeroupper();
+
+		for (; i < count; i++) {
+			visible[i] = CullOne(planes, x[i], y[i], z[i], radius[i], ex[i], ey[i], ez[i]);
+			visibleCount += visible[i];
+		}
+		return visibleCount;
+	}
+
+#endif
+
+	////////////////////
+	// CPU DETECTION  //
+	////////////////////
+
+	Level DetectLevel() {
+#if defined(MATHLIB_X86) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		bool sse = (info[3] & (1 << 25)) != 0;
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		// The OS has to save the upper ymm registers as well.
+		if (osxsave && avx && (_xgetbv(0) & 0x6) == 0x6)
+			return Level::AVX;
+		return sse ? Level::SSE : Level::Scalar;
+#elif defined(MATHLIB_X86) && (defined(__GNUC__) || defined(__clang__))
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx"))
+			return Level::AVX;
+		if (__builtin_cpu_supports("sse"))
+			return Level::SSE;
+		return Level::Scalar;
+#else
+		return Level::Scalar;
+#endif
+	}
+
+	/** The dispatch table, one entry per kernel. */
+	struct Kernels {
+		Level level;
+		void (*matMul)(const float*, const float*, float*);
+		void (*matVec)(const float*, const float*, float*);
+		void (*matScale)(const float*, float, float*);
+		bool (*inverse)(const float*, float*);
+		void (*transformAoS[3])(const float*, const float*, size_t, float*, size_t, size_t);
+		void (*transformSoA[3])(const float*, const float*, const float*, const float*, float*, float*, float*, size_t);
+		size_t (*frustumCull)(const float*, const float*, const float*, const float*, const float*, const float*, const float*, const float*, size_t, uint8_t*);
+	};
+
+	// Constant initialized so anything running before static init still
+	// gets the (bit identical) scalar path.
+	static Kernels active = {
+		Level::Scalar,
+		MatMulScalar,
+		MatVecScalar,
+		MatScaleScalar,
+		InverseScalar,
+		{
+			TransformAoSScalar<TransformMode::Point>,
+			TransformAoSScalar<TransformMode::Vector>,
+			TransformAoSScalar<TransformMode::ProjectPoint>
+		},
+		{
+			TransformSoAScalar<TransformMode::Point>,
+			TransformSoAScalar<TransformMode::Vector>,
+			TransformSoAScalar<TransformMode::ProjectPoint>
+		},
+		FrustumCullScalar
+	};
+
+	void SetLevel(Level level) {
+		Level supported = DetectLevel();
+		if ((int)level > (int)supported)
+			level = supported;
+
+		active.level = level;
+		active.matMul = MatMulScalar;
+		active.matVec = MatVecScalar;
+		active.matScale = MatScaleScalar;
+		active.inverse = InverseScalar;
+		active.transformAoS[0] = TransformAoSScalar<TransformMode::Point>;
+		active.transformAoS[1] = TransformAoSScalar<TransformMode::Vector>;
+		active.transformAoS[2] = TransformAoSScalar<TransformMode::ProjectPoint>;
+		active.transformSoA[0] = TransformSoAScalar<TransformMode::Point>;
+		active.transformSoA[1] = TransformSoAScalar<TransformMode::Vector>;
+		active.transformSoA[2] = TransformSoAScalar<TransformMode::ProjectPoint>;
+		active.frustumCull = FrustumCullScalar;
+
+#ifdef MATHLIB_X86
+		if (level >= Level::SSE) {
+			active.matMul = MatMulSSE;
+			active.matVec = MatVecSSE;
+			active.matScale = MatScaleSSE;
+			active.inverse = InverseSSE;
+			active.transformAoS[0] = TransformAoSSSE<TransformMode::Point>;
+			active.transformAoS[1] = TransformAoSSSE<TransformMode::Vector>;
+			active.transformAoS[2] = TransformAoSSSE<TransformMode::ProjectPoint>;
+			active.transformSoA[0] = TransformSoASSE<TransformMode::Point>;
+			active.transformSoA[1] = TransformSoASSE<TransformMode::Vector>;
+			active.transformSoA[2] = TransformSoASSE<TransformMode::ProjectPoint>;
+			active.frustumCull = FrustumCullSSE;
+		}
+		if (level >= Level::AVX) {
+			active.matMul = MatMulAVX;
+			// A single 4 wide dot product gains nothing from 256 bits,
+			// and strided AoS input is bound by the scalar loads anyway.
+			active.matScale = MatScaleAVX;
+			active.transformSoA[0] = TransformSoAAVX<TransformMode::Point>;
+			active.transformSoA[1] = TransformSoAAVX<TransformMode::Vector>;
+			active.transformSoA[2] = TransformSoAAVX<TransformMode::ProjectPoint>;
+			active.frustumCull = FrustumCullAVX;
+		}
+#endif
+	}
+
+	Level GetLevel() {
+		return active.level;
+	}
+
+	const char* LevelName(Level level) {
+		switch (level) {
+		case Level::SSE: return "SSE";
+		case Level::AVX: return "AVX";
+		default: return "Scalar";
+		}
+	}
+
+	// Pick the best kernels once at startup.
+	static struct LevelInit {
+		LevelInit() { SetLevel(DetectLevel()); }
+	} levelInit;
+
+	void MatMul(const float* a, const float* b, float* out) {
+		active.matMul(a, b, out);
+	}
+
+	void MatVec(const float* m, const float* v, float* out) {
+		active.matVec(m, v, out);
+	}
+
+	void MatScale(const float* m, float s, float* out) {
+		active.matScale(m, s, out);
+	}
+
+	bool Inverse(const float* m, float* out) {
+		return active.inverse(m, out);
+	}
+
+	void TransformAoS(const float* m, const float* in, size_t inStride, float* out, size_t outStride, size_t count, TransformMode mode) {
+		active.transformAoS[(int)mode](m, in, inStride, out, outStride, count);
+	}
+
+	void TransformSoA(const float* m,
+		const float* x, const float* y, const float* z,
+		float* outX, float* outY, float* outZ,
+		size_t count, TransformMode mode) {
+		active.transformSoA[(int)mode](m, x, y, z, outX, outY, outZ, count);
+	}
+
+	size_t FrustumCull(const float* planes,
+		const float* x, const float* y, const float* z, const float* radius,
+		const float* ex, const float* ey, const float* ez,
+		size_t count, uint8_t* visible) {
+		return active.frustumCull(planes, x, y, z, radius, ex, ey, ez, count, visible);
+	}
+}
+}
\ No newline at end of file
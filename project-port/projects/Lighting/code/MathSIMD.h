@@ -0,0 +1,132 @@
+#pragma once
+
+/**
+ * @file
+ * @author Emil Lindgren
+ * @version 0.1
+ *
+ * @section DESCRIPTION
+ *
+ * Vectorized kernels used by "matlib".
+ *
+ * Every kernel works on raw, 16 byte aligned float arrays laid out the
+ * same way as MathLib::Mat4 (four rows of four floats) and MathLib::Vec4.
+ * The instruction set is picked once at startup from the CPU features,
+ * and the scalar fallback performs the exact same operations in the same
+ * order so all paths return bit identical results.
+ */
+
+// C headers
+#include <cstddef>
+#include <cstdint>
+
+
+namespace MathLib {
+namespace SIMD {
+
+	/** The instruction set used by the kernels. */
+	enum class Level {
+		/** Plain C++, no intrinsics. */
+		Scalar,
+		/** 128 bit SSE kernels. */
+		SSE,
+		/** 256 bit AVX kernels. */
+		AVX
+	};
+
+	/** Returns the best instruction set supported by this CPU. */
+	Level DetectLevel();
+
+	/** Returns the instruction set currently used by the kernels. */
+	Level GetLevel();
+
+	/**
+	 * Forces the kernels to a specific instruction set.
+	 *
+	 * Levels not supported by the CPU are clamped to the detected level.
+	 */
+	void SetLevel(Level level);
+
+	/** Returns a printable name of an instruction set. */
+	const char* LevelName(Level level);
+
+	/** out = a * b, all three are 16 float row major matrices. */
+	void MatMul(const float* a, const float* b, float* out);
+
+	/** out = m * v, m is a 16 float matrix and v a 4 float vector. */
+	void MatVec(const float* m, const float* v, float* out);
+
+	/** out = m * s for every element of a 16 float matrix. */
+	void MatScale(const float* m, float s, float* out);
+
+	/**
+	 * General 4x4 inverse, out = m^-1.
+	 *
+	 * The cofactors are computed once and reused for the determinant.
+	 *
+	 * @returns false and leaves out untouched if m is singular.
+	 */
+	bool Inverse(const float* m, float* out);
+
+	/** How the batch transforms treat their xyz input. */
+	enum class TransformMode {
+		/** Points, w = 1 so translation applies. */
+		Point,
+		/** Directions, w = 0 so translation is ignored. */
+		Vector,
+		/** Points followed by a perspective divide with the resulting w. */
+		ProjectPoint
+	};
+
+	/**
+	 * Transforms an interleaved (AoS) array of xyz triplets by m.
+	 *
+	 * Strides are counted in floats. ResourceLib::Attribute offsets and
+	 * strides are in bytes, so a Type::Float attribute is passed with both
+	 * divided by sizeof(float). Compact types have to be decoded first,
+	 * see ResourceLib::VertexFormat::DecodeArray().
+	 * Only the three xyz floats of each output element are written and
+	 * in and out may be the same array if the strides match.
+	 *
+	 * @param m is the 16 float matrix.
+	 * @param in is the first input element.
+	 * @param inStride is the distance in floats between input elements.
+	 * @param out is the first output element.
+	 * @param outStride is the distance in floats between output elements.
+	 * @param count is the number of elements.
+	 * @param mode decides how w and the divide is handled.
+	 */
+	void TransformAoS(const float* m, const float* in, size_t inStride, float* out, size_t outStride, size_t count, TransformMode mode);
+
+	/**
+	 * Transforms separate (SoA) x, y and z arrays by m.
+	 *
+	 * Outputs may alias their matching inputs.
+	 */
+	void TransformSoA(const float* m,
+		const float* x, const float* y, const float* z,
+		float* outX, float* outY, float* outZ,
+		size_t count, TransformMode mode);
+
+	/**
+	 * Tests SoA bounding volumes against six planes, e.g. a view frustum.
+	 *
+	 * Each volume is a sphere and an axis aligned box sharing one center.
+	 * A volume is culled when either of them lies fully on the outer side
+	 * of any plane, so the tighter of the two decides per plane.
+	 *
+	 * @param planes is six (a, b, c, d) planes with inward unit normals,
+	 * see Mat4::FrustumPlanes().
+	 * @param x, y and z are the centers.
+	 * @param radius is the sphere radii.
+	 * @param ex, ey and ez are the box half extents.
+	 * @param count is the number of volumes.
+	 * @param visible receives 1 for volumes that may be visible, 0 for culled.
+	 * @returns the number of visible volumes.
+	 */
+	size_t FrustumCull(const float* planes,
+		const float* x, const float* y, const float* z, const float* radius,
+		const float* ex, const float* ey, const float* ez,
+		size_t count, uint8_t* visible);
+}
+}
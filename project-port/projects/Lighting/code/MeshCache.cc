@@ -0,0 +1,174 @@
+#include "MeshCache.h"
+#include "MeshResource.h"
+
+#include <cstdio>
+#include <cstring>
+
+const char* const ResourceLib::MeshCache::Extension = ".mesh";
+
+static const char magic[4] = { 'L', 'M', 'S', 'H' };
+
+/** Rounds up to a multiple of the blob alignment. */
+static uint64_t Align(uint64_t offset) {
+	const uint64_t alignment = ResourceLib::MeshCache::BlobAlignment;
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+uint64_t ResourceLib::MeshCache::Hash(const char* data, size_t size) {
+	// Eight bytes per step, multiply and fold, a few GB/s.
+	const uint64_t prime = 0x9E3779B97F4A7C15ull;
+	uint64_t h = 0xCBF29CE484222325ull ^ (uint64_t)size;
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		uint64_t word;
+		memcpy(&word, data + i, 8);
+		h = (h ^ word) * prime;
+		h ^= h >> 29;
+	}
+	for (; i < size; i++)
+		h = (h ^ (unsigned char)data[i]) * prime;
+	h ^= h >> 32;
+	return h;
+}
+
+bool ResourceLib::MeshCache::Read(const std::string& path, uint64_t sourceHash, uint64_t sourceSize, MeshResource& mesh) {
+	std::shared_ptr<MappedFile> file(new MappedFile());
+	if (!file->Open(path) || file->Size() < sizeof(Header))
+		return false;
+
+	Header header;
+	memcpy(&header, file->Data(), sizeof(Header));
+	if (memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != Version)
+		return false;
+	if (header.sourceHash != sourceHash || header.sourceSize != sourceSize)
+		return false;
+
+	// Truncated by a crash or a full disk.
+	uint64_t attributeEnd = sizeof(Header) + (uint64_t)header.attributeCount * sizeof(AttributeRecord);
+	uint64_t lodEnd = attributeEnd + (uint64_t)header.lodCount * sizeof(LodRecord);
+	if (lodEnd > file->Size() ||
+		header.vertexOffset % BlobAlignment != 0 || header.indexOffset % BlobAlignment != 0 ||
+		(header.indexSize != 2 && header.indexSize != 4) ||
+		header.vertexOffset + header.vertexBytes > file->Size() ||
+		header.indexOffset + header.indexCount * header.indexSize > file->Size())
+		return false;
+
+	std::vector<MeshResource::Lod> lods(header.lodCount);
+	for (uint32_t i = 0; i < header.lodCount; i++) {
+		LodRecord record;
+		memcpy(&record, file->Data() + attributeEnd + i * sizeof(LodRecord), sizeof(record));
+		if (record.indexOffset + record.indexCount > header.indexCount)
+			return false;
+		lods[i].indexOffset = (size_t)record.indexOffset;
+		lods[i].indexCount = (size_t)record.indexCount;
+		lods[i].error = record.error;
+	}
+
+	std::vector<AttributeRecord> records(header.attributeCount);
+	for (uint32_t i = 0; i < header.attributeCount; i++) {
+		memcpy(&records[i], file->Data() + sizeof(Header) + i * sizeof(AttributeRecord), sizeof(AttributeRecord));
+		if (records[i].type >= (uint8_t)Attribute::Type::Count)
+			return false;
+	}
+
+	mesh.attributes.clear();
+	for (uint32_t i = 0; i < header.attributeCount; i++) {
+		AttributeRecord& record = records[i];
+		record.name[sizeof(record.name) - 1] = '\0';
+		mesh.attributes.push_back(Attribute(record.length, record.offset, record.stride, record.name,
+			(Attribute::Type)record.type, record.normalized != 0));
+	}
+	mesh.lods.swap(lods);
+
+	mesh.mode = (MeshResource::Mode)header.mode;
+	for (int k = 0; k < 3; k++) {
+		mesh.boundsCenter[k] = header.boundsCenter[k];
+		mesh.boundsExtents[k] = header.boundsExtents[k];
+	}
+	mesh.boundsRadius = header.boundsRadius;
+
+	mesh.data.clear();
+	mesh.packedData.clear();
+	mesh.indices.clear();
+	mesh.packedIndices.clear();
+	mesh.mappedData = (const uint8_t*)(file->Data() + header.vertexOffset);
+	mesh.mappedDataSize = (size_t)header.vertexBytes;
+	mesh.mappedIndices = file->Data() + header.indexOffset;
+	mesh.indicesCount = (size_t)header.indexCount;
+	mesh.indexSize = header.indexSize;
+	mesh.mapping = file;
+	return true;
+}
+
+bool ResourceLib::MeshCache::Write(const std::string& path, uint64_t sourceHash, uint64_t sourceSize, const MeshResource& mesh) {
+	Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, magic, sizeof(magic));
+	header.version = Version;
+	header.sourceHash = sourceHash;
+	header.sourceSize = sourceSize;
+	header.mode = (uint32_t)mesh.mode;
+	header.attributeCount = (uint32_t)mesh.attributes.size();
+	uint64_t tableEnd = sizeof(Header) + mesh.attributes.size() * sizeof(AttributeRecord) + mesh.lods.size() * sizeof(LodRecord);
+	header.vertexOffset = Align(tableEnd);
+	header.vertexBytes = mesh.GetVertexDataSize();
+	header.indexOffset = Align(header.vertexOffset + header.vertexBytes);
+	header.indexCount = mesh.GetIndexCount();
+	header.indexSize = (uint32_t)mesh.indexSize;
+	for (int k = 0; k < 3; k++) {
+		header.boundsCenter[k] = mesh.boundsCenter[k];
+		header.boundsExtents[k] = mesh.boundsExtents[k];
+	}
+	header.boundsRadius = mesh.boundsRadius;
+	header.lodCount = (uint32_t)mesh.lods.size();
+
+	std::string temporary = path + ".tmp";
+	FILE* file = fopen(temporary.c_str(), "wb");
+	if (file == nullptr)
+		return false;
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	for (size_t i = 0; i < mesh.attributes.size() && ok; i++) {
+		const Attribute& attribute = mesh.attributes[i];
+		AttributeRecord record;
+		memset(&record, 0, sizeof(record));
+		record.length = (uint32_t)attribute.length;
+		record.offset = (uint32_t)attribute.offset;
+		record.stride = (uint32_t)attribute.stride;
+		record.type = (uint8_t)attribute.type;
+		record.normalized = attribute.normalized ? 1 : 0;
+		strncpy(record.name, attribute.name.c_str(), sizeof(record.name) - 1);
+		ok = fwrite(&record, sizeof(record), 1, file) == 1;
+	}
+
+	for (size_t i = 0; i < mesh.lods.size() && ok; i++) {
+		LodRecord record;
+		memset(&record, 0, sizeof(record));
+		record.indexOffset = mesh.lods[i].indexOffset;
+		record.indexCount = mesh.lods[i].indexCount;
+		record.error = mesh.lods[i].error;
+		ok = fwrite(&record, sizeof(record), 1, file) == 1;
+	}
+
+	static const char padding[BlobAlignment] = {};
+	uint64_t written = tableEnd;
+	ok = ok && fwrite(padding, 1, (size_t)(header.vertexOffset - written), file) == header.vertexOffset - written;
+	ok = ok && fwrite(mesh.GetVertexData(), 1, (size_t)header.vertexBytes, file) == header.vertexBytes;
+	written = header.vertexOffset + header.vertexBytes;
+	ok = ok && fwrite(padding, 1, (size_t)(header.indexOffset - written), file) == header.indexOffset - written;
+	ok = ok && fwrite(mesh.GetIndexData(), mesh.indexSize, (size_t)header.indexCount, file) == header.indexCount;
+
+	ok = fclose(file) == 0 && ok;
+	if (!ok) {
+		remove(temporary.c_str());
+		return false;
+	}
+
+	// Readers only ever see a complete cache. Windows won't rename over a file.
+	remove(path.c_str());
+	if (rename(temporary.c_str(), path.c_str()) != 0) {
+		remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
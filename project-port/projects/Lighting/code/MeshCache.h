@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ResourceLib {
+
+	class MeshResource;
+
+	/**
+	 * Cooked binary meshes, written next to their source on first load.
+	 *
+	 * The file is a header, the attribute layout and levels of detail, then
+	 * the vertex and index blobs each aligned to BlobAlignment, so a mapped
+	 * cache is used in place: MeshResource points into the mapped pages and
+	 * uploads from them without a copy. The header keeps the bounds, and a hash and the
+	 * size of the source so an edited source is cooked again.
+	 */
+	class MeshCache {
+	public:
+		/** Appended to the source filename. */
+		static const char* const Extension;
+
+		/** Bumped whenever the layout below or the cooking changes. */
+		static const uint32_t Version = 4;
+
+		/** Alignment of the blobs from the start of the file. */
+		static const size_t BlobAlignment = 64;
+
+		/** A fast 64 bit hash of the source contents. */
+		static uint64_t Hash(const char* data, size_t size);
+
+		/** The cache path for a source file. */
+		static std::string PathFor(const std::string& source) {
+			return source + Extension;
+		}
+
+		/**
+		 * Maps a cache into a mesh.
+		 *
+		 * @returns false if it's missing, truncated, from another version
+		 * or cooked from other source contents. The mesh is untouched then.
+		 */
+		static bool Read(const std::string& path, uint64_t sourceHash, uint64_t sourceSize, MeshResource& mesh);
+
+		/**
+		 * Cooks a loaded mesh, through a temporary file renamed into place.
+		 *
+		 * @returns false if it couldn't be written, e.g. a read only folder.
+		 */
+		static bool Write(const std::string& path, uint64_t sourceHash, uint64_t sourceSize, const MeshResource& mesh);
+
+	private:
+		struct Header {
+			char magic[4];
+			uint32_t version;
+			uint64_t sourceHash;
+			uint64_t sourceSize;
+			uint32_t mode;
+			uint32_t attributeCount;
+			uint64_t vertexOffset;
+			uint64_t vertexBytes;
+			uint64_t indexOffset;
+			uint64_t indexCount;
+			float boundsCenter[3];
+			float boundsExtents[3];
+			float boundsRadius;
+			uint32_t lodCount;
+			uint32_t indexSize;
+			uint32_t reserved;
+		};
+
+		struct AttributeRecord {
+			uint32_t length;
+			uint32_t offset;
+			uint32_t stride;
+			uint8_t type;
+			uint8_t normalized;
+			char name[18];
+		};
+
+		struct LodRecord {
+			uint64_t indexOffset;
+			uint64_t indexCount;
+			float error;
+			uint32_t reserved;
+		};
+	};
+}
@@ -0,0 +1,280 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace ResourceLib {
+
+	/**
+	 * FIFO cache model: a vertex is cached while fewer than cacheSize
+	 * others were transformed after it. Moving time past cacheSize
+	 * empties the cache.
+	 */
+	struct CacheModel {
+		std::vector<size_t> stamps;
+		size_t time;
+		size_t size;
+
+		CacheModel(size_t vertexCount, size_t cacheSize) : stamps(vertexCount, 0), time(cacheSize + 1), size(cacheSize) {}
+
+		/** Returns true if v had to be transformed. */
+		bool Touch(unsigned int v) {
+			if (time - stamps[v] <= size)
+				return false;
+			stamps[v] = time++;
+			return true;
+		}
+
+		unsigned int Triangle(const unsigned int* triangle) {
+			return Touch(triangle[0]) + Touch(triangle[1]) + Touch(triangle[2]);
+		}
+
+		void Flush() {
+			time += size + 1;
+		}
+	};
+
+	MeshOptimizer::CacheStats MeshOptimizer::AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, size_t cacheSize) {
+		CacheStats stats;
+		if (indexCount < 3)
+			return stats;
+
+		CacheModel cache(vertexCount, cacheSize);
+		std::vector<uint8_t> used(vertexCount, 0);
+		size_t misses = 0, usedCount = 0;
+		for (size_t i = 0; i < indexCount; i++) {
+			misses += cache.Touch(indices[i]);
+			usedCount += used[indices[i]] == 0;
+			used[indices[i]] = 1;
+		}
+
+		stats.acmr = (float)misses / (indexCount / 3);
+		stats.atvr = (float)misses / usedCount;
+		return stats;
+	}
+
+	/////////////
+	// TIPSIFY //
+	/////////////
+
+	void MeshOptimizer::OptimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount, size_t cacheSize) {
+		size_t triangleCount = indexCount / 3;
+		if (triangleCount == 0)
+			return;
+
+		// Triangles around each vertex, packed.
+		std::vector<uint32_t> live(vertexCount, 0);
+		for (size_t i = 0; i < triangleCount * 3; i++)
+			live[indices[i]]++;
+		std::vector<uint32_t> offsets(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; v++)
+			offsets[v + 1] = offsets[v] + live[v];
+		std::vector<uint32_t> adjacency(triangleCount * 3);
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t t = 0; t < triangleCount; t++) {
+			for (int k = 0; k < 3; k++)
+				adjacency[fill[indices[t * 3 + k]]++] = (uint32_t)t;
+		}
+
+		std::vector<size_t> cacheTime(vertexCount, 0);
+		std::vector<uint8_t> emitted(triangleCount, 0);
+		std::vector<unsigned int> deadEnd, candidates, output;
+		output.reserve(triangleCount * 3);
+		size_t time = cacheSize + 1;
+		size_t cursor = 0;
+
+		long long fan = indices[0];
+		while (fan >= 0) {
+			// Emit every remaining triangle around the fanning vertex.
+			candidates.clear();
+			for (uint32_t a = offsets[fan]; a < offsets[fan + 1]; a++) {
+				uint32_t t = adjacency[a];
+				if (emitted[t])
+					continue;
+				for (int k = 0; k < 3; k++) {
+					unsigned int v = indices[t * 3 + k];
+					output.push_back(v);
+					deadEnd.push_back(v);
+					candidates.push_back(v);
+					live[v]--;
+					if (time - cacheTime[v] > cacheSize)
+						cacheTime[v] = time++;
+				}
+				emitted[t] = 1;
+			}
+
+			// Next fan: the oldest candidate that stays cached through its
+			// remaining triangles, each adding up to two vertices.
+			long long best = -1;
+			long long bestPriority = -1;
+			for (size_t i = 0; i < candidates.size(); i++) {
+				unsigned int v = candidates[i];
+				if (live[v] == 0)
+					continue;
+				long long priority = 0;
+				if (time - cacheTime[v] + 2 * live[v] <= cacheSize)
+					priority = (long long)(time - cacheTime[v]);
+				if (priority > bestPriority) {
+					bestPriority = priority;
+					best = v;
+				}
+			}
+
+			// Dead end, back to a recent vertex or the next one left.
+			while (best < 0 && !deadEnd.empty()) {
+				unsigned int v = deadEnd.back();
+				deadEnd.pop_back();
+				if (live[v] > 0)
+					best = v;
+			}
+			while (best < 0 && cursor < vertexCount) {
+				if (live[cursor] > 0)
+					best = (long long)cursor;
+				cursor++;
+			}
+			fan = best;
+		}
+
+		memcpy(indices, output.data(), output.size() * sizeof(unsigned int));
+	}
+
+	//////////////
+	// OVERDRAW //
+	//////////////
+
+	void MeshOptimizer::OptimizeOverdraw(unsigned int* indices, size_t indexCount, const float* vertices, size_t vertexCount, size_t stride, size_t positionOffset, float threshold) {
+		size_t triangleCount = indexCount / 3;
+		if (triangleCount < 2)
+			return;
+
+		// Hard boundaries where all three vertices miss, the cache is cold
+		// there anyway so moving the cluster costs nothing.
+		std::vector<uint8_t> misses(triangleCount);
+		CacheModel cache(vertexCount, CacheSize);
+		std::vector<size_t> hard;
+		for (size_t t = 0; t < triangleCount; t++) {
+			misses[t] = (uint8_t)cache.Triangle(indices + t * 3);
+			if (t == 0 || misses[t] == 3)
+				hard.push_back(t);
+		}
+		hard.push_back(triangleCount);
+
+		// Soft boundaries inside each, cutting once the part so far is as
+		// cache friendly as the whole within the threshold.
+		std::vector<size_t> clusters;
+		for (size_t c = 0; c + 1 < hard.size(); c++) {
+			size_t begin = hard[c], end = hard[c + 1];
+			size_t total = 0;
+			for (size_t t = begin; t < end; t++)
+				total += misses[t];
+			float target = threshold * total / (end - begin);
+
+			cache.Flush();
+			clusters.push_back(begin);
+			size_t start = begin, sum = 0;
+			for (size_t t = begin; t + 1 < end; t++) {
+				sum += cache.Triangle(indices + t * 3);
+				if (sum <= target * (t + 1 - start)) {
+					clusters.push_back(t + 1);
+					cache.Flush();
+					start = t + 1;
+					sum = 0;
+				}
+			}
+		}
+		clusters.push_back(triangleCount);
+
+		///////////////////
+		// SORT CLUSTERS //
+		///////////////////
+		// Area weighted centroid and summed normal of every cluster.
+		size_t clusterCount = clusters.size() - 1;
+		std::vector<float> centroids(clusterCount * 3, 0.0f), normals(clusterCount * 3, 0.0f), areas(clusterCount, 0.0f);
+		float meshCentroid[3] = { 0, 0, 0 };
+		float meshArea = 0;
+		for (size_t c = 0; c < clusterCount; c++) {
+			for (size_t t = clusters[c]; t < clusters[c + 1]; t++) {
+				const float* p0 = vertices + indices[t * 3] * stride + positionOffset;
+				const float* p1 = vertices + indices[t * 3 + 1] * stride + positionOffset;
+				const float* p2 = vertices + indices[t * 3 + 2] * stride + positionOffset;
+				float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+				float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+				float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+				float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				for (int k = 0; k < 3; k++) {
+					centroids[c * 3 + k] += (p0[k] + p1[k] + p2[k]) * area;
+					normals[c * 3 + k] += n[k];
+				}
+				areas[c] += area;
+			}
+			for (int k = 0; k < 3; k++)
+				meshCentroid[k] += centroids[c * 3 + k];
+			meshArea += areas[c];
+		}
+		for (int k = 0; k < 3; k++)
+			meshCentroid[k] = meshArea > 0 ? meshCentroid[k] / (3.0f * meshArea) : 0.0f;
+
+		// Clusters facing away from the middle are more likely in front.
+		std::vector<float> keys(clusterCount, 0.0f);
+		for (size_t c = 0; c < clusterCount; c++) {
+			const float* n = &normals[c * 3];
+			float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			if (areas[c] <= 0 || length <= 0)
+				continue;
+			float d = 0;
+			for (int k = 0; k < 3; k++)
+				d += (centroids[c * 3 + k] / (3.0f * areas[c]) - meshCentroid[k]) * n[k];
+			keys[c] = d / length;
+		}
+
+		std::vector<uint32_t> order(clusterCount);
+		for (size_t c = 0; c < clusterCount; c++)
+			order[c] = (uint32_t)c;
+		std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+		std::vector<unsigned int> output;
+		output.reserve(triangleCount * 3);
+		for (size_t i = 0; i < clusterCount; i++) {
+			size_t c = order[i];
+			output.insert(output.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+		}
+		memcpy(indices, output.data(), output.size() * sizeof(unsigned int));
+	}
+
+	//////////////////
+	// VERTEX FETCH //
+	//////////////////
+
+	size_t MeshOptimizer::OptimizeVertexFetch(std::vector<float>& vertices, size_t stride, unsigned int* indices, size_t indexCount) {
+		const unsigned int unused = 0xFFFFFFFF;
+		size_t vertexCount = vertices.size() / stride;
+		std::vector<unsigned int> remap(vertexCount, unused);
+		unsigned int next = 0;
+		for (size_t i = 0; i < indexCount; i++) {
+			unsigned int& target = remap[indices[i]];
+			if (target == unused)
+				target = next++;
+			indices[i] = target;
+		}
+
+		std::vector<float> reordered(next * stride);
+		for (size_t v = 0; v < vertexCount; v++) {
+			if (remap[v] != unused)
+				memcpy(&reordered[remap[v] * stride], &vertices[v * stride], stride * sizeof(float));
+		}
+		vertices.swap(reordered);
+		return next;
+	}
+
+	void MeshOptimizer::Optimize(std::vector<float>& vertices, size_t stride, size_t positionOffset, std::vector<unsigned int>& indices) {
+		if (stride == 0 || indices.size() < 3)
+			return;
+
+		size_t vertexCount = vertices.size() / stride;
+		OptimizeVertexCache(indices.data(), indices.size(), vertexCount);
+		OptimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertexCount, stride, positionOffset);
+		OptimizeVertexFetch(vertices, stride, indices.data(), indices.size());
+	}
+}
@@ -1,15 +1,19 @@
 #pragma once
 
 #include "MathLib.h"
+#include "SlotMap.h"
+#include "MappedFile.h"
+#include "ObjParser.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "VertexFormat.h"
 
 //#include "ResourceBase.h"
 
-// Planning on using this some day, but it needs extending.
-//#include "half.h"
-//using namespace half_float;
-
 // memcpy() for union copy instruction.
 #include <cstring>
+#include <cmath>
 
 #include <iostream>
 #include <typeinfo>
@@ -17,6 +21,7 @@
 #include <fstream>
 #include <vector>
 #include <map>
+#include <memory>
 
 
 //#include "matlib.h"
@@ -26,41 +31,58 @@ namespace ResourceLib {
 	/** Class representing a single attribute. */
 	class Attribute {
 	public:
+		typedef VertexFormat::Type Type;
+
 		/** The amount of elements to read before going to next vertex. */
 		size_t length;
 
-		/** The offset from stride to first element. */
+		/** The offset in bytes from the start of a vertex to the first element. */
 		size_t offset;
 
-		/** The stride of the data block. */
+		/** The distance in bytes to the next vertex. */
 		size_t stride;
 
 		/** The attribute field name. */
 		std::string name;
 
+		/** The type of each element. */
+		Type type;
+
+		/** Integer elements read as [-1, 1] or [0, 1] instead of their value. */
+		bool normalized;
+
 		/** Copy constructor. */
 		Attribute(const Attribute& other) {
 			this->length = other.length;
 			this->offset = other.offset;
 			this->stride = other.stride;
 			this->name = other.name;
+			this->type = other.type;
+			this->normalized = other.normalized;
 		}
 
 		/**
 		 * Create an attribute.
 		 *
-		 * @data is the pointer to a block of data
-		 * @type is the way element type in the data block.
-		 * @size is the total element size of the data block.
 		 * @length is the element length of this attribute.
-		 * @stride is the distance in elements to the next vertex.
+		 * @offset is the distance in bytes from the start of a vertex.
+		 * @stride is the distance in bytes to the next vertex.
 		 * @name is the name of this attribute.
+		 * @type is the element type in the data block.
+		 * @normalized maps integer types to [-1, 1] or [0, 1].
 		 */
-		Attribute(size_t length = 0, size_t offset = 0, size_t stride = 0, std::string name = "") {
+		Attribute(size_t length = 0, size_t offset = 0, size_t stride = 0, std::string name = "", Type type = Type::Float, bool normalized = false) {
 			this->length = length;
 			this->offset = offset;
 			this->stride = stride;
 			this->name = name;
+			this->type = type;
+			this->normalized = normalized;
+		}
+
+		/** Bytes of this attribute in a vertex. */
+		size_t Size() const {
+			return VertexFormat::Size(type, length);
 		}
 
 		~Attribute() {
@@ -100,8 +122,10 @@ namespace ResourceLib {
 		/** The loaded state of this resource. */
 		bool loaded = false;
 
-		/** The raw mesh data of this mesh resource. */
+		/** The raw mesh data of this mesh resource, empty when mapped from a cache or quantized. */
 		std::vector<float> data = std::vector<float>();
+		/** Vertex data in the attribute types, replaces data after Quantize(). */
+		std::vector<uint8_t> packedData;
 		/** the handle index for external use. */
 		//size_t dataIndex = 0;
 
@@ -109,8 +133,8 @@ namespace ResourceLib {
 		enum class Mode {
 			/** Mode representing indexed drawing. */
 			Indexed,
-			/** Mode representing instanced draw. */
-			//Instanced,
+			/** Mode representing indexed drawing, instanced even when drawn once. */
+			Instanced,
 			/** Mode representing raw vertex  */
 			Raw
 		};
@@ -124,19 +148,126 @@ namespace ResourceLib {
 		/** The mesh handle. */
 		std::string meshHandle;
 
-		/** The index list of the mesh resource. */
+		/** The index list of the mesh resource, empty when mapped from a cache or compacted. */
 		std::vector<unsigned int> indices;
+		/** 16 bit indices, replace indices after CompactIndices(). */
+		std::vector<uint16_t> packedIndices;
 		/** The about of index elements, needed after Unload(). */
 		size_t indicesCount = 0;
+		/** Bytes per index, 2 or 4, needed after Unload(). */
+		size_t indexSize = sizeof(unsigned int);
+
+		/**
+		 * The MeshCache file the vertex and index data is read from in
+		 * place, null when they live in data and indices.
+		 */
+		std::shared_ptr<MappedFile> mapping;
+		/** Vertex data inside the mapping. */
+		const uint8_t* mappedData = nullptr;
+		/** Number of bytes at mappedData. */
+		size_t mappedDataSize = 0;
+		/** Indices inside the mapping, indicesCount of indexSize bytes. */
+		const void* mappedIndices = nullptr;
+
+		/** A level of detail, a range of the indices over the shared vertices. */
+		struct Lod {
+			/** First index of the level within this mesh's indices. */
+			size_t indexOffset = 0;
+			size_t indexCount = 0;
+			/** How far the surface may have moved from full detail, in mesh units. */
+			float error = 0;
+		};
+
+		/**
+		 * Levels from full detail down, back to back in the indices so all
+		 * of them live in the same arenas. Empty for a single level.
+		 */
+		std::vector<Lod> lods;
 		/** The handle index for external use. */
 		//size_t indicesIndex = 0;
 
 		/** The vertex attributes of the mesh resource. */
 		std::vector<Attribute> attributes;
 
+		/**
+		 * The vertex arena holding this mesh, set by
+		 * GG::ResourceHandler::UploadMeshResource. Shared by every mesh with
+		 * the same attribute layout.
+		 */
+		BufferHandle vbo;
+		/** The index arena holding this mesh, shared by every mesh. */
+		BufferHandle ibo;
+
+		/** First vertex of this mesh in the vertex arena. */
+		size_t baseVertex = 0;
+		/** Number of vertices placed in the vertex arena. */
+		size_t vertexCount = 0;
+		/** First index of this mesh in the index arena. */
+		size_t firstIndex = 0;
+		/**
+		 * Number of indices placed in the index arena, kept apart from
+		 * indicesCount which a reload overwrites before the old range is freed.
+		 */
+		size_t arenaIndexCount = 0;
+
+		// Local space bounds, computed by ComputeBounds() on load and kept
+		// after Unload() for culling.
+
+		/** Center of the bounding box, also the bounding sphere center. */
+		float boundsCenter[3] = { 0, 0, 0 };
+		/** Half size of the bounding box along each axis. */
+		float boundsExtents[3] = { 0, 0, 0 };
+		/** Radius of the bounding sphere around boundsCenter. */
+		float boundsRadius = 0;
+
 		/** Default mesh resource. */
 		MeshResource() {}
 
+		// Loaded vertex and index data, from the vectors or a mapped cache.
+		// Sizes are in bytes, indices are indexSize bytes each.
+
+		const uint8_t* GetVertexData() const {
+			if (mapping)
+				return mappedData;
+			return packedData.empty() ? (const uint8_t*)data.data() : packedData.data();
+		}
+		size_t GetVertexDataSize() const {
+			if (mapping)
+				return mappedDataSize;
+			return packedData.empty() ? data.size() * sizeof(float) : packedData.size();
+		}
+		const void* GetIndexData() const {
+			if (mapping)
+				return mappedIndices;
+			return indexSize == sizeof(uint16_t) ? (const void*)packedIndices.data() : (const void*)indices.data();
+		}
+		size_t GetIndexCount() const {
+			if (mapping)
+				return indicesCount;
+			return indexSize == sizeof(uint16_t) ? packedIndices.size() : indices.size();
+		}
+
+		/** Index i of the loaded indices, whatever their size. */
+		unsigned int GetIndex(size_t i) const {
+			if (indexSize == sizeof(uint16_t))
+				return ((const uint16_t*)GetIndexData())[i];
+			return ((const unsigned int*)GetIndexData())[i];
+		}
+
+		size_t GetLodCount() const {
+			return lods.empty() ? 1 : lods.size();
+		}
+
+		/** A level of detail, the coarsest for levels past the end. */
+		Lod GetLod(size_t level) const {
+			if (lods.empty()) {
+				Lod lod;
+				lod.indexCount = indicesCount;
+				return lod;
+			}
+			return lods[level < lods.size() ? level : lods.size() - 1];
+		}
+
 		/**  */
 		MeshResource(const std::string& filename) {
 			//this->filename = filename;
@@ -167,11 +298,11 @@ namespace ResourceLib {
 				1.0f, 0.0f,
 			};
 			// Positions.
-			mr.attributes.push_back(Attribute(3, 0, 9, "pos"));
+			mr.attributes.push_back(Attribute(3, 0, 9 * sizeof(float), "pos"));
 			// Colors
-			mr.attributes.push_back(Attribute(4, 3, 9, "color"));
+			mr.attributes.push_back(Attribute(4, 3 * sizeof(float), 9 * sizeof(float), "color"));
 			// UV coordinates.
-			mr.attributes.push_back(Attribute(2, 7, 9, "uv"));
+			mr.attributes.push_back(Attribute(2, 7 * sizeof(float), 9 * sizeof(float), "uv"));
 
 			// Set up indices.
 			mr.indices = {
@@ -182,6 +313,8 @@ namespace ResourceLib {
 			};
 
 			mr.indicesCount = mr.indices.size();
+			mr.ComputeBounds();
+			mr.CompactIndices();
 
 			mr.loaded = true;
 
@@ -251,11 +384,11 @@ namespace ResourceLib {
 				0.5f, 0,
 			};
 			// Positions.
-			mr.attributes.push_back(Attribute(3, 0, 9, "pos"));
+			mr.attributes.push_back(Attribute(3, 0, 9 * sizeof(float), "pos"));
 			// Colors
-			mr.attributes.push_back(Attribute(4, 3, 9, "color"));
+			mr.attributes.push_back(Attribute(4, 3 * sizeof(float), 9 * sizeof(float), "color"));
 			// UV coordinates.
-			mr.attributes.push_back(Attribute(2, 7, 9, "uv"));
+			mr.attributes.push_back(Attribute(2, 7 * sizeof(float), 9 * sizeof(float), "uv"));
 
 			// Set up indices.
 			mr.indices = {
@@ -277,6 +410,8 @@ namespace ResourceLib {
 			};
 
 			mr.indicesCount = mr.indices.size();
+			mr.ComputeBounds();
+			mr.CompactIndices();
 
 			mr.loaded = true;
 
@@ -291,168 +426,297 @@ namespace ResourceLib {
 			return Load(this->filename);
 		}
 
-		/** Loads data to mesh resource from filename. */
+		/**
+		 * Loads data to mesh resource from filename.
+		 *
+		 * The first load optimizes the mesh with MeshOptimizer and cooks a
+		 * MeshCache next to the file, later loads map it instead of parsing
+		 * as long as the file is unchanged.
+		 */
 		bool Load(std::string filename) {
 
 			// Set name for shader key later.
 			this->filename = filename;
 
-			std::string data;
-
-			std::vector<float> pos;
-			std::vector<float> uv;
-			std::vector<float> norm;
+			// clear data and indices
+			this->data.clear();
+			this->packedData.clear();
+			this->indices.clear();
+			this->packedIndices.clear();
+			this->indexSize = sizeof(unsigned int);
+			this->mapping.reset();
+			this->lods.clear();
 
-			std::ifstream mesh(filename);
+			MappedFile file;
 			// Make sure vertex file actually opened.
-			if (mesh) {
-				// Read file into string buffer.
-				//data = std::string(
-				//	std::istreambuf_iterator<char>(mesh),
-				//	std::istreambuf_iterator<char>()
-				//);
-
-				int maxIndex = 0;
-				// clear data and indices
-				this->data.clear();
-				this->indices.clear();
-
-				// Map that helps reduce duplicate vertices.
-				std::map<std::string, int> vertIndexList;
-
-				// For each line.
-				for (std::string line; std::getline(mesh, line); ) {
-					// Token list.
-					std::vector<std::string> tokens;
-
-					// String rep of line.
-					char* str = const_cast<char*>(line.c_str());
-
-					// Tokenize line.
-					char* tok = strtok(str, " ");
-					while (tok != NULL) {
-						tokens.push_back(tok);
-						tok = strtok(NULL, " ");
-					}
+			if (!file.Open(filename)) {
+				std::cout << "Could not open obj file '" << filename << "'\n";
+				return this->loaded = false;
+			}
 
-					// do stuff depending on type
+			uint64_t hash = MeshCache::Hash(file.Data(), file.Size());
+			std::string cache = MeshCache::PathFor(filename);
+			if (MeshCache::Read(cache, hash, file.Size(), *this))
+				return this->loaded = true;
 
-					if (tokens.size() == 0)
-						continue;
+			// Faces with missing elements are reported and skipped.
+			ObjParser::Parse(file.Data(), file.Size(), this->data, this->indices);
 
-					if (tokens.size() > 0 && tokens[0] == "v") {
-						// Push 3 position floats to array.
-						for (int i = 1; i < 4; i++)
-							pos.push_back(std::stof(tokens[i]));
-					}
-					else if (tokens[0] == "vt") {
-						// Push 2 UV floats to array.
-						for (int i = 1; i < 3; i++)
-							uv.push_back(std::stof(tokens[i]));
-					}
-					else if (tokens[0] == "vn") {
-						// Push 3 normal floats to array.
-						for (int i = 1; i < 4; i++)
-							norm.push_back(std::stof(tokens[i]));
-					}
-					else if (tokens[0] == "f") {
-						// Assemble first triangle.
-						// pos  = i*3
-						// uv   = i*2
-						// norm = i*3
-
-						int indices[4];
-
-						// Parse first three vertices.
-						for (int i = 1; i < tokens.size(); i++) {
-							
-							// Current vertex.
-							char* cver = const_cast<char*>(tokens[i].c_str());
-
-							// Set up iterator.
-							std::map<std::string, int>::iterator existing;
-							// If vertex already exists.
-							if ((existing = vertIndexList.find(cver)) != vertIndexList.end()) {
-								indices[i-1] = existing->second;	// Set index to existing.
-								continue; 							// Goto next vertex.
-							}
-							// Use string as key for new vertex.
-							vertIndexList[cver] = maxIndex;
-
-
-							// Sub vertex indices.
-							char* svi;
-
-							// parse vertex index
-							svi = strtok(cver, "/");
-							int ix = (std::stoi(svi) - 1) * 3;
-
-							this->data.push_back(pos[ix]);
-							this->data.push_back(pos[ix+1]);
-							this->data.push_back(pos[ix+2]);
-
-							// parse uv index
-							svi = strtok(NULL, "/");
-							ix = (std::stoi(svi) - 1) * 2;
-							this->data.push_back(uv[ix]);
-							this->data.push_back(uv[ix + 1]);
-
-							// parse normal index
-							svi = strtok(NULL, "/");
-							ix = (std::stoi(svi) - 1) * 3;
-							this->data.push_back(norm[ix]);
-							this->data.push_back(norm[ix + 1]);
-							this->data.push_back(norm[ix + 2]);
-
-
-							// Add new vertex if it doesn't exist.
-							indices[i-1] = maxIndex++;
-						}
-
-						if (tokens.size() == 4) {
-							// Push vertices to ibo.
-							this->indices.push_back(indices[0]);
-							this->indices.push_back(indices[1]);
-							this->indices.push_back(indices[2]);
-						}
-						else if (tokens.size() == 5) {
-							// Push three first vertices to ibo.
-							this->indices.push_back(indices[0]);
-							this->indices.push_back(indices[1]);
-							this->indices.push_back(indices[3]);
-							// Push three last vertices to ibo
-							this->indices.push_back(indices[1]);
-							this->indices.push_back(indices[2]);
-							this->indices.push_back(indices[3]);
-						}
-						else {
-							printf("boi shit's fucked yo\n");
-						}
+			// File order is poor for the GPU, reorder once before cooking.
+			MeshOptimizer::Optimize(this->data, ObjParser::Stride, 0, this->indices);
+
+			this->attributes.clear();
+			const size_t stride = ObjParser::Stride * sizeof(float);
+			// Positions.
+			this->attributes.push_back(Attribute(3, 0, stride, "pos"));
+			// UV coordinates.
+			this->attributes.push_back(Attribute(2, 3 * sizeof(float), stride, "uv"));
+			// Normals.
+			this->attributes.push_back(Attribute(3, 5 * sizeof(float), stride, "normal"));
+
+			// Halving triangles per level, at most 2% of the mesh size off.
+			const float ratios[] = { 0.5f, 0.25f, 0.125f, 0.0625f };
+			GenerateLods(ratios, sizeof(ratios) / sizeof(ratios[0]), 0.02f);
+
+			// Set index count for whatever reason
+			this->indicesCount = this->indices.size();
+
+			ComputeBounds();
+
+			// Bounds and levels want the exact positions, compact last.
+			Quantize();
+			CompactIndices();
+
+			// Not fatal, the next start just parses again.
+			if (!MeshCache::Write(cache, hash, file.Size(), *this))
+				std::cout << "Could not write mesh cache '" << cache << "'\n";
+
+			return this->loaded = true;
+		}
+
+		/**
+		 * Appends simplified levels of detail to the indices.
+		 *
+		 * Each level aims for a ratio of the full triangle count and is
+		 * simplified from the level before, the chain ends early once a level
+		 * can't get there within maxError, relative to the mesh size, or
+		 * barely shrinks. Needs the vertex data loaded in data and indices.
+		 */
+		void GenerateLods(const float* ratios, size_t ratioCount, float maxError) {
+			lods.clear();
+			const Attribute* position = PositionAttribute();
+			if (position == nullptr || position->stride == 0 || position->type != Attribute::Type::Float || indices.size() < 3)
+				return;
+
+			size_t stride = position->stride / sizeof(float);
+			size_t offset = position->offset / sizeof(float);
+			size_t vertexCount = data.size() / stride;
+			float scale = MeshSimplifier::Scale(data.data(), vertexCount, stride, offset);
+
+			Lod full;
+			full.indexCount = indices.size();
+			lods.push_back(full);
+
+			std::vector<unsigned int> source(indices), level(indices.size());
+			float error = 0;
+			for (size_t r = 0; r < ratioCount && error < maxError; r++) {
+				size_t target = (size_t)(full.indexCount / 3 * ratios[r]) * 3;
+				float levelError;
+				size_t count = MeshSimplifier::Simplify(level.data(), source.data(), source.size(),
+					data.data(), vertexCount, stride, offset, target, maxError - error, &levelError);
+				if (count == 0 || count > source.size() * 9 / 10)
+					break;
+
+				// Errors of nested levels add up at worst.
+				error += levelError;
+				MeshOptimizer::OptimizeVertexCache(level.data(), count, vertexCount);
+
+				Lod lod;
+				lod.indexOffset = indices.size();
+				lod.indexCount = count;
+				lod.error = error * scale;
+				lods.push_back(lod);
+				indices.insert(indices.end(), level.begin(), level.begin() + count);
+				source.assign(level.begin(), level.begin() + count);
+			}
+
+			if (lods.size() == 1)
+				lods.clear();
+			indicesCount = indices.size();
+		}
+
+		/**
+		 * Stores float vertices in compact types, each within a bound:
+		 *
+		 *  - "pos" as 4 halfs, within positionError times the mesh size,
+		 *  - "uv" as 2 snorm16 inside [-1, 1], else 2 halfs, within uvError,
+		 *  - "normal" as 10-10-10-2 snorm, or octahedral if asked,
+		 *  - "color" as 4 unorm8,
+		 *
+		 * the last two within VertexFormat::Precision(). An attribute that
+		 * misses its bound, e.g. positions far from the origin or normals
+		 * that aren't unit length, stays float, as do other names. Needs
+		 * float vertex data in data, which packedData replaces.
+		 *
+		 * 10-10-10-2 normals read as a vec3 like float ones, octahedral
+		 * ones need decoding in the vertex shader.
+		 *
+		 * @returns false if there was no float vertex data.
+		 */
+		bool Quantize(float positionError = 1.0f / 4096, float uvError = 1.0f / 4096, bool octahedralNormals = false) {
+			if (mapping || data.empty() || attributes.empty())
+				return false;
+			size_t stride = attributes[0].stride;
+			for (size_t i = 0; i < attributes.size(); i++) {
+				const Attribute& a = attributes[i];
+				if (a.type != Attribute::Type::Float || a.stride != stride || a.offset % sizeof(float) != 0)
+					return false;
+			}
+
+			size_t floatStride = stride / sizeof(float);
+			size_t vertexCount = data.size() / floatStride;
+			const Attribute* position = PositionAttribute();
+			float scale = MeshSimplifier::Scale(data.data(), vertexCount, floatStride, position->offset / sizeof(float));
+
+			struct Candidate {
+				Attribute::Type type;
+				size_t length;
+				bool normalized;
+				float bound;
+			};
+
+			// The first candidate within its bound wins, float otherwise.
+			std::vector<Attribute> packed;
+			packed.reserve(attributes.size());
+			size_t packedStride = 0;
+			for (size_t i = 0; i < attributes.size(); i++) {
+				const Attribute& a = attributes[i];
+				std::vector<Candidate> candidates;
+				if (a.name == "pos") {
+					candidates.push_back({ Attribute::Type::Half, 4, false, positionError * scale });
+				}
+				else if (a.name == "uv") {
+					candidates.push_back({ Attribute::Type::Snorm16, a.length, true, uvError });
+					candidates.push_back({ Attribute::Type::Half, a.length, false, uvError });
+				}
+				else if (a.name == "normal") {
+					Attribute::Type type = octahedralNormals ? Attribute::Type::Octahedral : Attribute::Type::Snorm10;
+					candidates.push_back({ type, (size_t)(octahedralNormals ? 2 : 4), true, VertexFormat::Precision(type) });
+				}
+				else if (a.name == "color") {
+					candidates.push_back({ Attribute::Type::Unorm8, 4, true, VertexFormat::Precision(Attribute::Type::Unorm8) });
+				}
+
+				packed.push_back(Attribute(a.length, 0, 0, a.name));
+				for (size_t c = 0; c < candidates.size(); c++) {
+					float error = VertexFormat::EncodeArray(candidates[c].type, candidates[c].length,
+						data.data() + a.offset / sizeof(float), a.length, floatStride, vertexCount, nullptr, 0);
+					// Slack for the float math of the check itself.
+					if (error <= candidates[c].bound * 1.001f) {
+						packed.back().type = candidates[c].type;
+						packed.back().length = candidates[c].length;
+						packed.back().normalized = candidates[c].normalized;
+						break;
 					}
 				}
 
-				// Set index count for whatever reason
-				this->indicesCount = this->indices.size();
+				// Attributes start 4 byte aligned.
+				packed.back().offset = packedStride;
+				packedStride += (packed.back().Size() + 3) & ~(size_t)3;
+			}
+			for (size_t i = 0; i < packed.size(); i++)
+				packed[i].stride = packedStride;
 
-				vertIndexList.clear(); // Keep memory leaks fewer.
+			packedData.assign(vertexCount * packedStride, 0);
+			for (size_t i = 0; i < packed.size(); i++) {
+				VertexFormat::EncodeArray(packed[i].type, packed[i].length, data.data() + attributes[i].offset / sizeof(float), attributes[i].length,
+					floatStride, vertexCount, packedData.data() + packed[i].offset, packedStride);
+			}
 
-				this->attributes.clear();
-				// Positions.
-				this->attributes.push_back(Attribute(3, 0, 8, "pos"));
-				// UV coordinates.
-				this->attributes.push_back(Attribute(2, 3, 8, "uv"));
-				// Normals.
-				this->attributes.push_back(Attribute(3, 5, 8, "normal"));
+			attributes.swap(packed);
+			data.clear();
+			data.shrink_to_fit();
+			return true;
+		}
 
-				// Close file when done.
-				mesh.close();
+		/**
+		 * Switches to 16 bit indices when every vertex fits in one, halving
+		 * the index memory. Needs the indices loaded.
+		 *
+		 * @returns true if the indices are 16 bit now.
+		 */
+		bool CompactIndices() {
+			if (indexSize == sizeof(uint16_t))
+				return true;
+			if (mapping || attributes.empty() || attributes[0].stride == 0)
+				return false;
+
+			size_t vertexCount = GetVertexDataSize() / attributes[0].stride;
+			if (vertexCount > 65535)
+				return false;
+
+			packedIndices.assign(indices.begin(), indices.end());
+			indices.clear();
+			indices.shrink_to_fit();
+			indexSize = sizeof(uint16_t);
+			return true;
+		}
+
+		/** The "pos" attribute, or the first attribute if there is none. */
+		const Attribute* PositionAttribute() const {
+			for (size_t i = 0; i < attributes.size(); i++) {
+				if (attributes[i].name == "pos")
+					return &attributes[i];
 			}
-			else {
-				std::cout << "Could not open obj file '" << filename << "'\n";
-				return this->loaded = false;
+			return attributes.empty() ? nullptr : &attributes[0];
+		}
+
+		/**
+		 * Computes the bounds from the "pos" attribute, or the first
+		 * attribute if there is none. Needs the vertex data loaded.
+		 */
+		void ComputeBounds() {
+			const Attribute* position = PositionAttribute();
+			if (position == nullptr || position->stride == 0 || VertexFormat::Components(position->type, position->length) > 4 ||
+				GetVertexDataSize() < position->offset + position->Size()) {
+				boundsCenter[0] = boundsCenter[1] = boundsCenter[2] = 0;
+				boundsExtents[0] = boundsExtents[1] = boundsExtents[2] = 0;
+				boundsRadius = 0;
+				return;
 			}
 
-			return this->loaded = true;
+			const uint8_t* vertices = GetVertexData() + position->offset;
+			size_t count = (GetVertexDataSize() - position->offset) / position->stride;
+			size_t length = VertexFormat::Components(position->type, position->length);
+			length = length < 3 ? length : 3;
+
+			float min[3] = { 0, 0, 0 };
+			float max[3] = { 0, 0, 0 };
+			float p[4];
+			for (size_t i = 0; i < count; i++) {
+				VertexFormat::Decode(position->type, position->length, vertices + i * position->stride, p);
+				for (size_t k = 0; k < length; k++) {
+					if (i == 0 || p[k] < min[k]) min[k] = p[k];
+					if (i == 0 || p[k] > max[k]) max[k] = p[k];
+				}
+			}
+
+			for (size_t k = 0; k < 3; k++) {
+				boundsCenter[k] = (min[k] + max[k]) * 0.5f;
+				boundsExtents[k] = (max[k] - min[k]) * 0.5f;
+			}
+
+			// Tighter than the box corner for round meshes.
+			float radiusSq = 0;
+			for (size_t i = 0; i < count; i++) {
+				VertexFormat::Decode(position->type, position->length, vertices + i * position->stride, p);
+				float distSq = 0;
+				for (size_t k = 0; k < length; k++)
+					distSq += (p[k] - boundsCenter[k]) * (p[k] - boundsCenter[k]);
+				if (distSq > radiusSq)
+					radiusSq = distSq;
+			}
+			boundsRadius = std::sqrt(radiusSq);
 		}
 
 		/** Unloads the local data from this mesh resource. */
@@ -460,9 +724,15 @@ namespace ResourceLib {
 			// Clear and shrink data.
 			this->data.clear();
 			this->data.shrink_to_fit();
+			this->packedData.clear();
+			this->packedData.shrink_to_fit();
 			// Clear and shrink to ensure no data leak.
 			this->indices.clear();
 			this->indices.shrink_to_fit();
+			this->packedIndices.clear();
+			this->packedIndices.shrink_to_fit();
+			// Unmaps a cache.
+			this->mapping.reset();
 			this->loaded = false;
 		}
 	};
@@ -0,0 +1,428 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ResourceLib {
+
+	/** Symmetric error quadric, doubles since thousands of planes are summed. */
+	struct Quadric {
+		double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+		double b0 = 0, b1 = 0, b2 = 0;
+		double c = 0;
+		/** Total area of the planes. */
+		double weight = 0;
+
+		/** Adds the plane n.p + d = 0, n unit length, weighted by area. */
+		void AddPlane(double nx, double ny, double nz, double d, double area) {
+			a00 += area * nx * nx;
+			a01 += area * nx * ny;
+			a02 += area * nx * nz;
+			a11 += area * ny * ny;
+			a12 += area * ny * nz;
+			a22 += area * nz * nz;
+			b0 += area * nx * d;
+			b1 += area * ny * d;
+			b2 += area * nz * d;
+			c += area * d * d;
+			weight += area;
+		}
+
+		void Add(const Quadric& other) {
+			a00 += other.a00;
+			a01 += other.a01;
+			a02 += other.a02;
+			a11 += other.a11;
+			a12 += other.a12;
+			a22 += other.a22;
+			b0 += other.b0;
+			b1 += other.b1;
+			b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+		}
+
+		/** Area weighted mean squared distance of p to the planes. */
+		double Error(const float* p) const {
+			double x = p[0], y = p[1], z = p[2];
+			double e = a00 * x * x + a11 * y * y + a22 * z * z
+				+ 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+				+ 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+			// Rounding can take a perfect fit slightly below zero.
+			return weight > 0 ? std::fabs(e) / weight : 0.0;
+		}
+	};
+
+	/** An edge collapse, from moves onto to. */
+	struct Collapse {
+		unsigned int from, to;
+		double error;
+	};
+
+	static inline void Cross(const float* a, const float* b, const float* c, double* n) {
+		double e1[3] = { (double)b[0] - a[0], (double)b[1] - a[1], (double)b[2] - a[2] };
+		double e2[3] = { (double)c[0] - a[0], (double)c[1] - a[1], (double)c[2] - a[2] };
+		n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	}
+
+	/** The working state of one Simplify() call. */
+	class Simplification {
+	public:
+		Simplification(const float* vertices, size_t vertexCount, size_t stride, size_t positionOffset)
+			: vertices(vertices), vertexCount(vertexCount), stride(stride), positionOffset(positionOffset) {}
+
+		const float* Position(unsigned int v) const {
+			return vertices + v * stride + positionOffset;
+		}
+
+		/** Gives vertices at the same position one group, the lowest of their ids. */
+		void BuildGroups() {
+			std::vector<unsigned int> order(vertexCount);
+			for (size_t v = 0; v < vertexCount; v++)
+				order[v] = (unsigned int)v;
+			std::sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) {
+				int c = memcmp(Position(a), Position(b), 3 * sizeof(float));
+				return c != 0 ? c < 0 : a < b;
+			});
+
+			group.resize(vertexCount);
+			for (size_t i = 0; i < vertexCount; ) {
+				size_t j = i + 1;
+				while (j < vertexCount && memcmp(Position(order[i]), Position(order[j]), 3 * sizeof(float)) == 0)
+					j++;
+				for (size_t k = i; k < j; k++)
+					group[order[k]] = order[i];
+				i = j;
+			}
+		}
+
+		/** Drops triangles with two corners in one group. */
+		void DropDegenerate() {
+			size_t kept = 0;
+			for (size_t i = 0; i + 2 < triangles.size(); i += 3) {
+				unsigned int a = triangles[i], b = triangles[i + 1], c = triangles[i + 2];
+				if (group[a] == group[b] || group[b] == group[c] || group[c] == group[a])
+					continue;
+				triangles[kept++] = a;
+				triangles[kept++] = b;
+				triangles[kept++] = c;
+			}
+			triangles.resize(kept);
+		}
+
+		/** Plane quadrics per group, and locks groups on open or non manifold edges. */
+		void BuildQuadrics() {
+			quadrics.assign(vertexCount, Quadric());
+			locked.assign(vertexCount, 0);
+
+			std::vector<uint64_t> edges;
+			for (size_t i = 0; i < triangles.size(); i += 3) {
+				unsigned int g[3] = { group[triangles[i]], group[triangles[i + 1]], group[triangles[i + 2]] };
+				double n[3];
+				Cross(Position(g[0]), Position(g[1]), Position(g[2]), n);
+				double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				if (length > 0) {
+					n[0] /= length;
+					n[1] /= length;
+					n[2] /= length;
+					const float* p = Position(g[0]);
+					double d = -(n[0] * p[0] + n[1] * p[1] + n[2] * p[2]);
+					for (int k = 0; k < 3; k++)
+						quadrics[g[k]].AddPlane(n[0], n[1], n[2], d, length * 0.5);
+				}
+				for (int k = 0; k < 3; k++)
+					edges.push_back(EdgeKey(g[k], g[(k + 1) % 3]));
+			}
+
+			// Every edge of a closed manifold is in exactly two triangles.
+			std::sort(edges.begin(), edges.end());
+			for (size_t i = 0; i < edges.size(); ) {
+				size_t j = i + 1;
+				while (j < edges.size() && edges[j] == edges[i])
+					j++;
+				if (j - i != 2) {
+					locked[(unsigned int)(edges[i] >> 32)] = 1;
+					locked[(unsigned int)edges[i]] = 1;
+				}
+				i = j;
+			}
+		}
+
+		/** Triangles around each group, packed. */
+		void BuildAdjacency() {
+			offsets.assign(vertexCount + 1, 0);
+			for (size_t i = 0; i < triangles.size(); i++)
+				offsets[group[triangles[i]] + 1]++;
+			for (size_t v = 0; v < vertexCount; v++)
+				offsets[v + 1] += offsets[v];
+			adjacency.resize(triangles.size());
+			std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < triangles.size(); i++)
+				adjacency[fill[group[triangles[i]]]++] = (uint32_t)(i / 3);
+		}
+
+		/** Every edge once, with the cheaper of its two directions. */
+		void BuildCollapses() {
+			std::vector<uint64_t> edges;
+			edges.reserve(triangles.size());
+			for (size_t i = 0; i < triangles.size(); i += 3) {
+				for (int k = 0; k < 3; k++)
+					edges.push_back(EdgeKey(group[triangles[i + k]], group[triangles[i + (k + 1) % 3]]));
+			}
+			std::sort(edges.begin(), edges.end());
+			edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+			collapses.clear();
+			for (size_t i = 0; i < edges.size(); i++) {
+				unsigned int a = (unsigned int)(edges[i] >> 32), b = (unsigned int)edges[i];
+				if (locked[a] && locked[b])
+					continue;
+
+				Quadric q = quadrics[a];
+				q.Add(quadrics[b]);
+				Collapse collapse;
+				double ab = locked[a] ? HUGE_VAL : q.Error(Position(b));
+				double ba = locked[b] ? HUGE_VAL : q.Error(Position(a));
+				collapse.from = ab <= ba ? a : b;
+				collapse.to = ab <= ba ? b : a;
+				collapse.error = ab <= ba ? ab : ba;
+				collapses.push_back(collapse);
+			}
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) {
+				return x.error < y.error;
+			});
+		}
+
+		/**
+		 * Checks a collapse and fills partners with the variant of to each
+		 * variant of from becomes.
+		 */
+		bool CanCollapse(unsigned int from, unsigned int to) {
+			partners.clear();
+			stamp++;
+
+			// Variants across the collapsed edge, one per variant of from.
+			for (uint32_t a = offsets[from]; a < offsets[from + 1]; a++) {
+				const unsigned int* t = &triangles[adjacency[a] * 3];
+				int corner = -1, other = -1;
+				for (int k = 0; k < 3; k++) {
+					if (group[t[k]] == from)
+						corner = k;
+					else if (group[t[k]] == to)
+						other = k;
+					else
+						marks[group[t[k]]] = stamp;
+				}
+				if (other < 0)
+					continue;
+				if (!AddPartner(t[corner], t[other]))
+					return false;
+			}
+
+			// Neighbors shared by both ends other than across the edge
+			// would fold two triangles onto each other.
+			for (uint32_t a = offsets[to]; a < offsets[to + 1]; a++) {
+				const unsigned int* t = &triangles[adjacency[a] * 3];
+				bool shared = false;
+				for (int k = 0; k < 3; k++)
+					shared |= group[t[k]] == from;
+				if (shared)
+					continue;
+				for (int k = 0; k < 3; k++) {
+					unsigned int g = group[t[k]];
+					if (g != to && marks[g] == stamp && !IsOpposite(from, to, g))
+						return false;
+				}
+			}
+
+			// Triangles that survive must keep a variant and their facing.
+			const float* target = Position(to);
+			for (uint32_t a = offsets[from]; a < offsets[from + 1]; a++) {
+				const unsigned int* t = &triangles[adjacency[a] * 3];
+				int corner = -1;
+				bool degenerate = false;
+				for (int k = 0; k < 3; k++) {
+					if (group[t[k]] == from)
+						corner = k;
+					degenerate |= group[t[k]] == to;
+				}
+				if (degenerate)
+					continue;
+				if (PartnerOf(t[corner]) == UINT32_MAX)
+					return false;
+
+				const float* before[3] = { Position(t[0]), Position(t[1]), Position(t[2]) };
+				const float* after[3] = { before[0], before[1], before[2] };
+				after[corner] = target;
+				double n0[3], n1[3];
+				Cross(before[0], before[1], before[2], n0);
+				Cross(after[0], after[1], after[2], n1);
+				// Turning 75 degrees already counts, a run of collapses just
+				// short of 90 would otherwise fold triangles into needles.
+				double dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+				double lengths = (n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2]) * (n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]);
+				if (dot <= 0.25 * std::sqrt(lengths))
+					return false;
+			}
+			return true;
+		}
+
+		/** Triangles that disappear when from moves onto to. */
+		size_t SharedTriangles(unsigned int from, unsigned int to) const {
+			size_t count = 0;
+			for (uint32_t a = offsets[from]; a < offsets[from + 1]; a++) {
+				const unsigned int* t = &triangles[adjacency[a] * 3];
+				count += group[t[0]] == to || group[t[1]] == to || group[t[2]] == to;
+			}
+			return count;
+		}
+
+		/** Marks from and every group around it so this pass leaves them alone. */
+		void Touch(unsigned int from, unsigned int to) {
+			touched[to] = 1;
+			for (uint32_t a = offsets[from]; a < offsets[from + 1]; a++) {
+				const unsigned int* t = &triangles[adjacency[a] * 3];
+				for (int k = 0; k < 3; k++)
+					touched[group[t[k]]] = 1;
+			}
+		}
+
+		static uint64_t EdgeKey(unsigned int a, unsigned int b) {
+			return a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a;
+		}
+
+		/** True if g is the third corner of a triangle on the edge. */
+		bool IsOpposite(unsigned int from, unsigned int to, unsigned int g) const {
+			for (uint32_t a = offsets[from]; a < offsets[from + 1]; a++) {
+				const unsigned int* t = &triangles[adjacency[a] * 3];
+				bool hasTo = false, hasG = false;
+				for (int k = 0; k < 3; k++) {
+					hasTo |= group[t[k]] == to;
+					hasG |= group[t[k]] == g;
+				}
+				if (hasTo && hasG)
+					return true;
+			}
+			return false;
+		}
+
+		bool AddPartner(unsigned int variant, unsigned int partner) {
+			unsigned int existing = PartnerOf(variant);
+			if (existing != UINT32_MAX)
+				return existing == partner;
+			partners.push_back(variant);
+			partners.push_back(partner);
+			return true;
+		}
+
+		unsigned int PartnerOf(unsigned int variant) const {
+			for (size_t i = 0; i < partners.size(); i += 2) {
+				if (partners[i] == variant)
+					return partners[i + 1];
+			}
+			return UINT32_MAX;
+		}
+
+		const float* vertices;
+		size_t vertexCount, stride, positionOffset;
+
+		/** Current triangles, indexing the input vertices. */
+		std::vector<unsigned int> triangles;
+		/** Group of each vertex, see BuildGroups(). */
+		std::vector<unsigned int> group;
+		std::vector<Quadric> quadrics;
+		std::vector<uint8_t> locked;
+
+		std::vector<uint32_t> offsets, adjacency;
+		std::vector<Collapse> collapses;
+		/** Groups changed or next to a change this pass. */
+		std::vector<uint8_t> touched;
+		/** Variant pairs of the collapse being checked. */
+		std::vector<unsigned int> partners;
+		/** Neighbors of from, marked with the current stamp. */
+		std::vector<uint32_t> marks;
+		uint32_t stamp = 0;
+	};
+
+	size_t MeshSimplifier::Simplify(unsigned int* destination, const unsigned int* indices, size_t indexCount,
+		const float* vertices, size_t vertexCount, size_t stride, size_t positionOffset,
+		size_t targetIndexCount, float targetError, float* resultError) {
+
+		Simplification s(vertices, vertexCount, stride, positionOffset);
+		s.triangles.assign(indices, indices + indexCount / 3 * 3);
+		s.BuildGroups();
+		s.DropDegenerate();
+		s.BuildQuadrics();
+		s.marks.assign(vertexCount, 0);
+
+		double scale = Scale(vertices, vertexCount, stride, positionOffset);
+		double limit = (double)targetError * scale;
+		double limitSq = limit * limit;
+		double worst = 0;
+
+		std::vector<unsigned int> remap(vertexCount);
+		while (s.triangles.size() > targetIndexCount) {
+			s.BuildAdjacency();
+			s.BuildCollapses();
+			s.touched.assign(vertexCount, 0);
+			for (size_t v = 0; v < vertexCount; v++)
+				remap[v] = (unsigned int)v;
+
+			size_t triangleCount = s.triangles.size() / 3;
+			size_t performed = 0;
+			for (size_t i = 0; i < s.collapses.size(); i++) {
+				const Collapse& c = s.collapses[i];
+				// Sorted, everything after is worse.
+				if (triangleCount * 3 <= targetIndexCount || c.error > limitSq)
+					break;
+				if (s.touched[c.from] || s.touched[c.to] || !s.CanCollapse(c.from, c.to))
+					continue;
+
+				for (size_t p = 0; p < s.partners.size(); p += 2)
+					remap[s.partners[p]] = s.partners[p + 1];
+				s.quadrics[c.to].Add(s.quadrics[c.from]);
+				triangleCount -= s.SharedTriangles(c.from, c.to);
+				s.Touch(c.from, c.to);
+				worst = c.error > worst ? c.error : worst;
+				performed++;
+			}
+			if (performed == 0)
+				break;
+
+			for (size_t i = 0; i < s.triangles.size(); i++)
+				s.triangles[i] = remap[s.triangles[i]];
+			s.DropDegenerate();
+		}
+
+		if (resultError != nullptr)
+			*resultError = scale > 0 ? (float)(std::sqrt(worst) / scale) : 0.0f;
+
+		std::copy(s.triangles.begin(), s.triangles.end(), destination);
+		return s.triangles.size();
+	}
+
+	float MeshSimplifier::Scale(const float* vertices, size_t vertexCount, size_t stride, size_t positionOffset) {
+		if (vertexCount == 0)
+			return 0;
+
+		float min[3], max[3];
+		for (int k = 0; k < 3; k++)
+			min[k] = max[k] = vertices[positionOffset + k];
+		for (size_t v = 1; v < vertexCount; v++) {
+			const float* p = vertices + v * stride + positionOffset;
+			for (int k = 0; k < 3; k++) {
+				min[k] = p[k] < min[k] ? p[k] : min[k];
+				max[k] = p[k] > max[k] ? p[k] : max[k];
+			}
+		}
+		float extent = max[0] - min[0];
+		extent = max[1] - min[1] > extent ? max[1] - min[1] : extent;
+		extent = max[2] - min[2] > extent ? max[2] - min[2] : extent;
+		return extent;
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+
+namespace ResourceLib {
+
+	/**
+	 * Quadric error metric simplification of indexed triangle meshes.
+	 *
+	 * Vertices with the same position form one corner of the surface even
+	 * when uvs or normals differ. Every corner gets the area weighted
+	 * plane quadrics of its triangles, and edges are collapsed onto one of
+	 * their ends, cheapest first, in passes where each corner moves at most
+	 * once. A collapse is refused when it would flip a triangle, move a
+	 * corner off the open border of the mesh, or tear a uv or normal seam:
+	 * every variant of the moved corner needs a variant of the kept corner
+	 * across a shared edge to take over.
+	 *
+	 * Only indices change, output triangles index the input vertices, so
+	 * simplified levels can share one vertex buffer with the original.
+	 */
+	class MeshSimplifier {
+	public:
+		/**
+		 * Simplifies towards targetIndexCount indices, stopping early once
+		 * the next collapse would exceed targetError.
+		 *
+		 * @destination needs room for indexCount indices.
+		 * @targetError is relative to Scale(), 0.01 is 1% of the mesh size.
+		 * @resultError if not null receives the largest error, relative as well.
+		 * @returns the number of indices written.
+		 */
+		static size_t Simplify(unsigned int* destination, const unsigned int* indices, size_t indexCount,
+			const float* vertices, size_t vertexCount, size_t stride, size_t positionOffset,
+			size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+		/** The size errors are relative to, the largest extent of the positions. */
+		static float Scale(const float* vertices, size_t vertexCount, size_t stride, size_t positionOffset);
+	};
+}
@@ -0,0 +1,716 @@
+#include "ObjParser.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+namespace ResourceLib {
+
+	////////////////////
+	// NUMBER PARSING //
+	////////////////////
+
+	static inline bool IsSpace(char c) {
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	static inline bool IsDigit(char c) {
+		return (unsigned)(c - '0') < 10;
+	}
+
+	static inline const char* SkipSpace(const char* p, const char* end) {
+		while (p < end && IsSpace(*p))
+			p++;
+		return p;
+	}
+
+	static inline const char* SkipLine(const char* p, const char* end) {
+		while (p < end && *p != '\n')
+			p++;
+		return p < end ? p + 1 : end;
+	}
+
+	/** Exact powers of ten, a double holds them without rounding up to 1e22. */
+	static const double powersOfTen[23] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	/**
+	 * Parses a decimal float, returns the end of the number or p if there
+	 * was none.
+	 *
+	 * Up to 19 significant digits are gathered in an integer and scaled by
+	 * an exact power of ten, one rounding for typical OBJ numbers. Anything
+	 * unusual (nan, inf, huge exponents) goes through strtod.
+	 */
+	static const char* ParseFloat(const char* p, const char* end, float* out) {
+		const char* start = p;
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			p++;
+		}
+
+		uint64_t mantissa = 0;
+		int digits = 0, exponent = 0;
+		bool any = false;
+
+		while (p < end && IsDigit(*p)) {
+			if (digits < 19) {
+				mantissa = mantissa * 10 + (*p - '0');
+				if (mantissa != 0)
+					digits++;
+			}
+			else {
+				exponent++;
+			}
+			any = true;
+			p++;
+		}
+		if (p < end && *p == '.') {
+			p++;
+			while (p < end && IsDigit(*p)) {
+				if (digits < 19) {
+					mantissa = mantissa * 10 + (*p - '0');
+					if (mantissa != 0)
+						digits++;
+					exponent--;
+				}
+				any = true;
+				p++;
+			}
+		}
+
+		if (!any) {
+			// Not a plain number, let the C library have a go.
+			char buffer[64];
+			size_t n = 0;
+			while (start + n < end && n < sizeof(buffer) - 1 && !IsSpace(start[n]) && start[n] != '\n')
+				n++;
+			for (size_t i = 0; i < n; i++)
+				buffer[i] = start[i];
+			buffer[n] = '\0';
+			char* stop;
+			double value = strtod(buffer, &stop);
+			if (stop == buffer)
+				return start;
+			*out = (float)value;
+			return start + (stop - buffer);
+		}
+
+		if (p < end && (*p == 'e' || *p == 'E')) {
+			const char* e = p + 1;
+			bool negativeExponent = false;
+			if (e < end && (*e == '-' || *e == '+')) {
+				negativeExponent = *e == '-';
+				e++;
+			}
+			if (e < end && IsDigit(*e)) {
+				int value = 0;
+				while (e < end && IsDigit(*e)) {
+					if (value < 10000)
+						value = value * 10 + (*e - '0');
+					e++;
+				}
+				exponent += negativeExponent ? -value : value;
+				p = e;
+			}
+		}
+
+		double value = (double)mantissa;
+		if (exponent < 0 && exponent >= -22)
+			value /= powersOfTen[-exponent];
+		else if (exponent > 0 && exponent <= 22)
+			value *= powersOfTen[exponent];
+		else if (exponent != 0)
+			value *= std::pow(10.0, exponent);
+
+		*out = (float)(negative ? -value : value);
+		return p;
+	}
+
+	/** Parses a signed integer, returns the end of the number or p if there was none. */
+	static inline const char* ParseInt(const char* p, const char* end, long long* out) {
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			p++;
+		}
+		if (p >= end || !IsDigit(*p))
+			return p - (negative ? 1 : 0);
+
+		long long value = 0;
+		while (p < end && IsDigit(*p))
+			value = value * 10 + (*p++ - '0');
+		*out = negative ? -value : value;
+		return p;
+	}
+
+	//////////////////
+	// VERTEX DEDUP //
+	//////////////////
+
+	/** Open addressing map from a (v, vt, vn) triple to an output vertex. */
+	class VertexTable {
+	public:
+		/** Returns the vertex of a triple, or adds it as next if new. */
+		uint32_t FindOrAdd(int32_t v, int32_t vt, int32_t vn, uint32_t next, bool* added) {
+			// Grow before half full, linear probing degrades fast past that.
+			if ((count + 1) * 2 > entries.size())
+				Grow();
+
+			size_t mask = entries.size() - 1;
+			size_t slot = Hash(v, vt, vn) & mask;
+			while (true) {
+				Entry& entry = entries[slot];
+				if (entry.index == Empty) {
+					entry.v = v;
+					entry.vt = vt;
+					entry.vn = vn;
+					entry.index = next;
+					count++;
+					*added = true;
+					return next;
+				}
+				if (entry.v == v && entry.vt == vt && entry.vn == vn) {
+					*added = false;
+					return entry.index;
+				}
+				slot = (slot + 1) & mask;
+			}
+		}
+
+		static size_t Hash(int32_t v, int32_t vt, int32_t vn) {
+			uint64_t h = (uint32_t)v;
+			h = h * 0x9E3779B97F4A7C15ull ^ (uint32_t)vt;
+			h = h * 0x9E3779B97F4A7C15ull ^ (uint32_t)vn;
+			h *= 0x9E3779B97F4A7C15ull;
+			return (size_t)(h ^ (h >> 32));
+		}
+
+	private:
+		static const uint32_t Empty = 0xFFFFFFFF;
+
+		struct Entry {
+			int32_t v, vt, vn;
+			uint32_t index = Empty;
+		};
+
+		void Grow() {
+			std::vector<Entry> old;
+			old.swap(entries);
+			entries.resize(old.empty() ? 1024 : old.size() * 2);
+
+			size_t mask = entries.size() - 1;
+			for (size_t i = 0; i < old.size(); i++) {
+				if (old[i].index == Empty)
+					continue;
+				size_t slot = Hash(old[i].v, old[i].vt, old[i].vn) & mask;
+				while (entries[slot].index != Empty)
+					slot = (slot + 1) & mask;
+				entries[slot] = old[i];
+			}
+		}
+
+		std::vector<Entry> entries;
+		size_t count = 0;
+	};
+
+	/** Resolves a 1 based or negative OBJ index against count elements, -1 if invalid or absent. */
+	static inline int32_t Resolve(long long index, size_t count) {
+		long long resolved = index > 0 ? index - 1 : (long long)count + index;
+		return resolved >= 0 && resolved < (long long)count ? (int32_t)resolved : -1;
+	}
+
+	/////////////
+	// RECORDS //
+	/////////////
+
+	/** The records the parser reads, everything else is skipped. */
+	enum class Record {
+		Position,
+		Uv,
+		Normal,
+		Face,
+		Other
+	};
+
+	/** Classifies the line at p, which must not be whitespace, and moves past its keyword. */
+	static inline Record ReadKeyword(const char*& p, const char* end) {
+		if (p[0] == 'v' && p + 1 < end) {
+			if (IsSpace(p[1])) {
+				p += 1;
+				return Record::Position;
+			}
+			if (p[1] == 't') {
+				p += 2;
+				return Record::Uv;
+			}
+			if (p[1] == 'n') {
+				p += 2;
+				return Record::Normal;
+			}
+		}
+		if (p[0] == 'f' && p + 1 < end && IsSpace(p[1])) {
+			p += 1;
+			return Record::Face;
+		}
+		return Record::Other;
+	}
+
+	/** Appends count floats, missing ones as 0, and skips the rest of the line. */
+	static inline const char* ReadFloats(const char* p, const char* end, int count, std::vector<float>& target) {
+		for (int i = 0; i < count; i++) {
+			float value = 0;
+			p = ParseFloat(SkipSpace(p, end), end, &value);
+			target.push_back(value);
+		}
+		// w, vertex colors or a third uv are ignored.
+		return SkipLine(p, end);
+	}
+
+	/** Reads one v/vt/vn face corner, returns p if there is none. vt and vn are 0 when absent. */
+	static inline const char* ReadCorner(const char* p, const char* end, long long* v, long long* vt, long long* vn) {
+		*v = *vt = *vn = 0;
+		const char* next = ParseInt(p, end, v);
+		if (next == p)
+			return p;
+		p = next;
+		if (p < end && *p == '/') {
+			p = ParseInt(p + 1, end, vt);
+			if (p < end && *p == '/')
+				p = ParseInt(p + 1, end, vn);
+		}
+		return p;
+	}
+
+	/** Appends the triangles of a polygon. */
+	static inline void Triangulate(const std::vector<uint32_t>& face, std::vector<unsigned int>& indices) {
+		if (face.size() == 4) {
+			// The split the original loader used, kept so output matches.
+			const uint32_t quad[6] = { face[0], face[1], face[3], face[1], face[2], face[3] };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+		else {
+			for (size_t i = 1; i + 1 < face.size(); i++) {
+				indices.push_back(face[0]);
+				indices.push_back(face[i]);
+				indices.push_back(face[i + 1]);
+			}
+		}
+	}
+
+	/** Appends the interleaved vertex of a resolved triple. */
+	static inline void WriteVertex(float* out, int32_t position, int32_t uv, int32_t normal, const float* positions, const float* uvs, const float* normals) {
+		out[0] = positions[position * 3];
+		out[1] = positions[position * 3 + 1];
+		out[2] = positions[position * 3 + 2];
+		out[3] = uv >= 0 ? uvs[uv * 2] : 0;
+		out[4] = uv >= 0 ? uvs[uv * 2 + 1] : 0;
+		out[5] = normal >= 0 ? normals[normal * 3] : 0;
+		out[6] = normal >= 0 ? normals[normal * 3 + 1] : 0;
+		out[7] = normal >= 0 ? normals[normal * 3 + 2] : 0;
+	}
+
+	////////////
+	// SERIAL //
+	////////////
+
+	/** The single pass parser, resolving and deduplicating corners as they are read. */
+	static size_t ParseSerial(const char* text, size_t size, std::vector<float>& vertices, std::vector<unsigned int>& indices) {
+		std::vector<float> positions, uvs, normals;
+		VertexTable table;
+		std::vector<uint32_t> face;
+		size_t badFaces = 0;
+
+		const char* p = text;
+		const char* end = text + size;
+		while (p < end) {
+			p = SkipSpace(p, end);
+			if (p >= end)
+				break;
+
+			switch (ReadKeyword(p, end)) {
+			case Record::Position:
+				p = ReadFloats(p, end, 3, positions);
+				break;
+			case Record::Uv:
+				p = ReadFloats(p, end, 2, uvs);
+				break;
+			case Record::Normal:
+				p = ReadFloats(p, end, 3, normals);
+				break;
+			case Record::Face: {
+				face.clear();
+				bool bad = false;
+
+				while (true) {
+					p = SkipSpace(p, end);
+					long long v, vt, vn;
+					const char* next = ReadCorner(p, end, &v, &vt, &vn);
+					if (next == p)
+						break;
+					p = next;
+
+					int32_t position = Resolve(v, positions.size() / 3);
+					int32_t uv = vt != 0 ? Resolve(vt, uvs.size() / 2) : -1;
+					int32_t normal = vn != 0 ? Resolve(vn, normals.size() / 3) : -1;
+					if (position < 0 || (vt != 0 && uv < 0) || (vn != 0 && normal < 0)) {
+						bad = true;
+						continue;
+					}
+
+					bool added;
+					uint32_t index = table.FindOrAdd(position, uv, normal, (uint32_t)(vertices.size() / ObjParser::Stride), &added);
+					if (added) {
+						vertices.resize(vertices.size() + ObjParser::Stride);
+						WriteVertex(&vertices[vertices.size() - ObjParser::Stride], position, uv, normal, positions.data(), uvs.data(), normals.data());
+					}
+					face.push_back(index);
+				}
+				p = SkipLine(p, end);
+
+				if (bad || face.size() < 3)
+					badFaces++;
+				else
+					Triangulate(face, indices);
+				break;
+			}
+			default:
+				// Comments, groups, materials and smoothing.
+				p = SkipLine(p, end);
+				break;
+			}
+		}
+		return badFaces;
+	}
+
+	//////////////
+	// PARALLEL //
+	//////////////
+
+	/** Runs f(t) for t in [0, threads), the first on the calling thread. */
+	template<class F>
+	static void Parallel(unsigned threads, F f) {
+		std::vector<std::thread> workers;
+		for (unsigned t = 1; t < threads; t++)
+			workers.push_back(std::thread(f, t));
+		f(0);
+		for (size_t i = 0; i < workers.size(); i++)
+			workers[i].join();
+	}
+
+	/** A face corner as written, indices unresolved. */
+	struct Corner {
+		long long v, vt, vn;
+	};
+
+	/** A face and the element counts of its chunk when it was read. */
+	struct Face {
+		uint32_t firstCorner, cornerCount;
+		uint32_t positions, uvs, normals;
+	};
+
+	/** A resolved (v, vt, vn) triple. */
+	struct Triple {
+		int32_t v, vt, vn;
+	};
+
+	/** A newline aligned piece of the file and everything derived from it. */
+	struct Chunk {
+		const char* begin;
+		const char* end;
+
+		// Read from the text.
+		std::vector<float> positions, uvs, normals;
+		std::vector<Corner> corners;
+		std::vector<Face> faces;
+
+		// Elements in earlier chunks.
+		size_t positionBase = 0, uvBase = 0, normalBase = 0;
+
+		/** Distinct triples in order of first use within the chunk. */
+		std::vector<Triple> uniques;
+		/** Triangles indexing uniques. */
+		std::vector<unsigned int> triangles;
+		size_t badFaces = 0;
+
+		/** Chunk << 32 | unique of the first use of each unique across chunks. */
+		std::vector<uint64_t> owners;
+		/** Output vertex of each unique. */
+		std::vector<uint32_t> vertexIds;
+		size_t newVertices = 0, vertexBase = 0, indexBase = 0;
+	};
+
+	/** Reads the records of a chunk without resolving anything. */
+	static void ReadChunk(Chunk& chunk) {
+		const char* p = chunk.begin;
+		const char* end = chunk.end;
+		while (p < end) {
+			p = SkipSpace(p, end);
+			if (p >= end)
+				break;
+
+			switch (ReadKeyword(p, end)) {
+			case Record::Position:
+				p = ReadFloats(p, end, 3, chunk.positions);
+				break;
+			case Record::Uv:
+				p = ReadFloats(p, end, 2, chunk.uvs);
+				break;
+			case Record::Normal:
+				p = ReadFloats(p, end, 3, chunk.normals);
+				break;
+			case Record::Face: {
+				Face face;
+				face.firstCorner = (uint32_t)chunk.corners.size();
+				face.positions = (uint32_t)(chunk.positions.size() / 3);
+				face.uvs = (uint32_t)(chunk.uvs.size() / 2);
+				face.normals = (uint32_t)(chunk.normals.size() / 3);
+				while (true) {
+					p = SkipSpace(p, end);
+					Corner corner;
+					const char* next = ReadCorner(p, end, &corner.v, &corner.vt, &corner.vn);
+					if (next == p)
+						break;
+					p = next;
+					chunk.corners.push_back(corner);
+				}
+				face.cornerCount = (uint32_t)chunk.corners.size() - face.firstCorner;
+				chunk.faces.push_back(face);
+				p = SkipLine(p, end);
+				break;
+			}
+			default:
+				p = SkipLine(p, end);
+				break;
+			}
+		}
+	}
+
+	/**
+	 * Resolves a chunk's corners against the elements read up to each face
+	 * and deduplicates them within the chunk, in the same order and with
+	 * the same bad face rules as ParseSerial().
+	 */
+	static void ResolveChunk(Chunk& chunk) {
+		VertexTable table;
+		std::vector<uint32_t> face;
+
+		for (size_t f = 0; f < chunk.faces.size(); f++) {
+			const Face& record = chunk.faces[f];
+			size_t positionCount = chunk.positionBase + record.positions;
+			size_t uvCount = chunk.uvBase + record.uvs;
+			size_t normalCount = chunk.normalBase + record.normals;
+
+			face.clear();
+			bool bad = false;
+			for (uint32_t c = 0; c < record.cornerCount; c++) {
+				const Corner& corner = chunk.corners[record.firstCorner + c];
+				int32_t position = Resolve(corner.v, positionCount);
+				int32_t uv = corner.vt != 0 ? Resolve(corner.vt, uvCount) : -1;
+				int32_t normal = corner.vn != 0 ? Resolve(corner.vn, normalCount) : -1;
+				if (position < 0 || (corner.vt != 0 && uv < 0) || (corner.vn != 0 && normal < 0)) {
+					bad = true;
+					continue;
+				}
+
+				bool added;
+				uint32_t index = table.FindOrAdd(position, uv, normal, (uint32_t)chunk.uniques.size(), &added);
+				if (added) {
+					Triple triple = { position, uv, normal };
+					chunk.uniques.push_back(triple);
+				}
+				face.push_back(index);
+			}
+
+			if (bad || face.size() < 3)
+				chunk.badFaces++;
+			else
+				Triangulate(face, chunk.triangles);
+		}
+
+		std::vector<Corner>().swap(chunk.corners);
+		std::vector<Face>().swap(chunk.faces);
+	}
+
+	/**
+	 * Parses newline aligned chunks on every thread and merges them.
+	 *
+	 * 1. Each chunk reads its records into its own buffers.
+	 * 2. Prefix sums of the element counts give every chunk its bases, the
+	 *    elements are gathered and each chunk resolves and deduplicates its
+	 *    corners locally.
+	 * 3. Triples are split between threads by hash, each thread walks every
+	 *    chunk in order and finds the first use of the triples it owns.
+	 * 4. A prefix sum of the first uses numbers the output vertices, which
+	 *    then is first use order across the file just like ParseSerial().
+	 */
+	static size_t ParseChunked(const char* text, size_t size, unsigned threads, std::vector<float>& vertices, std::vector<unsigned int>& indices) {
+		// A few chunks per thread evens out lines of different cost.
+		size_t chunkCount = threads * 4;
+		std::vector<Chunk> chunks(chunkCount);
+		const char* end = text + size;
+		const char* p = text;
+		for (size_t c = 0; c < chunkCount; c++) {
+			const char* split = c + 1 == chunkCount ? end : text + size * (c + 1) / chunkCount;
+			if (split < p)
+				split = p;
+			while (split < end && split[-1] != '\n')
+				split++;
+			chunks[c].begin = p;
+			chunks[c].end = split;
+			p = split;
+		}
+
+		/////////////////
+		// READ CHUNKS //
+		/////////////////
+		Parallel(threads, [&](unsigned t) {
+			for (size_t c = t; c < chunkCount; c += threads)
+				ReadChunk(chunks[c]);
+		});
+
+		std::vector<float> positions, uvs, normals;
+		size_t positionCount = 0, uvCount = 0, normalCount = 0;
+		for (size_t c = 0; c < chunkCount; c++) {
+			chunks[c].positionBase = positionCount;
+			chunks[c].uvBase = uvCount;
+			chunks[c].normalBase = normalCount;
+			positionCount += chunks[c].positions.size() / 3;
+			uvCount += chunks[c].uvs.size() / 2;
+			normalCount += chunks[c].normals.size() / 3;
+		}
+		positions.resize(positionCount * 3);
+		uvs.resize(uvCount * 2);
+		normals.resize(normalCount * 3);
+
+		////////////////////////////
+		// GATHER, RESOLVE, DEDUP //
+		////////////////////////////
+		Parallel(threads, [&](unsigned t) {
+			for (size_t c = t; c < chunkCount; c += threads) {
+				Chunk& chunk = chunks[c];
+				std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionBase * 3);
+				std::copy(chunk.uvs.begin(), chunk.uvs.end(), uvs.begin() + chunk.uvBase * 2);
+				std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalBase * 3);
+				std::vector<float>().swap(chunk.positions);
+				std::vector<float>().swap(chunk.uvs);
+				std::vector<float>().swap(chunk.normals);
+
+				ResolveChunk(chunk);
+				chunk.owners.resize(chunk.uniques.size());
+				chunk.vertexIds.resize(chunk.uniques.size());
+			}
+		});
+
+		////////////////
+		// FIRST USES //
+		////////////////
+		Parallel(threads, [&](unsigned t) {
+			VertexTable table;
+			std::vector<uint64_t> firstUses;
+			for (size_t c = 0; c < chunkCount; c++) {
+				Chunk& chunk = chunks[c];
+				for (size_t u = 0; u < chunk.uniques.size(); u++) {
+					const Triple& triple = chunk.uniques[u];
+					size_t hash = VertexTable::Hash(triple.v, triple.vt, triple.vn);
+					// High bits pick the thread, the table uses the low ones.
+					if ((hash >> 24) % threads != t)
+						continue;
+
+					bool added;
+					uint32_t first = table.FindOrAdd(triple.v, triple.vt, triple.vn, (uint32_t)firstUses.size(), &added);
+					if (added)
+						firstUses.push_back((uint64_t)c << 32 | u);
+					chunk.owners[u] = firstUses[first];
+				}
+			}
+		});
+
+		//////////////////
+		// NUMBER, EMIT //
+		//////////////////
+		Parallel(threads, [&](unsigned t) {
+			for (size_t c = t; c < chunkCount; c += threads) {
+				Chunk& chunk = chunks[c];
+				chunk.newVertices = 0;
+				for (size_t u = 0; u < chunk.owners.size(); u++)
+					chunk.newVertices += chunk.owners[u] == ((uint64_t)c << 32 | u);
+			}
+		});
+
+		size_t vertexCount = 0, indexCount = 0, badFaces = 0;
+		for (size_t c = 0; c < chunkCount; c++) {
+			chunks[c].vertexBase = vertexCount;
+			chunks[c].indexBase = indexCount;
+			vertexCount += chunks[c].newVertices;
+			indexCount += chunks[c].triangles.size();
+			badFaces += chunks[c].badFaces;
+		}
+		vertices.resize(vertexCount * ObjParser::Stride);
+		indices.resize(indexCount);
+
+		// First uses get numbers and write their vertex.
+		Parallel(threads, [&](unsigned t) {
+			for (size_t c = t; c < chunkCount; c += threads) {
+				Chunk& chunk = chunks[c];
+				uint32_t next = (uint32_t)chunk.vertexBase;
+				for (size_t u = 0; u < chunk.owners.size(); u++) {
+					if (chunk.owners[u] != ((uint64_t)c << 32 | u))
+						continue;
+					const Triple& triple = chunk.uniques[u];
+					WriteVertex(&vertices[(size_t)next * ObjParser::Stride], triple.v, triple.vt, triple.vn, positions.data(), uvs.data(), normals.data());
+					chunk.vertexIds[u] = next++;
+				}
+			}
+		});
+
+		// Later uses take the number of their first, then indices are remapped.
+		Parallel(threads, [&](unsigned t) {
+			for (size_t c = t; c < chunkCount; c += threads) {
+				Chunk& chunk = chunks[c];
+				for (size_t u = 0; u < chunk.owners.size(); u++) {
+					uint64_t owner = chunk.owners[u];
+					if (owner != ((uint64_t)c << 32 | u))
+						chunk.vertexIds[u] = chunks[owner >> 32].vertexIds[owner & 0xFFFFFFFF];
+				}
+				for (size_t i = 0; i < chunk.triangles.size(); i++)
+					indices[chunk.indexBase + i] = chunk.vertexIds[chunk.triangles[i]];
+			}
+		});
+
+		return badFaces;
+	}
+
+	bool ObjParser::Parse(const char* text, size_t size, std::vector<float>& vertices, std::vector<unsigned int>& indices, unsigned threadCount) {
+		vertices.clear();
+		indices.clear();
+
+		if (threadCount == 0)
+			threadCount = std::thread::hardware_concurrency();
+
+		// Small files aren't worth starting threads for.
+		size_t badFaces;
+		if (threadCount <= 1 || size < ParallelSize)
+			badFaces = ParseSerial(text, size, vertices, indices);
+		else
+			badFaces = ParseChunked(text, size, threadCount, vertices, indices);
+
+		if (badFaces > 0)
+			printf("ObjParser: skipped %zu faces with missing elements.\n", badFaces);
+		return badFaces == 0;
+	}
+
+	bool ObjParser::ParseFile(const std::string& filename, std::vector<float>& vertices, std::vector<unsigned int>& indices, unsigned threadCount) {
+		MappedFile file;
+		if (!file.Open(filename))
+			return false;
+		return Parse(file.Data(), file.Size(), vertices, indices, threadCount);
+	}
+}
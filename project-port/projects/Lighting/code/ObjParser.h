@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace ResourceLib {
+
+	/**
+	 * Wavefront OBJ reader producing MeshResource vertex data.
+	 *
+	 * One pass over the text, usually a MappedFile, with hand rolled
+	 * number parsing. Face corners are deduplicated on their resolved
+	 * (v, vt, vn) triple through an open addressing hash, so vertices come
+	 * out in order of first use, interleaved as position (3), uv (2) and
+	 * normal (3). Missing uvs and normals are zero, negative indices count
+	 * back from the last element, quads split along the 1-3 diagonal and
+	 * larger polygons are fanned.
+	 *
+	 * Large files are split into newline aligned chunks parsed on every
+	 * core and merged so the output is identical to the serial pass.
+	 */
+	class ObjParser {
+	public:
+		/** Floats per output vertex. */
+		static const size_t Stride = 8;
+
+		/** Files smaller than this are parsed on the calling thread. */
+		static const size_t ParallelSize = 1 << 20;
+
+		/**
+		 * Parses OBJ text.
+		 *
+		 * @returns false if a face refers to an element that doesn't exist,
+		 * such faces are skipped and the rest is still parsed.
+		 *
+		 * @threadCount 0 uses every core, 1 the serial single pass.
+		 */
+		static bool Parse(const char* text, size_t size, std::vector<float>& vertices, std::vector<unsigned int>& indices, unsigned threadCount = 0);
+
+		/** Maps a file and parses it, false if it can't be opened or had bad faces. */
+		static bool ParseFile(const std::string& filename, std::vector<float>& vertices, std::vector<unsigned int>& indices, unsigned threadCount = 0);
+	};
+}
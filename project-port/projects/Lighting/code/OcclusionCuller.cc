@@ -0,0 +1,388 @@
+#include "OcclusionCuller.h"
+#include "MeshResource.h"
+
+#include <cmath>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCCLUSION_SSE 1
+#include <emmintrin.h>
+#endif
+
+GG::OcclusionCuller::OcclusionCuller(int width, int height) {
+	tilesX = (width + TileSize - 1) / TileSize;
+	tilesY = (height + TileSize - 1) / TileSize;
+	this->width = tilesX * TileSize;
+	this->height = tilesY * TileSize;
+
+	depth.assign((size_t)this->width * this->height, 0.0f);
+	tiles.assign((size_t)tilesX * tilesY, 0.0f);
+}
+
+void GG::OcclusionCuller::Begin(const MathLib::Mat4& viewProjection) {
+	this->viewProjection = viewProjection;
+	triangles.clear();
+	stats = Stats();
+}
+
+void GG::OcclusionCuller::AddOccluder(const ResourceLib::MeshResource& mesh, const MathLib::Mat4& world) {
+	const ResourceLib::Attribute* position = nullptr;
+	for (size_t i = 0; i < mesh.attributes.size(); i++) {
+		if (mesh.attributes[i].name == "pos") {
+			position = &mesh.attributes[i];
+			break;
+		}
+	}
+	if (position == nullptr && !mesh.attributes.empty())
+		position = &mesh.attributes[0];
+
+	// Occluders need their CPU data, keep proxies loaded.
+	if (position == nullptr || ResourceLib::VertexFormat::Components(position->type, position->length) < 3 ||
+		mesh.GetVertexDataSize() == 0 || mesh.GetIndexCount() == 0)
+		return;
+
+	// Full detail, simplified levels may bulge out of the drawn surface.
+	size_t indexCount = mesh.GetLod(0).indexCount;
+	const uint32_t* indices = (const uint32_t*)mesh.GetIndexData();
+	if (mesh.indexSize != sizeof(uint32_t)) {
+		decodedIndices.resize(indexCount);
+		for (size_t i = 0; i < indexCount; i++)
+			decodedIndices[i] = mesh.GetIndex(i);
+		indices = decodedIndices.data();
+	}
+
+	if (position->type == ResourceLib::Attribute::Type::Float) {
+		AddOccluder((const float*)(mesh.GetVertexData() + position->offset), position->stride / sizeof(float), indices, indexCount, world);
+		return;
+	}
+
+	// Compact positions are decoded every frame, another reason for small proxies.
+	size_t vertexCount = mesh.GetVertexDataSize() / position->stride;
+	decodedPositions.resize(vertexCount * 3);
+	ResourceLib::VertexFormat::DecodeArray(position->type, position->length, mesh.GetVertexData() + position->offset, position->stride,
+		vertexCount, decodedPositions.data(), 3);
+	AddOccluder(decodedPositions.data(), 3, indices, indexCount, world);
+}
+
+void GG::OcclusionCuller::AddOccluder(const float* positions, size_t stride, const uint32_t* indices, size_t indexCount, const MathLib::Mat4& world) {
+	MathLib::Mat4 matrix = viewProjection * world;
+	const float* m = matrix.Data();
+
+	size_t vertexCount = 0;
+	for (size_t i = 0; i < indexCount; i++) {
+		if (indices[i] >= vertexCount)
+			vertexCount = indices[i] + 1;
+	}
+
+	/////////////////////////
+	// VERTICES TO CLIP    //
+	/////////////////////////
+	std::vector<float>& clip = clipVertices;
+	clip.resize(vertexCount * 4);
+	for (size_t v = 0; v < vertexCount; v++) {
+		const float* p = positions + v * stride;
+		for (int r = 0; r < 4; r++)
+			clip[v * 4 + r] = m[r * 4] * p[0] + m[r * 4 + 1] * p[1] + m[r * 4 + 2] * p[2] + m[r * 4 + 3];
+	}
+
+	stats.occluders++;
+
+	////////////////////////
+	// NEAR PLANE CLIP    //
+	////////////////////////
+	for (size_t i = 0; i + 2 < indexCount; i += 3) {
+		const float* v[3] = { &clip[indices[i] * 4], &clip[indices[i + 1] * 4], &clip[indices[i + 2] * 4] };
+
+		// Signed distance to the near plane, z >= -w inside.
+		float d[3];
+		int inside = 0;
+		for (int k = 0; k < 3; k++) {
+			d[k] = v[k][2] + v[k][3];
+			inside += d[k] >= 0;
+		}
+
+		if (inside == 3) {
+			SetupTriangle(v[0], v[1], v[2]);
+			continue;
+		}
+		if (inside == 0)
+			continue;
+
+		// One plane clip of a triangle gives a triangle or a quad.
+		float polygon[4][4];
+		int count = 0;
+		for (int k = 0; k < 3; k++) {
+			int n = (k + 1) % 3;
+			if (d[k] >= 0) {
+				for (int c = 0; c < 4; c++)
+					polygon[count][c] = v[k][c];
+				count++;
+			}
+			if ((d[k] >= 0) != (d[n] >= 0)) {
+				float t = d[k] / (d[k] - d[n]);
+				for (int c = 0; c < 4; c++)
+					polygon[count][c] = v[k][c] + (v[n][c] - v[k][c]) * t;
+				count++;
+			}
+		}
+		for (int k = 1; k + 1 < count; k++)
+			SetupTriangle(polygon[0], polygon[k], polygon[k + 1]);
+	}
+}
+
+void GG::OcclusionCuller::SetupTriangle(const float* v0, const float* v1, const float* v2) {
+	const float* v[3] = { v0, v1, v2 };
+	float x[3], y[3], invW[3];
+	for (int k = 0; k < 3; k++) {
+		// Exactly on the near plane of an orthographic projection.
+		if (v[k][3] <= 0)
+			return;
+		invW[k] = 1.0f / v[k][3];
+		x[k] = (v[k][0] * invW[k] * 0.5f + 0.5f) * width;
+		y[k] = (v[k][1] * invW[k] * 0.5f + 0.5f) * height;
+	}
+
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+	if (area == 0 || std::isnan(area))
+		return;
+
+	Triangle tri;
+	tri.minX = (int)std::floor(std::fmin(x[0], std::fmin(x[1], x[2])));
+	tri.maxX = (int)std::ceil(std::fmax(x[0], std::fmax(x[1], x[2])));
+	tri.minY = (int)std::floor(std::fmin(y[0], std::fmin(y[1], y[2])));
+	tri.maxY = (int)std::ceil(std::fmax(y[0], std::fmax(y[1], y[2])));
+	tri.minX = tri.minX < 0 ? 0 : tri.minX;
+	tri.minY = tri.minY < 0 ? 0 : tri.minY;
+	tri.maxX = tri.maxX > width - 1 ? width - 1 : tri.maxX;
+	tri.maxY = tri.maxY > height - 1 ? height - 1 : tri.maxY;
+	if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+		return;
+
+	// Edge k is opposite vertex k, both windings are drawn.
+	float sign = area > 0 ? 1.0f : -1.0f;
+	for (int k = 0; k < 3; k++) {
+		int a = (k + 1) % 3, b = (k + 2) % 3;
+		tri.edgeA[k] = (y[a] - y[b]) * sign;
+		tri.edgeB[k] = (x[b] - x[a]) * sign;
+		tri.edgeC[k] = (x[a] * y[b] - y[a] * x[b]) * sign;
+	}
+
+	// 1/w is linear in screen space.
+	float du1 = invW[1] - invW[0], du2 = invW[2] - invW[0];
+	tri.depthA = (du1 * (y[2] - y[0]) - du2 * (y[1] - y[0])) / area;
+	tri.depthB = (du2 * (x[1] - x[0]) - du1 * (x[2] - x[0])) / area;
+	tri.depthC = invW[0] - tri.depthA * x[0] - tri.depthB * y[0];
+
+	triangles.push_back(tri);
+}
+
+void GG::OcclusionCuller::Rasterize() {
+	stats.triangles = (uint32_t)triangles.size();
+
+	bool simd = false;
+#ifdef OCCLUSION_SSE
+	simd = !reference && MathLib::SIMD::GetLevel() != MathLib::SIMD::Level::Scalar;
+#endif
+
+	int threads = reference ? 1 : threadCount;
+	threads = threads < 1 ? 1 : (threads > tilesY ? tilesY : threads);
+
+	if (threads == 1) {
+		RasterizeRows(0, height, simd);
+		return;
+	}
+
+	// Bands of whole tile rows, so each band also owns its tiles.
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; t++) {
+		int begin = tilesY * t / threads * TileSize;
+		int end = tilesY * (t + 1) / threads * TileSize;
+		workers.push_back(std::thread(&OcclusionCuller::RasterizeRows, this, begin, end, simd));
+	}
+	RasterizeRows(0, tilesY / threads * TileSize, simd);
+
+	for (size_t t = 0; t < workers.size(); t++)
+		workers[t].join();
+}
+
+void GG::OcclusionCuller::RasterizeRows(int rowBegin, int rowEnd, bool simd) {
+	std::fill(depth.begin() + (size_t)rowBegin * width, depth.begin() + (size_t)rowEnd * width, 0.0f);
+
+	for (size_t i = 0; i < triangles.size(); i++) {
+		const Triangle& tri = triangles[i];
+		int y0 = tri.minY > rowBegin ? tri.minY : rowBegin;
+		int y1 = tri.maxY < rowEnd - 1 ? tri.maxY : rowEnd - 1;
+
+		for (int y = y0; y <= y1; y++) {
+			float fy = y + 0.5f;
+			float* row = &depth[(size_t)y * width];
+
+			// Per row parts of the plane equations, shared by both paths.
+			float rowEdge[3], rowDepth = tri.depthB * fy;
+			for (int k = 0; k < 3; k++)
+				rowEdge[k] = tri.edgeB[k] * fy;
+
+#ifdef OCCLUSION_SSE
+			if (simd) {
+				const __m128 laneOffset = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+				const __m128 half = _mm_set1_ps(0.5f);
+				__m128 minX = _mm_set1_ps((float)tri.minX), maxX = _mm_set1_ps((float)tri.maxX);
+				__m128 ea[3], eb[3], ec[3];
+				for (int k = 0; k < 3; k++) {
+					ea[k] = _mm_set1_ps(tri.edgeA[k]);
+					eb[k] = _mm_set1_ps(rowEdge[k]);
+					ec[k] = _mm_set1_ps(tri.edgeC[k]);
+				}
+				__m128 da = _mm_set1_ps(tri.depthA), db = _mm_set1_ps(rowDepth), dc = _mm_set1_ps(tri.depthC);
+				__m128 zero = _mm_setzero_ps();
+
+				// Width is whole tiles, aligned blocks of four never overrun.
+				for (int x = tri.minX & ~3; x <= tri.maxX; x += 4) {
+					__m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffset);
+					__m128 fx = _mm_add_ps(px, half);
+
+					__m128 mask = _mm_and_ps(_mm_cmpge_ps(px, minX), _mm_cmple_ps(px, maxX));
+					for (int k = 0; k < 3; k++) {
+						__m128 e = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ea[k], fx), eb[k]), ec[k]);
+						mask = _mm_and_ps(mask, _mm_cmpge_ps(e, zero));
+					}
+					if (_mm_movemask_ps(mask) == 0)
+						continue;
+
+					__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(da, fx), db), dc);
+					__m128 old = _mm_loadu_ps(row + x);
+					_mm_storeu_ps(row + x, _mm_max_ps(old, _mm_and_ps(d, mask)));
+				}
+				continue;
+			}
+#endif
+			for (int x = tri.minX; x <= tri.maxX; x++) {
+				float fx = x + 0.5f;
+				bool inside = true;
+				for (int k = 0; k < 3; k++)
+					inside = inside && tri.edgeA[k] * fx + rowEdge[k] + tri.edgeC[k] >= 0;
+				if (!inside)
+					continue;
+
+				float d = tri.depthA * fx + rowDepth + tri.depthC;
+				if (d > row[x])
+					row[x] = d;
+			}
+		}
+	}
+
+	////////////////////
+	// BUILD TILES    //
+	////////////////////
+	for (int ty = rowBegin / TileSize; ty < rowEnd / TileSize; ty++) {
+		for (int tx = 0; tx < tilesX; tx++) {
+			float farthest = depth[(size_t)ty * TileSize * width + tx * TileSize];
+			for (int y = 0; y < TileSize; y++) {
+				const float* row = &depth[(size_t)(ty * TileSize + y) * width + tx * TileSize];
+				for (int x = 0; x < TileSize; x++)
+					farthest = row[x] < farthest ? row[x] : farthest;
+			}
+			tiles[(size_t)ty * tilesX + tx] = farthest;
+		}
+	}
+}
+
+bool GG::OcclusionCuller::Project(const ResourceLib::AABB& box, int* rect, float* nearest) const {
+	const float* m = viewProjection.Data();
+
+	float minX = 0, minY = 0, maxX = 0, maxY = 0;
+	*nearest = 0;
+	for (int c = 0; c < 8; c++) {
+		float p[3] = { (c & 1) ? box.max[0] : box.min[0], (c & 2) ? box.max[1] : box.min[1], (c & 4) ? box.max[2] : box.min[2] };
+		float clip[4];
+		for (int r = 0; r < 4; r++)
+			clip[r] = m[r * 4] * p[0] + m[r * 4 + 1] * p[1] + m[r * 4 + 2] * p[2] + m[r * 4 + 3];
+
+		// Reaching past the near plane, too close to test.
+		if (clip[3] <= 0 || clip[2] < -clip[3])
+			return false;
+
+		float invW = 1.0f / clip[3];
+		float x = (clip[0] * invW * 0.5f + 0.5f) * width;
+		float y = (clip[1] * invW * 0.5f + 0.5f) * height;
+		if (c == 0) {
+			minX = maxX = x;
+			minY = maxY = y;
+		}
+		minX = std::fmin(minX, x);
+		maxX = std::fmax(maxX, x);
+		minY = std::fmin(minY, y);
+		maxY = std::fmax(maxY, y);
+		*nearest = std::fmax(*nearest, invW);
+	}
+
+	rect[0] = (int)std::floor(minX);
+	rect[1] = (int)std::floor(minY);
+	rect[2] = (int)std::floor(maxX);
+	rect[3] = (int)std::floor(maxY);
+	rect[0] = rect[0] < 0 ? 0 : rect[0];
+	rect[1] = rect[1] < 0 ? 0 : rect[1];
+	rect[2] = rect[2] > width - 1 ? width - 1 : rect[2];
+	rect[3] = rect[3] > height - 1 ? height - 1 : rect[3];
+
+	// Off screen is for the frustum culler to decide.
+	return rect[0] <= rect[2] && rect[1] <= rect[3];
+}
+
+bool GG::OcclusionCuller::IsVisible(const ResourceLib::AABB& box) const {
+	int rect[4];
+	float nearest;
+	if (!Project(box, rect, &nearest))
+		return true;
+
+	if (reference) {
+		for (int y = rect[1]; y <= rect[3]; y++) {
+			for (int x = rect[0]; x <= rect[2]; x++) {
+				if (depth[(size_t)y * width + x] <= nearest)
+					return true;
+			}
+		}
+		return false;
+	}
+
+	// Hidden only if the farthest occluder of every tile is in front.
+	for (int ty = rect[1] / TileSize; ty <= rect[3] / TileSize; ty++) {
+		for (int tx = rect[0] / TileSize; tx <= rect[2] / TileSize; tx++) {
+			if (tiles[(size_t)ty * tilesX + tx] <= nearest)
+				return true;
+		}
+	}
+	return false;
+}
+
+void GG::OcclusionCuller::RenderOccluders(const ResourceLib::SceneStore& scene, const std::vector<uint32_t>& indices) {
+	for (size_t k = 0; k < indices.size(); k++) {
+		size_t i = indices[k];
+		if (scene.active[i] && scene.occluders[i] != nullptr)
+			AddOccluder(*scene.occluders[i], scene.world[i]);
+	}
+	Rasterize();
+}
+
+void GG::OcclusionCuller::Filter(const ResourceLib::SceneStore& scene, const std::vector<uint32_t>& indices) {
+	static const float zero[3] = { 0, 0, 0 };
+
+	stats.tested = (uint32_t)indices.size();
+	if (triangles.empty()) {
+		visible = indices;
+		stats.occluded = 0;
+		return;
+	}
+
+	visible.clear();
+	for (size_t k = 0; k < indices.size(); k++) {
+		size_t i = indices[k];
+		const ResourceLib::MeshResource* mr = scene.meshes[i];
+		ResourceLib::AABB box = ResourceLib::AABB::Transform(mr ? mr->boundsCenter : zero, mr ? mr->boundsExtents : zero, scene.world[i]);
+
+		if (IsVisible(box))
+			visible.push_back((uint32_t)i);
+	}
+
+	stats.occluded = (uint32_t)(indices.size() - visible.size());
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "SceneStore.h"
+#include "AABBTree.h"
+#include "MathLib.h"
+
+namespace ResourceLib {
+	class MeshResource;
+}
+
+namespace GG {
+
+	/**
+	 * CPU occlusion culling against a small software depth buffer.
+	 *
+	 * Selected occluders are rasterized into a low resolution buffer of
+	 * 1/w, larger is nearer and 0 is empty. Rows are split into bands
+	 * rasterized on separate threads, four pixels at a time with SSE.
+	 * Each 8x8 tile then keeps its farthest depth, and an occludee is
+	 * hidden when its nearest corner is behind that for every tile its
+	 * screen rectangle covers.
+	 *
+	 * Edge and depth plane equations are evaluated per pixel the same way
+	 * on every path, so the buffer is bit identical with any thread count
+	 * or instruction set. Runs without GL and can be tested headless.
+	 */
+	class OcclusionCuller {
+	public:
+		/** Culled and kept occludees of the last Filter(). */
+		struct Stats {
+			uint32_t occluders = 0;
+			uint32_t triangles = 0;
+			uint32_t tested = 0;
+			uint32_t occluded = 0;
+		};
+
+		/** Pixels per side of a depth tile. */
+		static const int TileSize = 8;
+
+		/** Size of the depth buffer, rounded up to whole tiles. */
+		OcclusionCuller(int width = 256, int height = 128);
+
+		/** Rasterizer threads, 1 rasterizes on the calling thread. */
+		int threadCount = 4;
+
+		/**
+		 * Brute force reference: one thread, no SIMD and every pixel of
+		 * an occludee's rectangle tested instead of the tiles.
+		 */
+		bool reference = false;
+
+		/** Starts a frame, clearing the occluders and the depth buffer. */
+		void Begin(const MathLib::Mat4& viewProjection);
+
+		/**
+		 * Adds a triangle mesh with loaded data as an occluder.
+		 *
+		 * Use a simplified proxy that lies inside the real mesh, a larger
+		 * proxy hides things that should be seen.
+		 */
+		void AddOccluder(const ResourceLib::MeshResource& mesh, const MathLib::Mat4& world);
+
+		/** Adds indexed triangles from xyz positions. */
+		void AddOccluder(const float* positions, size_t stride, const uint32_t* indices, size_t indexCount, const MathLib::Mat4& world);
+
+		/** Rasterizes the added occluders and builds the tiles. */
+		void Rasterize();
+
+		/** Returns false if a world space box is fully hidden by the occluders. */
+		bool IsVisible(const ResourceLib::AABB& box) const;
+
+		/**
+		 * Adds the occluders among the given entries of a scene, see
+		 * GraphicsNode::SetOccluder(), and rasterizes them.
+		 */
+		void RenderOccluders(const ResourceLib::SceneStore& scene, const std::vector<uint32_t>& indices);
+
+		/** Keeps the entries of a list of dense scene indices that are not hidden. */
+		void Filter(const ResourceLib::SceneStore& scene, const std::vector<uint32_t>& indices);
+
+		/** Dense scene indices that passed the last Filter(). */
+		const std::vector<uint32_t>& GetVisible() const {
+			return visible;
+		}
+
+		int GetWidth() const {
+			return width;
+		}
+
+		int GetHeight() const {
+			return height;
+		}
+
+		/** The 1/w buffer, rows bottom up. */
+		const std::vector<float>& GetDepth() const {
+			return depth;
+		}
+
+		const Stats& GetStats() const {
+			return stats;
+		}
+
+	private:
+		/** A screen space triangle set up for rasterizing. */
+		struct Triangle {
+			/** Edge functions a * x + b * y + c, >= 0 inside. */
+			float edgeA[3], edgeB[3], edgeC[3];
+			/** 1/w as a plane over the screen. */
+			float depthA, depthB, depthC;
+			/** Pixel bounds, inclusive. */
+			int minX, minY, maxX, maxY;
+		};
+
+		/** Sets up a triangle from clip space vertices in front of the near plane. */
+		void SetupTriangle(const float* v0, const float* v1, const float* v2);
+
+		/** Rasterizes every triangle into the rows [rowBegin, rowEnd) and builds their tiles. */
+		void RasterizeRows(int rowBegin, int rowEnd, bool simd);
+
+		/** Screen rectangle and nearest 1/w of a box, false if it reaches the near plane. */
+		bool Project(const ResourceLib::AABB& box, int* rect, float* nearest) const;
+
+		int width, height;
+		int tilesX, tilesY;
+
+		MathLib::Mat4 viewProjection;
+		std::vector<Triangle> triangles;
+		/** Scratch for an occluder's clip space vertices. */
+		std::vector<float> clipVertices;
+		/** Scratch for positions and indices of compact occluder meshes. */
+		std::vector<float> decodedPositions;
+		std::vector<uint32_t> decodedIndices;
+
+		/** 1/w per pixel. */
+		std::vector<float> depth;
+		/** Smallest 1/w per tile, the farthest occluder in it. */
+		std::vector<float> tiles;
+
+		std::vector<uint32_t> visible;
+		Stats stats;
+	};
+
+}
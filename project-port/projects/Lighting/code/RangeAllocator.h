@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <map>
+
+namespace ResourceLib {
+
+	/**
+	 * Hands out ranges of a linear space, e.g. elements of a GPU buffer.
+	 *
+	 * Free ranges are kept sorted by offset, allocation is first fit and
+	 * freeing merges with the neighbouring free ranges, so the space does
+	 * not splinter when meshes come and go. Only bookkeeping, the caller
+	 * owns the actual storage.
+	 */
+	class RangeAllocator {
+	public:
+		/** Returned by Allocate() when no free range is large enough. */
+		static const size_t Invalid = (size_t)-1;
+
+		RangeAllocator(size_t capacity = 0) {
+			Grow(capacity);
+		}
+
+		/** Reserves size elements, returns the offset or Invalid. */
+		size_t Allocate(size_t size) {
+			if (size == 0)
+				return Invalid;
+
+			for (auto it = freeRanges.begin(); it != freeRanges.end(); it++) {
+				if (it->second < size)
+					continue;
+
+				size_t offset = it->first;
+				size_t remaining = it->second - size;
+				freeRanges.erase(it);
+				if (remaining > 0)
+					freeRanges[offset + size] = remaining;
+
+				used += size;
+				return offset;
+			}
+			return Invalid;
+		}
+
+		/** Returns a range from Allocate() to the free list. */
+		void Free(size_t offset, size_t size) {
+			if (size == 0)
+				return;
+			used -= size;
+
+			auto next = freeRanges.lower_bound(offset);
+
+			// Merge with the following range.
+			if (next != freeRanges.end() && offset + size == next->first) {
+				size += next->second;
+				next = freeRanges.erase(next);
+			}
+
+			// Merge with the preceding range.
+			if (next != freeRanges.begin()) {
+				auto prev = std::prev(next);
+				if (prev->first + prev->second == offset) {
+					prev->second += size;
+					return;
+				}
+			}
+
+			freeRanges[offset] = size;
+		}
+
+		/** Extends the space to a larger capacity, the new tail is free. */
+		void Grow(size_t newCapacity) {
+			if (newCapacity <= capacity)
+				return;
+
+			size_t oldCapacity = capacity;
+			capacity = newCapacity;
+
+			// Free() counts the range as released, balance that.
+			used += newCapacity - oldCapacity;
+			Free(oldCapacity, newCapacity - oldCapacity);
+		}
+
+		/** Forgets every allocation. */
+		void Reset(size_t capacity) {
+			freeRanges.clear();
+			this->capacity = 0;
+			used = 0;
+			Grow(capacity);
+		}
+
+		size_t GetCapacity() const {
+			return capacity;
+		}
+
+		/** Elements currently allocated. */
+		size_t GetUsed() const {
+			return used;
+		}
+
+	private:
+		/** Free ranges, offset to size. */
+		std::map<size_t, size_t> freeRanges;
+		size_t capacity = 0;
+		size_t used = 0;
+	};
+}
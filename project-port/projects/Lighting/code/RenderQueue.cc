@@ -0,0 +1,290 @@
+#include "RenderQueue.h"
+#include "GraphicsGlue.h"
+
+#include <cmath>
+#include <cstring>
+
+uint64_t GG::RenderQueue::MakeKey(Pass pass, DepthOrder order, uint32_t program, uint32_t texture, uint32_t mesh, float viewDepth) {
+	// Non negative floats sort like their bits, keep the top 24.
+	if (!(viewDepth > 0.0f))
+		viewDepth = 0.0f;
+	uint32_t bits;
+	std::memcpy(&bits, &viewDepth, sizeof(bits));
+	uint64_t depth = bits >> (32 - DepthBits);
+	if (order == DepthOrder::BackToFront)
+		depth = ((uint64_t(1) << DepthBits) - 1) - depth;
+
+	uint64_t state = uint64_t(program & ((1u << ProgramBits) - 1));
+	state = (state << TextureBits) | (texture & ((1u << TextureBits) - 1));
+	state = (state << MeshBits) | (mesh & ((1u << MeshBits) - 1));
+
+	uint64_t key = uint64_t(pass) << (64 - PassBits);
+	if (order == DepthOrder::FrontToBack)
+		key |= (state << DepthBits) | depth;
+	else
+		key |= (depth << (ProgramBits + TextureBits + MeshBits)) | state;
+	return key;
+}
+
+void GG::RenderQueue::Submit(ResourceLib::GraphicsNode* node, Pass pass, float viewDepth, uint32_t lod) {
+	ResourceLib::ShaderResource* sr = node->GetShaderResource().get();
+	ResourceLib::TextureResource* tr = node->GetTextureResource().get();
+	ResourceLib::MeshResource* mr = node->GetMeshResource().get();
+
+	// Slot indices are small and stable, 0 means no texture.
+	uint32_t program = sr->program.index;
+	uint32_t texture = (tr != nullptr && tr->texture.IsSet()) ? tr->texture.index + 1 : 0;
+
+	// Arena first so multi draws stay together, then a hash of the mesh
+	// and level so its instances do. A collision only costs an instanced
+	// command.
+	uint32_t meshHash = (uint32_t)((((uintptr_t)mr >> 4) + lod) * 2654435761u) >> 22;
+	uint32_t mesh = ((mr->vbo.index & 0xF) << 10) | meshHash;
+
+	DepthOrder order = (pass == Pass::Opaque) ? opaqueOrder : transparentOrder;
+
+	Packet packet;
+	packet.key = MakeKey(pass, order, program, texture, mesh, viewDepth);
+	packet.node = node;
+	packet.lod = lod;
+	packets.push_back(packet);
+}
+
+void GG::RenderQueue::SubmitScene(ResourceLib::SceneStore& scene, const MathLib::Mat4& view) {
+	// Third row of the view matrix gives view space z, the camera looks down -z.
+	const float* v = view.Data() + 8;
+
+	for (size_t i = 0; i < scene.Size(); i++) {
+		if (scene.active[i])
+			SubmitEntry(scene, i, v);
+	}
+}
+
+void GG::RenderQueue::SubmitScene(ResourceLib::SceneStore& scene, const MathLib::Mat4& view, const std::vector<uint32_t>& indices) {
+	const float* v = view.Data() + 8;
+
+	for (size_t k = 0; k < indices.size(); k++)
+		SubmitEntry(scene, indices[k], v);
+}
+
+void GG::RenderQueue::SubmitEntry(ResourceLib::SceneStore& scene, size_t i, const float* v) {
+	const float* w = scene.world[i].Data();
+	float z = v[0] * w[3] + v[1] * w[7] + v[2] * w[11] + v[3];
+
+	////////////////////////////
+	// SELECT LEVEL OF DETAIL //
+	////////////////////////////
+	const ResourceLib::MeshResource* mr = scene.meshes[i];
+	size_t levels = mr->GetLodCount();
+	uint32_t lod = 0;
+	if (levels > 1 && lodScale > 0) {
+		// Largest axis scale of the model matrix.
+		float scaleSq = 0;
+		for (int c = 0; c < 3; c++) {
+			float s = w[c] * w[c] + w[4 + c] * w[4 + c] + w[8 + c] * w[8 + c];
+			scaleSq = s > scaleSq ? s : scaleSq;
+		}
+		float scale = std::sqrt(scaleSq);
+
+		// Nearest the bounding sphere gets along the view direction.
+		const float* c = mr->boundsCenter;
+		float centerX = w[0] * c[0] + w[1] * c[1] + w[2] * c[2] + w[3];
+		float centerY = w[4] * c[0] + w[5] * c[1] + w[6] * c[2] + w[7];
+		float centerZ = w[8] * c[0] + w[9] * c[1] + w[10] * c[2] + w[11];
+		float distance = -(v[0] * centerX + v[1] * centerY + v[2] * centerZ + v[3]) - mr->boundsRadius * scale;
+
+		if (distance > 0) {
+			// Pixels the surface of a level may be off by.
+			float pixels = lodScale * scale / distance;
+			lod = scene.lods[i] < levels ? scene.lods[i] : 0;
+			while (lod + 1 < levels && mr->GetLod(lod + 1).error * pixels <= lodPixelError * (1.0f - lodHysteresis))
+				lod++;
+			while (lod > 0 && mr->GetLod(lod).error * pixels > lodPixelError)
+				lod--;
+		}
+		scene.lods[i] = (uint8_t)lod;
+	}
+
+	Submit(scene.nodes[i], scene.transparent[i] ? Pass::Transparent : Pass::Opaque, -z, lod);
+}
+
+void GG::RenderQueue::Sort() {
+	size_t n = packets.size();
+	if (n < 2)
+		return;
+
+	// LSD radix sort, 8 bits per pass, histograms for all passes at once.
+	uint32_t counts[8][256];
+	std::memset(counts, 0, sizeof(counts));
+	for (size_t i = 0; i < n; i++) {
+		uint64_t key = packets[i].key;
+		for (int b = 0; b < 8; b++)
+			counts[b][(key >> (b * 8)) & 0xFF]++;
+	}
+
+	scratch.resize(n);
+	Packet* src = packets.data();
+	Packet* dst = scratch.data();
+
+	for (int b = 0; b < 8; b++) {
+		uint32_t* count = counts[b];
+
+		// Every key shares this byte, the pass would not move anything.
+		if (count[(src[0].key >> (b * 8)) & 0xFF] == n)
+			continue;
+
+		uint32_t offset = 0;
+		for (int d = 0; d < 256; d++) {
+			uint32_t c = count[d];
+			count[d] = offset;
+			offset += c;
+		}
+
+		for (size_t i = 0; i < n; i++)
+			dst[count[(src[i].key >> (b * 8)) & 0xFF]++] = src[i];
+
+		Packet* t = src;
+		src = dst;
+		dst = t;
+	}
+
+	// Odd number of passes leaves the result in the scratch buffer.
+	if (src != packets.data())
+		packets.swap(scratch);
+}
+
+void GG::RenderQueue::BuildBatches() {
+	batches.clear();
+	instances.clear();
+	commands.clear();
+
+	size_t n = packets.size();
+	for (size_t i = 0; i < n; ) {
+		ResourceLib::GraphicsNode* node = packets[i].node;
+		ResourceLib::ShaderResource* sr = node->GetShaderResource().get();
+		ResourceLib::TextureResource* tr = node->GetTextureResource().get();
+		ResourceLib::MeshResource* mr = node->GetMeshResource().get();
+		uint64_t pass = packets[i].key >> (64 - PassBits);
+
+		// Extend the run while program, texture and arenas are shared.
+		bool forceInstanced = mr->mode == ResourceLib::MeshResource::Mode::Instanced;
+		size_t j = i + 1;
+		while (j < n) {
+			ResourceLib::GraphicsNode* other = packets[j].node;
+			ResourceLib::MeshResource* otherMesh = other->GetMeshResource().get();
+			if ((packets[j].key >> (64 - PassBits)) != pass ||
+				other->GetShaderResource().get() != sr ||
+				other->GetTextureResource().get() != tr ||
+				otherMesh->vbo != mr->vbo ||
+				otherMesh->ibo != mr->ibo)
+				break;
+			forceInstanced |= otherMesh->mode == ResourceLib::MeshResource::Mode::Instanced;
+			j++;
+		}
+
+		Batch batch;
+		batch.first = i;
+		batch.count = j - i;
+		batch.firstCommand = -1;
+		batch.commandCount = 0;
+
+		bool wanted = batch.count >= instanceThreshold || forceInstanced;
+		if (wanted && sr->instanced != nullptr && sr->instanced->program.IsSet()) {
+			batch.firstCommand = (GLint)commands.size();
+
+			// One command per run of the same mesh and level.
+			ResourceLib::MeshResource* last = nullptr;
+			uint32_t lastLod = 0;
+			for (size_t k = i; k < j; k++) {
+				ResourceLib::MeshResource* m = packets[k].node->GetMeshResource().get();
+				if (m != last || packets[k].lod != lastLod) {
+					ResourceLib::MeshResource::Lod lod = m->GetLod(packets[k].lod);
+					ResourceHandler::DrawCommand command;
+					command.count = (GLuint)lod.indexCount;
+					command.instanceCount = 0;
+					command.firstIndex = (GLuint)(m->firstIndex + lod.indexOffset);
+					command.baseVertex = (GLint)m->baseVertex;
+					command.baseInstance = (GLuint)instances.size();
+					commands.push_back(command);
+					last = m;
+					lastLod = packets[k].lod;
+				}
+				commands.back().instanceCount++;
+
+				ResourceHandler::ObjectBlock instance;
+				instance.model = packets[k].node->GetWorldMatrix();
+				instance.normalMat = packets[k].node->GetNormalMatrix();
+				instances.push_back(instance);
+			}
+
+			batch.commandCount = commands.size() - batch.firstCommand;
+		}
+
+		batches.push_back(batch);
+		i = j;
+	}
+}
+
+void GG::RenderQueue::Draw() {
+	BuildBatches();
+	ResourceHandler::UploadDraws(instances.data(), instances.size(), commands.data(), commands.size());
+
+	ResourceLib::ShaderResource* lastShader = nullptr;
+	ResourceLib::TextureResource* lastTexture = nullptr;
+	bool programBound = false;
+	bool blending = false;
+
+	for (size_t b = 0; b < batches.size(); b++) {
+		const Batch& batch = batches[b];
+		ResourceLib::GraphicsNode* node = packets[batch.first].node;
+		ResourceLib::ShaderResource* sr = node->GetShaderResource().get();
+		ResourceLib::TextureResource* tr = node->GetTextureResource().get();
+
+		bool instanced = batch.firstCommand >= 0;
+		if (instanced)
+			sr = sr->instanced.get();
+
+		// Pass boundary.
+		bool transparent = (packets[batch.first].key >> (64 - PassBits)) == (uint64_t)Pass::Transparent;
+		if (transparent != blending) {
+			blending = transparent;
+			if (blending) {
+				glEnable(GL_BLEND);
+				glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+				glDepthMask(GL_FALSE);
+			}
+			else {
+				glDisable(GL_BLEND);
+				glDepthMask(GL_TRUE);
+			}
+		}
+
+		// Program boundary, also resets the texture binding.
+		if (sr != lastShader) {
+			lastShader = sr;
+			lastTexture = nullptr;
+			programBound = ResourceHandler::BindProgram(sr);
+		}
+		if (!programBound)
+			continue;
+
+		// Texture boundary.
+		if (tr != lastTexture) {
+			lastTexture = tr;
+			ResourceHandler::BindTextures(sr, tr);
+		}
+
+		if (instanced) {
+			ResourceHandler::DrawIndirect(sr, node->GetMeshResource().get(), batch.firstCommand, batch.commandCount);
+		}
+		else {
+			for (size_t k = batch.first; k < batch.first + batch.count; k++)
+				ResourceHandler::DrawObject(packets[k].node, packets[k].lod);
+		}
+	}
+
+	if (blending) {
+		glDisable(GL_BLEND);
+		glDepthMask(GL_TRUE);
+	}
+}
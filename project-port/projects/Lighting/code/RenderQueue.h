@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "GraphicsGlue.h"
+#include "GraphicsNode.h"
+#include "SceneStore.h"
+#include "MathLib.h"
+
+namespace GG {
+
+	/**
+	 * Per frame list of draws, sorted to minimize state changes.
+	 *
+	 * Every draw is a packet with a 64 bit key. From the most significant
+	 * bits down the key holds the pass, then either the state (program,
+	 * texture, mesh) followed by depth, or for back to front passes depth
+	 * followed by state, since blending needs the order more than batching.
+	 * Keys are radix sorted and Draw() only rebinds at key boundaries.
+	 *
+	 * Consecutive packets sharing shader, texture and mesh arenas are drawn
+	 * with one multi draw when the shader has an instanced variant, each
+	 * run of the same mesh being one instanced command.
+	 *
+	 * SubmitScene() picks a level of detail per node: the coarsest whose
+	 * error, projected to the screen, stays under lodPixelError. A node
+	 * only coarsens once comfortably under it, so levels don't flicker
+	 * when a node sits at a threshold.
+	 */
+	class RenderQueue {
+	public:
+		/** Passes in submission order. */
+		enum class Pass : uint8_t {
+			Opaque = 0,
+			Transparent = 1
+		};
+
+		/** How a pass orders draws by view depth. */
+		enum class DepthOrder {
+			/** State first, then nearest first to reject hidden fragments early. */
+			FrontToBack,
+			/** Farthest first, required for correct blending. */
+			BackToFront
+		};
+
+		/** A single draw. */
+		struct Packet {
+			uint64_t key;
+			ResourceLib::GraphicsNode* node;
+			/** Level of detail of the node's mesh. */
+			uint32_t lod;
+		};
+
+		/** Depth ordering of the opaque pass. */
+		DepthOrder opaqueOrder = DepthOrder::FrontToBack;
+		/** Depth ordering of the transparent pass. */
+		DepthOrder transparentOrder = DepthOrder::BackToFront;
+
+		/** Smallest run drawn indirectly, Mode::Instanced meshes always are. */
+		size_t instanceThreshold = 2;
+
+		/** Largest on screen error of a level of detail, in pixels. */
+		float lodPixelError = 1.0f;
+		/** Fraction below lodPixelError a coarser level must be to switch to it. */
+		float lodHysteresis = 0.25f;
+
+		/**
+		 * Sets how many pixels a unit covers one unit in front of the camera,
+		 * needed to select levels of detail. Until set, full detail is drawn.
+		 */
+		void SetLodProjection(const MathLib::Mat4& projection, int viewportHeight) {
+			// The y scale of a perspective projection is 1 / tan(fov / 2).
+			lodScale = projection.Data()[5] * viewportHeight * 0.5f;
+		}
+
+		/** Empties the queue, keeping its memory. */
+		void Clear() {
+			packets.clear();
+		}
+
+		/**
+		 * Queues a node.
+		 *
+		 * @viewDepth is the distance along the view direction, >= 0 in front.
+		 * @lod is the level of detail of the node's mesh.
+		 */
+		void Submit(ResourceLib::GraphicsNode* node, Pass pass, float viewDepth, uint32_t lod = 0);
+
+		/**
+		 * Queues every active node of a scene using its cached world matrix,
+		 * updating the level of detail kept per entry.
+		 */
+		void SubmitScene(ResourceLib::SceneStore& scene, const MathLib::Mat4& view);
+
+		/** Queues the given dense scene indices, e.g. FrustumCuller::GetVisible(). */
+		void SubmitScene(ResourceLib::SceneStore& scene, const MathLib::Mat4& view, const std::vector<uint32_t>& indices);
+
+		/** Sorts the queued packets by key. */
+		void Sort();
+
+		/**
+		 * Draws the sorted packets, changing state only at key boundaries.
+		 *
+		 * Uploads the instance data and commands of every indirect run
+		 * first, then issues one multi draw per run.
+		 */
+		void Draw();
+
+		/** The queued packets, sorted after Sort(). */
+		const std::vector<Packet>& GetPackets() const {
+			return packets;
+		}
+
+		/** Builds a key, exposed for debugging. */
+		static uint64_t MakeKey(Pass pass, DepthOrder order, uint32_t program, uint32_t texture, uint32_t mesh, float viewDepth);
+
+	private:
+		// Field widths, they add up to 64.
+		static const int PassBits = 2;
+		static const int ProgramBits = 12;
+		static const int TextureBits = 12;
+		static const int MeshBits = 14;
+		static const int DepthBits = 24;
+
+		/** A run of packets drawn together. */
+		struct Batch {
+			size_t first;
+			size_t count;
+			/** First indirect command, -1 if drawn one by one. */
+			GLint firstCommand;
+			size_t commandCount;
+		};
+
+		/** Splits the sorted packets into batches and gathers instances and commands. */
+		void BuildBatches();
+
+		/** Queues scene entry i, selecting its level of detail. */
+		void SubmitEntry(ResourceLib::SceneStore& scene, size_t i, const float* viewRow);
+
+		/** Pixels per unit one unit in front of the camera, 0 if unknown. */
+		float lodScale = 0;
+
+		std::vector<Packet> packets;
+		/** Scratch for the radix sort. */
+		std::vector<Packet> scratch;
+
+		std::vector<Batch> batches;
+		/** Per instance matrices of this frame, uploaded in one go. */
+		std::vector<ResourceHandler::ObjectBlock> instances;
+		/** Indirect commands of this frame. */
+		std::vector<ResourceHandler::DrawCommand> commands;
+	};
+
+}
@@ -0,0 +1,130 @@
+#include "RingBuffer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+void GG::RingBuffer::Create(size_t segmentSize) {
+	Destroy();
+
+	this->segmentSize = segmentSize;
+	size_t total = segmentSize * FrameCount;
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+
+	if (GLEW_ARB_buffer_storage) {
+		// Mapped once for the buffer's lifetime, coherent so no flushes.
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_COPY_WRITE_BUFFER, total, nullptr, flags);
+		mapped = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total, flags);
+	}
+	else {
+		glBufferData(GL_COPY_WRITE_BUFFER, total, nullptr, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	segment = 0;
+	head = 0;
+	overflowed = false;
+}
+
+void GG::RingBuffer::Destroy() {
+	if (buffer == 0)
+		return;
+
+	for (int i = 0; i < FrameCount; i++)
+		Wait(i);
+
+	if (mapped != nullptr) {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		mapped = nullptr;
+	}
+
+	glDeleteBuffers(1, &buffer);
+	buffer = 0;
+}
+
+double GG::RingBuffer::Wait(int segment) {
+	GLsync fence = fences[segment];
+	if (fence == 0)
+		return 0.0;
+
+	double waited = 0.0;
+
+	// Fast path, the GPU is usually done long ago.
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED) {
+		auto start = std::chrono::high_resolution_clock::now();
+		do {
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		} while (result == GL_TIMEOUT_EXPIRED);
+		auto end = std::chrono::high_resolution_clock::now();
+		waited = std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	glDeleteSync(fence);
+	fences[segment] = 0;
+	return waited;
+}
+
+void GG::RingBuffer::BeginFrame() {
+	if (buffer == 0)
+		return;
+
+	// Out of room last frame, start over twice as large.
+	if (overflowed) {
+		printf("RingBuffer: segment of %zu bytes overflowed, growing.\n", segmentSize);
+		Create(segmentSize * 2);
+	}
+
+	segment = (segment + 1) % FrameCount;
+	head = 0;
+
+	lastStall = Wait(segment);
+	if (lastStall > 0.0)
+		stallCount++;
+}
+
+void GG::RingBuffer::EndFrame() {
+	if (buffer == 0)
+		return;
+
+	if (fences[segment] != 0)
+		glDeleteSync(fences[segment]);
+	fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GG::RingBuffer::Allocation GG::RingBuffer::Allocate(size_t size, size_t align) {
+	Allocation allocation;
+
+	size_t start = (head + align - 1) & ~(align - 1);
+	if (buffer == 0 || start + size > segmentSize) {
+		overflowed = true;
+		return allocation;
+	}
+
+	head = start + size;
+	allocation.offset = segment * segmentSize + start;
+	if (mapped != nullptr)
+		allocation.data = (char*)mapped + allocation.offset;
+	return allocation;
+}
+
+size_t GG::RingBuffer::Write(const void* data, size_t size, size_t align) {
+	Allocation allocation = Allocate(size, align);
+	if (allocation.offset == Invalid)
+		return Invalid;
+
+	if (allocation.data != nullptr) {
+		std::memcpy(allocation.data, data, size);
+	}
+	else {
+		// The fence keeps the GPU off this range, so the driver can write directly.
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.offset, size, data);
+	}
+	return allocation.offset;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace GG {
+
+	/**
+	 * Triple buffered stream buffer for per frame data.
+	 *
+	 * One buffer split into a segment per frame in flight. Each frame bump
+	 * allocates from its segment, and a fence placed at EndFrame() guards
+	 * the segment until the GPU is done reading it. With ARB_buffer_storage
+	 * the buffer is mapped persistent and coherent once, so writes are a
+	 * memcpy; without it Write() falls back to glBufferSubData into the
+	 * same fenced ranges.
+	 */
+	class RingBuffer {
+	public:
+		/** Frames the CPU may run ahead of the GPU. */
+		static const int FrameCount = 3;
+
+		/** Returned as offset when a frame's segment is full. */
+		static const size_t Invalid = (size_t)-1;
+
+		/** A range of the current frame's segment. */
+		struct Allocation {
+			/** Mapped write pointer, null without persistent mapping or on failure. */
+			void* data = nullptr;
+			/** Offset in bytes from the start of GetBuffer(). */
+			size_t offset = Invalid;
+		};
+
+		~RingBuffer() {
+			Destroy();
+		}
+
+		/** Creates the buffer with segmentSize bytes per frame. */
+		void Create(size_t segmentSize);
+
+		/** Waits for the GPU and deletes the buffer. */
+		void Destroy();
+
+		bool IsValid() const {
+			return buffer != 0;
+		}
+
+		/** Whether Allocate() hands out write pointers. */
+		bool IsMapped() const {
+			return mapped != nullptr;
+		}
+
+		/**
+		 * Moves to the next segment, waiting on its fence if the GPU is
+		 * still reading it. Grows the buffer if last frame ran out of room.
+		 */
+		void BeginFrame();
+
+		/** Fences the current segment, call after the frame's last draw. */
+		void EndFrame();
+
+		/** Reserves size bytes aligned to align, a power of two. */
+		Allocation Allocate(size_t size, size_t align);
+
+		/** Allocates and copies data in, returns the offset or Invalid. */
+		size_t Write(const void* data, size_t size, size_t align);
+
+		GLuint GetBuffer() const {
+			return buffer;
+		}
+
+		size_t GetSegmentSize() const {
+			return segmentSize;
+		}
+
+		/** Bytes allocated in the current frame so far. */
+		size_t GetFrameUsed() const {
+			return head;
+		}
+
+		/** Milliseconds BeginFrame() waited on the GPU last frame. */
+		double GetLastStall() const {
+			return lastStall;
+		}
+
+		/** Frames that had to wait on the GPU since Create(). */
+		uint32_t GetStallCount() const {
+			return stallCount;
+		}
+
+	private:
+		/** Waits for a segment's fence and deletes it, returns milliseconds waited. */
+		double Wait(int segment);
+
+		GLuint buffer = 0;
+		void* mapped = nullptr;
+		size_t segmentSize = 0;
+
+		int segment = 0;
+		/** Bump pointer within the current segment. */
+		size_t head = 0;
+		bool overflowed = false;
+
+		GLsync fences[FrameCount] = { 0, 0, 0 };
+
+		double lastStall = 0.0;
+		uint32_t stallCount = 0;
+	};
+
+}
@@ -0,0 +1,130 @@
+#include "SceneStore.h"
+#include "MeshResource.h"
+
+ResourceLib::SceneHandle ResourceLib::SceneStore::Add(GraphicsNode* node, MeshResource* mr, TextureResource* tr, ShaderResource* sr) {
+	// Reuse a freed slot if there is one.
+	uint32_t slot;
+	if (!freeSlots.empty()) {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		slot = (uint32_t)slotIndex.size();
+		slotIndex.push_back(0);
+		slotGeneration.push_back(0);
+	}
+
+	slotIndex[slot] = (uint32_t)nodes.size();
+	denseSlot.push_back(slot);
+
+	nodes.push_back(node);
+	world.push_back(MathLib::Mat4::Identity);
+	normal.push_back(MathLib::Mat4::Identity);
+	meshes.push_back(mr);
+	textures.push_back(tr);
+	shaders.push_back(sr);
+	active.push_back(1);
+	transparent.push_back(0);
+	occluders.push_back(nullptr);
+	lods.push_back(0);
+	updates.push_back(std::function<void(void)>());
+	proxies.push_back(AABBTree::Null);
+
+	SceneHandle handle;
+	handle.slot = slot;
+	handle.generation = slotGeneration[slot];
+	return handle;
+}
+
+bool ResourceLib::SceneStore::Remove(SceneHandle handle) {
+	size_t i = IndexOf(handle);
+	if (i == SIZE_MAX)
+		return false;
+
+	SwapPop(i);
+	return true;
+}
+
+void ResourceLib::SceneStore::UpdateBounds(size_t i) {
+	static const float zero[3] = { 0, 0, 0 };
+
+	const MeshResource* mr = meshes[i];
+	AABB box = AABB::Transform(mr ? mr->boundsCenter : zero, mr ? mr->boundsExtents : zero, world[i]);
+
+	if (proxies[i] == AABBTree::Null) {
+		SceneHandle handle = HandleOf(i);
+		proxies[i] = tree.Insert(box, ((uint64_t)handle.slot << 32) | handle.generation);
+	}
+	else {
+		tree.Move(proxies[i], box);
+	}
+}
+
+ResourceLib::SceneHandle ResourceLib::SceneStore::HandleOf(size_t i) const {
+	SceneHandle handle;
+	handle.slot = denseSlot[i];
+	handle.generation = slotGeneration[handle.slot];
+	return handle;
+}
+
+bool ResourceLib::SceneStore::IsValid(SceneHandle handle) const {
+	return handle.slot < slotGeneration.size() && slotGeneration[handle.slot] == handle.generation;
+}
+
+size_t ResourceLib::SceneStore::IndexOf(SceneHandle handle) const {
+	if (!IsValid(handle))
+		return SIZE_MAX;
+	return slotIndex[handle.slot];
+}
+
+void ResourceLib::SceneStore::RemoveInactive() {
+	// Walk backwards so swapped in entries have already been visited.
+	for (size_t i = nodes.size(); i-- > 0; ) {
+		if (!active[i])
+			SwapPop(i);
+	}
+}
+
+void ResourceLib::SceneStore::SwapPop(size_t i) {
+	uint32_t slot = denseSlot[i];
+	size_t last = nodes.size() - 1;
+
+	if (proxies[i] != AABBTree::Null)
+		tree.Remove(proxies[i]);
+
+	if (i != last) {
+		nodes[i] = nodes[last];
+		world[i] = world[last];
+		normal[i] = normal[last];
+		meshes[i] = meshes[last];
+		textures[i] = textures[last];
+		shaders[i] = shaders[last];
+		active[i] = active[last];
+		transparent[i] = transparent[last];
+		occluders[i] = occluders[last];
+		lods[i] = lods[last];
+		updates[i] = std::move(updates[last]);
+		proxies[i] = proxies[last];
+
+		denseSlot[i] = denseSlot[last];
+		slotIndex[denseSlot[i]] = (uint32_t)i;
+	}
+
+	nodes.pop_back();
+	world.pop_back();
+	normal.pop_back();
+	meshes.pop_back();
+	textures.pop_back();
+	shaders.pop_back();
+	active.pop_back();
+	transparent.pop_back();
+	occluders.pop_back();
+	lods.pop_back();
+	updates.pop_back();
+	proxies.pop_back();
+	denseSlot.pop_back();
+
+	// Invalidate outstanding handles and recycle the slot.
+	slotGeneration[slot]++;
+	freeSlots.push_back(slot);
+}
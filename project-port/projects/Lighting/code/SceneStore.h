@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "MathLib.h"
+#include "AABBTree.h"
+
+namespace ResourceLib {
+
+	class GraphicsNode;
+	class MeshResource;
+	class TextureResource;
+	class ShaderResource;
+
+	/**
+	 * Handle to an entry in a SceneStore.
+	 *
+	 * The generation is bumped whenever a slot is freed, so handles to
+	 * removed entries are detected instead of aliasing a newer entry.
+	 */
+	struct SceneHandle {
+		/** Slot in the store's sparse table. */
+		uint32_t slot = UINT32_MAX;
+		/** Generation the slot had when the handle was made. */
+		uint32_t generation = 0;
+
+		bool operator == (const SceneHandle& other) const {
+			return slot == other.slot && generation == other.generation;
+		}
+		bool operator != (const SceneHandle& other) const {
+			return !(*this == other);
+		}
+	};
+
+	/**
+	 * Dense, structure of arrays storage for scene nodes.
+	 *
+	 * Every component lives in its own tightly packed array indexed by the
+	 * same dense index, so a pass touching only a few components walks
+	 * contiguous memory. Add and Remove are O(1), removal swaps the last
+	 * entry into the hole, which means dense indices are not stable and
+	 * SceneHandle should be kept instead.
+	 */
+	class SceneStore {
+	public:
+		// Dense component arrays, all Size() long. Only read or modify the
+		// elements, Add/Remove keep the arrays in sync.
+
+		/** The node owning each entry. */
+		std::vector<GraphicsNode*> nodes;
+		/** Model matrix, written by GraphicsNode::UpdateTransforms(). */
+		std::vector<MathLib::Mat4> world;
+		/** Normal matrix, written by GraphicsNode::UpdateTransforms(). */
+		std::vector<MathLib::Mat4> normal;
+		/** Mesh drawn by each entry. */
+		std::vector<MeshResource*> meshes;
+		/** Texture bound by each entry, may be null. */
+		std::vector<TextureResource*> textures;
+		/** Shader used by each entry. */
+		std::vector<ShaderResource*> shaders;
+		/** Whether the entry is updated and drawn, 0 after Delete(). */
+		std::vector<uint8_t> active;
+		/** Whether the entry is drawn in the blended pass. */
+		std::vector<uint8_t> transparent;
+		/** Occluder proxy with loaded data, null if the entry hides nothing. */
+		std::vector<MeshResource*> occluders;
+		/** Level of detail drawn last frame, kept for hysteresis. */
+		std::vector<uint8_t> lods;
+		/** Per frame update callback, may be empty. */
+		std::vector<std::function<void(void)>> updates;
+		/** Proxy of each entry in tree, AABBTree::Null until UpdateBounds(). */
+		std::vector<int32_t> proxies;
+
+		/**
+		 * World bounds of the entries for spatial queries. User data is
+		 * the packed SceneHandle, see UnpackHandle(), since dense indices
+		 * move on removal. Removed entries leave the tree, deactivated ones
+		 * stay until RemoveInactive() so check active on the results.
+		 */
+		AABBTree tree;
+
+		/** Adds an active entry and returns its handle. */
+		SceneHandle Add(GraphicsNode* node, MeshResource* mr, TextureResource* tr, ShaderResource* sr);
+
+		/**
+		 * Removes an entry by swapping the last entry into its place.
+		 *
+		 * @returns false if the handle was stale.
+		 */
+		bool Remove(SceneHandle handle);
+
+		/** Returns true if the handle refers to a live entry. */
+		bool IsValid(SceneHandle handle) const;
+
+		/** Returns the dense index of a handle, or SIZE_MAX if stale. */
+		size_t IndexOf(SceneHandle handle) const;
+
+		/**
+		 * Moves an entry's mesh bounds to world space and updates the tree.
+		 *
+		 * Called by GraphicsNode when its world matrix or mesh changes.
+		 */
+		void UpdateBounds(size_t i);
+
+		/** The handle of a dense index. */
+		SceneHandle HandleOf(size_t i) const;
+
+		/** A handle from the tree's user data. */
+		static SceneHandle UnpackHandle(uint64_t userData) {
+			SceneHandle handle;
+			handle.slot = (uint32_t)(userData >> 32);
+			handle.generation = (uint32_t)userData;
+			return handle;
+		}
+
+		/** Removes every entry that has been deactivated. */
+		void RemoveInactive();
+
+		/** Number of live entries. */
+		size_t Size() const {
+			return nodes.size();
+		}
+
+	private:
+		/** Moves the last entry into dense index i and pops the arrays. */
+		void SwapPop(size_t i);
+
+		/** Dense index per slot. */
+		std::vector<uint32_t> slotIndex;
+		/** Current generation per slot. */
+		std::vector<uint32_t> slotGeneration;
+		/** Slot per dense index, for patching on swap. */
+		std::vector<uint32_t> denseSlot;
+		/** Slots free for reuse. */
+		std::vector<uint32_t> freeSlots;
+	};
+}
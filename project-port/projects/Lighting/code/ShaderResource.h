@@ -6,9 +6,9 @@
 #include <memory>
 #include <string>
 #include <vector>
-#include <tuple>
 
 #include "MathLib.h"
+#include "SlotMap.h"
 
 namespace ResourceLib {
 
@@ -51,20 +51,179 @@ namespace ResourceLib {
 			None
 		};
 
+		/** Uniforms the renderer sets itself on every draw. */
+		enum class Semantic {
+			Projection,
+			ModelView,
+			NormalMat,
+			LightPos,
+			LightColor,
+			LightPower,
+			LightAmbi,
+			LightSpec,
+			Mode,
+			/** First indirect command of a multi draw, added to gl_DrawID. */
+			DrawBase,
+
+			/** Not a renderer uniform, set through SetUniform(). */
+			None
+		};
+
+		/** Number of semantic uniforms. */
+		static const size_t SemanticCount = (size_t)Semantic::None;
+
+		/** An active uniform that isn't a semantic, found at link time. */
+		struct UniformBinding {
+			/** The uniform type. */
+			UniformType type = None;
+			/** The GLSL name. */
+			std::string name;
+			/** The uniform location in the program. */
+			int location = -1;
+			/** Index of the value in uniformFloats or uniformInts. */
+			size_t offset = 0;
+		};
+
 		bool loaded = false;
 
-		/** The type, uniform name, resource pointer, uniform handle, and . */
-		std::vector<std::tuple<UniformType, std::string, std::shared_ptr<void>, int, std::string>> uniforms;
+		/** Location of each semantic uniform, -1 if the program doesn't use it. */
+		int semanticLocations[SemanticCount];
+
+		/** Other active uniforms, filled by GG::ResourceHandler::UploadShaderResource. */
+		std::vector<UniformBinding> uniforms;
+
+		/** Values of float, vector and matrix uniforms, packed back to back. */
+		std::vector<float> uniformFloats;
+		/** Values of int uniforms, samplers keep their texture unit here. */
+		std::vector<int> uniformInts;
 
 		// The data to be destroyed later on.
 		std::string data;
 
-		// The shader in question, used as glProgram key.
+		// The shader in question.
 		std::string filename;
 
+		/** The linked program, set by GG::ResourceHandler::UploadShaderResource. */
+		ShaderHandle program;
+
 		// Index, Shader.
 		std::vector<std::pair<size_t, std::string>> shaders;
 
+		/** Macros defined in every stage when compiling, after #version. */
+		std::vector<std::string> defines;
+
+		/**
+		 * Variant compiled with INSTANCED defined, reading per object data
+		 * from the instance buffer. Made on upload if the source mentions
+		 * INSTANCED, otherwise null.
+		 */
+		std::shared_ptr<ShaderResource> instanced;
+
+		ShaderResource() {
+			ClearUniforms();
+		}
+
+		/** Returns stage i with the defines inserted after its #version line. */
+		std::string GetSource(size_t i) const {
+			std::string source = shaders[i].second;
+			if (defines.empty())
+				return source;
+
+			std::string lines;
+			for (size_t d = 0; d < defines.size(); d++)
+				lines += "#define " + defines[d] + "\n";
+
+			// #version has to stay the first directive.
+			size_t pos = source.find("#version");
+			pos = (pos == std::string::npos) ? 0 : source.find('\n', pos);
+			if (pos == std::string::npos) {
+				source += "\n";
+				pos = source.size() - 1;
+			}
+			source.insert(pos + 1, lines);
+			return source;
+		}
+
+		/** Maps a GLSL uniform name to the semantic the renderer fills in. */
+		static Semantic SemanticFromName(const std::string& name) {
+			static const char* names[SemanticCount] = {
+				"projection",
+				"modelView",
+				"normalMat",
+				"light.Pos",
+				"light.Color",
+				"light.Power",
+				"light.Ambi",
+				"light.Spec",
+				"mode",
+				"drawBase"
+			};
+
+			for (size_t i = 0; i < SemanticCount; i++) {
+				if (name == names[i])
+					return (Semantic)i;
+			}
+			return Semantic::None;
+		}
+
+		/** Number of floats or ints a uniform type stores. */
+		static size_t UniformSize(UniformType type) {
+			switch (type) {
+			case Mat4:
+				return 16;
+			case Vec4:
+			case Vec3:
+			case Vec2:
+				return 4;
+			case Float:
+			case Int:
+			case Sam2:
+				return 1;
+			default:
+				return 0;
+			}
+		}
+
+		/** Whether a uniform type stores its value in uniformInts. */
+		static bool IsIntUniform(UniformType type) {
+			return type == Int || type == Sam2;
+		}
+
+		/** Forgets the uniform table, called before reflecting a new program. */
+		void ClearUniforms() {
+			for (size_t i = 0; i < SemanticCount; i++)
+				semanticLocations[i] = -1;
+
+			uniforms.clear();
+			uniformFloats.clear();
+			uniformInts.clear();
+		}
+
+		/** Adds a uniform found in the linked program. */
+		void AddUniform(UniformType type, const std::string& name, int location) {
+			Semantic semantic = SemanticFromName(name);
+			if (semantic != Semantic::None) {
+				semanticLocations[(size_t)semantic] = location;
+				return;
+			}
+
+			UniformBinding binding;
+			binding.type = type;
+			binding.name = name;
+			binding.location = location;
+
+			if (IsIntUniform(type)) {
+				binding.offset = uniformInts.size();
+				uniformInts.resize(uniformInts.size() + UniformSize(type), 0);
+			}
+			else {
+				binding.offset = uniformFloats.size();
+				uniformFloats.resize(uniformFloats.size() + UniformSize(type), 0.0f);
+			}
+
+			uniforms.push_back(binding);
+		}
+
 		/** Loads shader string. */
 		bool Load(const std::string& filename) {
 
@@ -137,28 +296,48 @@ namespace ResourceLib {
 			return loaded = true;
 		}
 
-		//std::tuple<UniformType, std::string, std::shared_ptr<void>, int, std::string> 
+		/** Returns the uniform with a GLSL name, or nullptr if not active. */
+		UniformBinding* FindUniform(const std::string& name) {
+			auto iter = std::find_if(uniforms.begin(), uniforms.end(), [&name](const UniformBinding& a) { return a.name == name; });
+			return iter != uniforms.end() ? &*iter : nullptr;
+		}
 
-		/** Get Mat4 uniform handle so editing can be done. */
-		std::shared_ptr<MathLib::Mat4> GetUniformMat4(std::string name) {
-			auto iter = std::find_if(this->uniforms.begin(), this->uniforms.end(), [name](std::tuple<UniformType, std::string, std::shared_ptr<void>, int, std::string> a) { return std::get<1>(a) == name; });
+		/**
+		 * Sets the stored value of a uniform, uploaded on every draw.
+		 *
+		 * @returns false if the program has no such uniform or its type differs.
+		 */
+		bool SetUniform(const std::string& name, const MathLib::Mat4& value) {
+			UniformBinding* u = FindUniform(name);
+			if (u == nullptr || u->type != Mat4)
+				return false;
+			std::copy(value.Data(), value.Data() + 16, &uniformFloats[u->offset]);
+			return true;
+		}
 
-			if (iter != this->uniforms.end())
-				// Pointer fuckery.
-				return *(std::shared_ptr<MathLib::Mat4>*)(&std::get<2>(*iter));
-			else
-				return nullptr;
+		/** Sets a vec2/vec3/vec4 uniform, unused components are ignored. */
+		bool SetUniform(const std::string& name, const MathLib::Vec4& value) {
+			UniformBinding* u = FindUniform(name);
+			if (u == nullptr || (u->type != Vec4 && u->type != Vec3 && u->type != Vec2))
+				return false;
+			std::copy(value.Data(), value.Data() + 4, &uniformFloats[u->offset]);
+			return true;
 		}
 
-		/** Get Vec4 uniform handle so editing can be done. */
-		std::shared_ptr<MathLib::Vec4> GetUniformVec4(std::string name) {
-			auto iter = std::find_if(this->uniforms.begin(), this->uniforms.end(), [name](std::tuple<UniformType, std::string, std::shared_ptr<void>, int, std::string> a) { return std::get<1>(a) == name; });
+		bool SetUniform(const std::string& name, float value) {
+			UniformBinding* u = FindUniform(name);
+			if (u == nullptr || u->type != Float)
+				return false;
+			uniformFloats[u->offset] = value;
+			return true;
+		}
 
-			if (iter != this->uniforms.end())
-				// Pointer fuckery.
-				return *(std::shared_ptr<MathLib::Vec4>*)(&std::get<2>(*iter));
-			else
-				return nullptr;
+		bool SetUniform(const std::string& name, int value) {
+			UniformBinding* u = FindUniform(name);
+			if (u == nullptr || u->type != Int)
+				return false;
+			uniformInts[u->offset] = value;
+			return true;
 		}
 
 		/** Unloads shader string from cpu. */
@@ -171,8 +350,7 @@ namespace ResourceLib {
 			shaders.clear();
 			shaders.shrink_to_fit();
 
-			uniforms.clear();
-			uniforms.shrink_to_fit();
+			// The uniform table belongs to the uploaded program and stays.
 		}
 
 	private:
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace ResourceLib {
+
+	/**
+	 * Generation checked handle into a SlotMap.
+	 *
+	 * The tag only exists to make handles of different resource kinds
+	 * distinct types, so a texture handle can't be passed as a buffer.
+	 */
+	template<typename Tag>
+	struct Handle {
+		/** Slot in the owning map. */
+		uint32_t index = UINT32_MAX;
+		/** Generation of the slot when the handle was made. */
+		uint32_t generation = 0;
+
+		/** Returns false for default constructed handles. */
+		bool IsSet() const {
+			return index != UINT32_MAX;
+		}
+
+		bool operator == (const Handle& other) const {
+			return index == other.index && generation == other.generation;
+		}
+		bool operator != (const Handle& other) const {
+			return !(*this == other);
+		}
+	};
+
+	// Handle kinds used by the rendering glue.
+	struct ShaderTag;
+	struct BufferTag;
+	struct TextureTag;
+
+	/** Handle to a linked shader program. */
+	typedef Handle<ShaderTag> ShaderHandle;
+	/** Handle to a vertex or index buffer. */
+	typedef Handle<BufferTag> BufferHandle;
+	/** Handle to a texture. */
+	typedef Handle<TextureTag> TextureHandle;
+
+	/**
+	 * Fixed slot storage addressed by generation checked handles.
+	 *
+	 * Lookups are a bounds check, an array index and a generation compare.
+	 * Removed slots bump their generation and are reused, so stale handles
+	 * resolve to nullptr instead of another object.
+	 */
+	template<typename T, typename Tag>
+	class SlotMap {
+	public:
+		/** Stores a value and returns its handle. */
+		Handle<Tag> Insert(const T& value) {
+			uint32_t index;
+			if (!freeSlots.empty()) {
+				index = freeSlots.back();
+				freeSlots.pop_back();
+			}
+			else {
+				index = (uint32_t)slots.size();
+				slots.push_back(Slot());
+			}
+
+			slots[index].value = value;
+			slots[index].alive = true;
+
+			Handle<Tag> handle;
+			handle.index = index;
+			handle.generation = slots[index].generation;
+			return handle;
+		}
+
+		/** Returns the value of a handle, or nullptr if it is stale. */
+		T* Get(Handle<Tag> handle) {
+			if (handle.index >= slots.size())
+				return nullptr;
+			Slot& slot = slots[handle.index];
+			return (slot.alive && slot.generation == handle.generation) ? &slot.value : nullptr;
+		}
+
+		/** Returns the value of a handle, or nullptr if it is stale. */
+		const T* Get(Handle<Tag> handle) const {
+			if (handle.index >= slots.size())
+				return nullptr;
+			const Slot& slot = slots[handle.index];
+			return (slot.alive && slot.generation == handle.generation) ? &slot.value : nullptr;
+		}
+
+		/**
+		 * Frees the slot of a handle.
+		 *
+		 * @returns false if the handle was already stale.
+		 */
+		bool Remove(Handle<Tag> handle) {
+			if (Get(handle) == nullptr)
+				return false;
+
+			Slot& slot = slots[handle.index];
+			slot.alive = false;
+			slot.generation++;
+			slot.value = T();
+			freeSlots.push_back(handle.index);
+			return true;
+		}
+
+		/** Calls f with every live value. */
+		template<typename F>
+		void ForEach(F f) {
+			for (size_t i = 0; i < slots.size(); i++) {
+				if (slots[i].alive)
+					f(slots[i].value);
+			}
+		}
+
+		/** Frees every slot, all outstanding handles become stale. */
+		void Clear() {
+			freeSlots.clear();
+			for (size_t i = 0; i < slots.size(); i++) {
+				if (slots[i].alive) {
+					slots[i].alive = false;
+					slots[i].generation++;
+					slots[i].value = T();
+				}
+				freeSlots.push_back((uint32_t)(slots.size() - 1 - i));
+			}
+		}
+
+	private:
+		struct Slot {
+			T value = T();
+			uint32_t generation = 0;
+			bool alive = false;
+		};
+
+		std::vector<Slot> slots;
+		std::vector<uint32_t> freeSlots;
+	};
+}
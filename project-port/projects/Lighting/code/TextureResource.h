@@ -1,5 +1,6 @@
 #pragma once
 #include "stb_image.h"
+#include "SlotMap.h"
 
 #include <string>
 
@@ -20,8 +21,8 @@ namespace ResourceLib {
 		/** The actual image data. */
 		unsigned char* buffer = nullptr;
 
-		/** The external index in a handle array. */
-		size_t bufferIndex = 0;
+		/** The GPU texture, set by GG::ResourceHandler::UploadTextureResource. */
+		TextureHandle texture;
 
 		/** The texture name. */
 		std::string filename;
@@ -0,0 +1,276 @@
+#include "VertexFormat.h"
+#include "HalfArray.h"
+#include "half.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace ResourceLib {
+
+	static float Clamp(float v, float low, float high) {
+		return v < low ? low : (v > high ? high : v);
+	}
+
+	static int16_t ToSnorm16(float v) {
+		return (int16_t)std::lround(Clamp(v, -1.0f, 1.0f) * 32767.0f);
+	}
+
+	static float FromSnorm16(int16_t v) {
+		// -32768 and -32767 both mean -1, as in GL.
+		float f = v / 32767.0f;
+		return f < -1.0f ? -1.0f : f;
+	}
+
+	static float Sign(float v) {
+		return v < 0.0f ? -1.0f : 1.0f;
+	}
+
+	// Vertices per bulk half conversion, small enough to stay in cache.
+	static const size_t HalfChunk = 256;
+
+	size_t VertexFormat::Size(Type type, size_t length) {
+		switch (type) {
+		case Type::Float:
+			return length * 4;
+		case Type::Half:
+		case Type::Snorm16:
+			return length * 2;
+		case Type::Unorm8:
+			return length;
+		case Type::Octahedral:
+		case Type::Snorm10:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	float VertexFormat::Precision(Type type) {
+		switch (type) {
+		case Type::Half:
+			// Half an ulp of an 11 bit significand.
+			return 1.0f / 2048.0f;
+		case Type::Snorm16:
+			return 0.5f / 32767.0f;
+		case Type::Unorm8:
+			return 0.5f / 255.0f;
+		case Type::Octahedral:
+			// Normalizing after the fold stretches the snorm16 grid, up to
+			// two steps off.
+			return 2.0f / 32767.0f;
+		case Type::Snorm10:
+			return 0.5f / 511.0f;
+		default:
+			return 0.0f;
+		}
+	}
+
+	void VertexFormat::Encode(Type type, size_t length, const float* values, size_t valueCount, uint8_t* destination) {
+		// Padded like GL pads a short attribute.
+		float v[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		size_t count = Components(type, length);
+		count = count < 4 ? count : 4;
+		for (size_t k = 0; k < count && k < valueCount; k++)
+			v[k] = values[k];
+
+		switch (type) {
+		case Type::Float:
+			memcpy(destination, v, count * sizeof(float));
+			break;
+		case Type::Half:
+			for (size_t k = 0; k < count; k++) {
+				half_float::half h = half_float::half_cast<half_float::half, std::round_to_nearest>(v[k]);
+				memcpy(destination + k * 2, &h, 2);
+			}
+			break;
+		case Type::Snorm16:
+			for (size_t k = 0; k < count; k++) {
+				int16_t s = ToSnorm16(v[k]);
+				memcpy(destination + k * 2, &s, 2);
+			}
+			break;
+		case Type::Unorm8:
+			for (size_t k = 0; k < count; k++)
+				destination[k] = (uint8_t)std::lround(Clamp(v[k], 0.0f, 1.0f) * 255.0f);
+			break;
+		case Type::Octahedral: {
+			// Project onto |x| + |y| + |z| = 1, fold the lower half over the upper.
+			float sum = std::fabs(v[0]) + std::fabs(v[1]) + std::fabs(v[2]);
+			float x = sum > 0.0f ? v[0] / sum : 0.0f;
+			float y = sum > 0.0f ? v[1] / sum : 0.0f;
+			if (v[2] < 0.0f) {
+				float fx = (1.0f - std::fabs(y)) * Sign(x);
+				float fy = (1.0f - std::fabs(x)) * Sign(y);
+				x = fx;
+				y = fy;
+			}
+			int16_t s[2] = { ToSnorm16(x), ToSnorm16(y) };
+			memcpy(destination, s, 4);
+			break;
+		}
+		case Type::Snorm10: {
+			uint32_t word = 0;
+			for (int k = 0; k < 3; k++)
+				word |= ((uint32_t)std::lround(Clamp(v[k], -1.0f, 1.0f) * 511.0f) & 0x3FF) << (k * 10);
+			word |= ((uint32_t)std::lround(Clamp(v[3], -1.0f, 1.0f)) & 0x3) << 30;
+			memcpy(destination, &word, 4);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	void VertexFormat::Decode(Type type, size_t length, const uint8_t* source, float* values) {
+		switch (type) {
+		case Type::Float:
+			memcpy(values, source, length * sizeof(float));
+			break;
+		case Type::Half:
+			for (size_t k = 0; k < length; k++) {
+				uint16_t h;
+				memcpy(&h, source + k * 2, 2);
+				values[k] = half_float::detail::half2float<float>(h);
+			}
+			break;
+		case Type::Snorm16:
+			for (size_t k = 0; k < length; k++) {
+				int16_t s;
+				memcpy(&s, source + k * 2, 2);
+				values[k] = FromSnorm16(s);
+			}
+			break;
+		case Type::Unorm8:
+			for (size_t k = 0; k < length; k++)
+				values[k] = source[k] / 255.0f;
+			break;
+		case Type::Octahedral: {
+			int16_t s[2];
+			memcpy(s, source, 4);
+			float x = FromSnorm16(s[0]), y = FromSnorm16(s[1]);
+			float z = 1.0f - std::fabs(x) - std::fabs(y);
+			if (z < 0.0f) {
+				float fx = (1.0f - std::fabs(y)) * Sign(x);
+				float fy = (1.0f - std::fabs(x)) * Sign(y);
+				x = fx;
+				y = fy;
+			}
+			float inverse = 1.0f / std::sqrt(x * x + y * y + z * z);
+			values[0] = x * inverse;
+			values[1] = y * inverse;
+			values[2] = z * inverse;
+			break;
+		}
+		case Type::Snorm10: {
+			uint32_t word;
+			memcpy(&word, source, 4);
+			for (int k = 0; k < 3; k++) {
+				// Sign extend the 10 bit field.
+				int32_t c = (int32_t)(word << (22 - k * 10)) >> 22;
+				float f = c / 511.0f;
+				values[k] = f < -1.0f ? -1.0f : f;
+			}
+			int32_t w = (int32_t)word >> 30;
+			values[3] = w < -1 ? -1.0f : (float)w;
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	float VertexFormat::EncodeArray(Type type, size_t length, const float* source, size_t sourceLength, size_t sourceStride,
+		size_t count, uint8_t* destination, size_t destinationStride) {
+		size_t components = Components(type, length);
+		if (components > 4 || Size(type, length) > 16)
+			return INFINITY;
+
+		float error = 0.0f;
+		if (type == Type::Half) {
+			// Gather the padded values a chunk at a time and convert them in bulk.
+			float values[HalfChunk * 4], decoded[HalfChunk * 4];
+			uint16_t halves[HalfChunk * 4];
+			for (size_t first = 0; first < count; first += HalfChunk) {
+				size_t chunk = count - first < HalfChunk ? count - first : HalfChunk;
+				for (size_t i = 0; i < chunk; i++) {
+					const float* v = source + (first + i) * sourceStride;
+					for (size_t k = 0; k < length; k++)
+						values[i * length + k] = k < sourceLength ? v[k] : (k == 3 ? 1.0f : 0.0f);
+				}
+				HalfArray::FromFloat(values, halves, chunk * length);
+				HalfArray::ToFloat(halves, decoded, chunk * length);
+
+				for (size_t i = 0; i < chunk * length; i++) {
+					// A half overflowing to infinity is infinitely off.
+					float e = std::fabs(decoded[i] - values[i]);
+					if (e > error)
+						error = e;
+				}
+				if (destination != nullptr) {
+					for (size_t i = 0; i < chunk; i++)
+						memcpy(destination + (first + i) * destinationStride, &halves[i * length], length * sizeof(uint16_t));
+				}
+			}
+			return error;
+		}
+
+		uint8_t encoded[16];
+		for (size_t i = 0; i < count; i++) {
+			const float* values = source + i * sourceStride;
+			uint8_t* target = destination != nullptr ? destination + i * destinationStride : encoded;
+			Encode(type, length, values, sourceLength, target);
+
+			float expected[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+			for (size_t k = 0; k < components && k < sourceLength; k++)
+				expected[k] = values[k];
+			if (type == Type::Octahedral) {
+				float lengthSq = expected[0] * expected[0] + expected[1] * expected[1] + expected[2] * expected[2];
+				// No direction to keep.
+				if (lengthSq == 0.0f)
+					continue;
+				float inverse = 1.0f / std::sqrt(lengthSq);
+				for (int k = 0; k < 3; k++)
+					expected[k] *= inverse;
+			}
+
+			float decoded[4];
+			Decode(type, length, target, decoded);
+			for (size_t k = 0; k < components; k++) {
+				// A half overflowing to infinity is infinitely off.
+				float e = std::fabs(decoded[k] - expected[k]);
+				if (e > error)
+					error = e;
+			}
+		}
+		return error;
+	}
+
+	void VertexFormat::DecodeArray(Type type, size_t length, const uint8_t* source, size_t sourceStride,
+		size_t count, float* destination, size_t destinationLength) {
+		size_t components = Components(type, length);
+		if (components > 4)
+			return;
+
+		float decoded[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		uint16_t halves[HalfChunk * 4];
+		float widened[HalfChunk * 4];
+		for (size_t i = 0; i < count; i++) {
+			if (type == Type::Half) {
+				// Gather the halves a chunk at a time and widen them in bulk.
+				size_t slot = i % HalfChunk;
+				if (slot == 0) {
+					size_t chunk = count - i < HalfChunk ? count - i : HalfChunk;
+					for (size_t c = 0; c < chunk; c++)
+						memcpy(&halves[c * length], source + (i + c) * sourceStride, length * sizeof(uint16_t));
+					HalfArray::ToFloat(halves, widened, chunk * length);
+				}
+				memcpy(decoded, &widened[slot * length], length * sizeof(float));
+			}
+			else
+				Decode(type, length, source + i * sourceStride, decoded);
+			float* values = destination + i * destinationLength;
+			for (size_t k = 0; k < destinationLength; k++)
+				values[k] = k < components ? decoded[k] : (k == 3 ? 1.0f : 0.0f);
+		}
+	}
+}
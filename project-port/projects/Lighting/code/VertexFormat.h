@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ResourceLib {
+
+	/**
+	 * Component types of vertex attributes and their conversion from and to
+	 * float, as GL reads them back with glVertexAttribPointer.
+	 *
+	 * A length counts stored components, what GL is told. Octahedral
+	 * stores 2 and decodes to a unit xyz, Snorm10 always stores 4 in one
+	 * 32 bit word. Values missing when encoding are padded like GL pads
+	 * attributes, with (0, 0, 0, 1). Arrays of halfs convert in bulk with
+	 * HalfArray.
+	 */
+	class VertexFormat {
+	public:
+		enum class Type : uint8_t {
+			/** 32 bit float. */
+			Float,
+			/** IEEE 16 bit float, about 3 significant digits. */
+			Half,
+			/** Signed 16 bit, [-1, 1] in steps of 1 / 32767. */
+			Snorm16,
+			/** Unsigned 8 bit, [0, 1] in steps of 1 / 255. */
+			Unorm8,
+			/** Unit vector folded onto an octahedron, 2 snorm16. */
+			Octahedral,
+			/** 10-10-10-2 signed, xyz in steps of 1 / 511, w of -1, 0 or 1. */
+			Snorm10,
+			Count
+		};
+
+		/** Bytes of an attribute of length components. */
+		static size_t Size(Type type, size_t length);
+
+		/** Floats Decode() writes for an attribute of length components. */
+		static size_t Components(Type type, size_t length) {
+			return type == Type::Octahedral ? 3 : length;
+		}
+
+		/**
+		 * Largest error of a decoded component for values in range, what
+		 * rounding alone costs. Half is relative to the magnitude.
+		 */
+		static float Precision(Type type);
+
+		/** Encodes valueCount floats, padded or cut to the attribute. */
+		static void Encode(Type type, size_t length, const float* values, size_t valueCount, uint8_t* destination);
+
+		/** Decodes an attribute into Components() floats. */
+		static void Decode(Type type, size_t length, const uint8_t* source, float* values);
+
+		/**
+		 * Encodes count interleaved values.
+		 *
+		 * @destination may be null to only measure the error.
+		 * @returns the largest difference of a decoded component from the
+		 * padded source. Octahedral compares against the normalized source.
+		 */
+		static float EncodeArray(Type type, size_t length, const float* source, size_t sourceLength, size_t sourceStride,
+			size_t count, uint8_t* destination, size_t destinationStride);
+
+		/**
+		 * Decodes count interleaved attributes, keeping the first
+		 * destinationLength components of each and padding missing ones.
+		 * Strides are in bytes for the source and floats for the destination.
+		 */
+		static void DecodeArray(Type type, size_t length, const uint8_t* source, size_t sourceStride,
+			size_t count, float* destination, size_t destinationLength);
+	};
+}
@@ -12,6 +12,8 @@
 #include "LightNode.h"
 
 #include "GraphicsGlue.h"
+#include "GLState.h"
+#include "RenderQueue.h"
 using namespace ResourceLib;
 
 
@@ -97,6 +99,17 @@ ExampleApp::Open()
 		if (key == GLFW_KEY_S) { Input::Keys.S = action; }
 		if (key == GLFW_KEY_D) { Input::Keys.D = action; }
 		if (key == GLFW_KEY_ESCAPE) { this->window->Close(); }
+		if (key == GLFW_KEY_F1 && action == GLFW_PRESS) {
+			const GG::GLState::Counters& c = GG::GLState::GetLastFrame();
+			printf("GL binds last frame: %u issued, %u elided\n", c.issued, c.elided);
+			const GG::RingBuffer& ring = GG::ResourceHandler::GetFrameData();
+			printf("Frame data: %zu of %zu bytes, waited %.3f ms on the GPU, %u stalled frames\n",
+				ring.GetFrameUsed(), ring.GetSegmentSize(), ring.GetLastStall(), ring.GetStallCount());
+			const GG::FrustumCuller::Stats& cull = culler.GetStats();
+			printf("Frustum culling: %u visible, %u culled\n", cull.visible, cull.culled);
+			const GG::OcclusionCuller::Stats& occ = occlusion.GetStats();
+			printf("Occlusion culling: %u occluders, %u triangles, %u of %u hidden\n", occ.occluders, occ.triangles, occ.occluded, occ.tested);
+		}
 	});
 
 	window->SetMousePressFunction([this](int32 key, int32 action, int32 mod){
@@ -192,6 +205,9 @@ ExampleApp::Run()
 {
 	// Float representing elapsed time.
 	float t = 0;
+
+	// Draws of the current frame, reused to keep its memory.
+	GG::RenderQueue queue;
 	float* tp = &t; // time pointer for lambda capture.
 
 	///////////////////////////
@@ -226,28 +242,34 @@ ExampleApp::Run()
 	///////////////////////////
 	std::shared_ptr<ResourceLib::GraphicsNode> gn(new GraphicsNode(mr, tr, sr));
 
-	gn->Update = [gn](){
+	// Euler angles driven by the mouse, the transform itself stores a quaternion.
+	MathLib::Vec4 gnEuler;
+	gn->SetUpdate([gn, gnEuler]() mutable {
 		if (Input::Keys.MouseLeft) {
 			if ((Input::Mouse.dx *Input::Mouse.dx + Input::Mouse.dy*Input::Mouse.dy) >= 2.0) {
-				gn->transform.rotation[2] += Input::Mouse.dx / 300.f;
-				gn->transform.rotation[0] += Input::Mouse.dy / 300.f;
+				gnEuler[2] += Input::Mouse.dx / 300.f;
+				gnEuler[0] += Input::Mouse.dy / 300.f;
+				gn->transform.SetEulerRotation(gnEuler);
 			}
 		}
 
-		if (Input::Keys.W) { gn->transform.location[2] -= 0.1f; }
-		if (Input::Keys.A) { gn->transform.location[0] -= 0.1f; }
-		if (Input::Keys.S) { gn->transform.location[2] += 0.1f; }
-		if (Input::Keys.D) { gn->transform.location[0] += 0.1f; }
-	};
+		if (Input::Keys.W) { gn->transform.Translate(0, 0, -0.1f); }
+		if (Input::Keys.A) { gn->transform.Translate(-0.1f, 0, 0); }
+		if (Input::Keys.S) { gn->transform.Translate(0, 0, 0.1f); }
+		if (Input::Keys.D) { gn->transform.Translate(0.1f, 0, 0); }
+	});
 
 	std::shared_ptr<ResourceLib::LightNode> ln(new LightNode(mr, tr, sr));
-	//ln->transform.scale = MathLib::Vec4(0.1,0.1,0.1);
-	ln->Update = [ln, tp]() {
+	//ln->transform.SetScale(MathLib::Vec4(0.1,0.1,0.1));
+	ln->SetUpdate([ln, tp]() {
 		// Update light position.
 		LightNode::position = MathLib::Vec4(sin(*tp)*4, 1, cos(*tp)*4);
 		// Also update mesh.
-		ln->transform.location = LightNode::position;
-	};
+		ln->transform.SetLocation(LightNode::position);
+	});
+
+	// Sets the scale for the object, once so it doesn't dirty every frame.
+	gn->transform.SetScale(MathLib::Vec4(1.5f, 1.5f, 1.5f));
 
 	////////////////
 	// MISC STUFF //
@@ -283,14 +305,6 @@ ExampleApp::Run()
 		this->window->GetSize(w, h);
 
 
-		////////////////////
-		// OBJECT UPDATES //
-		////////////////////
-
-		// Sets the scale for the object
-		gn->transform.scale = MathLib::Vec4(1.5f, 1.5f, 1.5f);
-
-
 		////////////////////
 		// CAMERA UPDATES //
 		////////////////////
@@ -312,6 +326,11 @@ ExampleApp::Run()
 			(float)w / (float)h
 		);
 		
+		// Anything may have touched GL since the last frame, e.g. the UI.
+		GG::GLState::BeginFrame();
+		// Waits here if the GPU is three frames behind.
+		GG::ResourceHandler::BeginFrame();
+
 		GG::ResourceHandler::SetCameraMatrices(view, projection);
 
 		////////////////////
@@ -327,41 +346,46 @@ ExampleApp::Run()
 		///////////////////////////
 		// UPDATE GRAPHICS NODES //
 		///////////////////////////
-		for (auto iter = ResourceLib::GraphicsNode::activeGraphicsNodes.begin();
-			iter != ResourceLib::GraphicsNode::activeGraphicsNodes.end();
-			iter++) {
+		ResourceLib::SceneStore& scene = ResourceLib::GraphicsNode::scene;
 
-			if (iter->second)
-				iter->first->Update();
+		for (size_t i = 0; i < scene.Size(); i++) {
+			if (scene.active[i] && scene.updates[i])
+				scene.updates[i]();
 		}
 
+		// Rebuild matrices of nodes that moved this frame.
+		ResourceLib::GraphicsNode::UpdateTransforms();
+
+		// Light parameters are final once the updates ran.
+		GG::ResourceHandler::UpdateLightBlock();
+
 		/////////////////////////
 		// DRAW GRAPHICS NODES //
 		/////////////////////////
-		for (auto iter = ResourceLib::GraphicsNode::activeGraphicsNodes.begin();
-			iter != ResourceLib::GraphicsNode::activeGraphicsNodes.end();
-			iter++) {
-
-			if (iter->second)
-				GG::ResourceHandler::DrawGraphicsNode(iter->first);
-		}
+		// Only what the camera can see, sorted by pass, program, texture,
+		// mesh and depth.
+		culler.Cull(scene, projection * view);
+		occlusion.Begin(projection * view);
+		occlusion.RenderOccluders(scene, culler.GetVisible());
+		occlusion.Filter(scene, culler.GetVisible());
+		queue.Clear();
+		queue.SetLodProjection(projection, h);
+		queue.SubmitScene(scene, view, occlusion.GetVisible());
+		queue.Sort();
+		queue.Draw();
 
-		
 		////////////////////////////////////////////////////////
 		// REMOVE STALE GRAPHICS NODES FROM UPDATE AND RENDER //
 		////////////////////////////////////////////////////////
-		for (auto iter = ResourceLib::GraphicsNode::activeGraphicsNodes.begin();
-			iter != ResourceLib::GraphicsNode::activeGraphicsNodes.end();
-			iter++) {
-
-			if (!iter->second)
-				ResourceLib::GraphicsNode::activeGraphicsNodes.erase(iter->first);
-		}
+		scene.RemoveInactive();
 
 		// Legacy render function
 		//GG::ResourceHandler::DrawMeshTextureMatrix(&*mr, &*tr, &*sr, &(VP*model));
 
 
+		// Fence this frame's uniform blocks and instances.
+		GG::ResourceHandler::EndFrame();
+
 		// Swap rendered buffer to screen.
 		this->window->SwapBuffers();
 	}
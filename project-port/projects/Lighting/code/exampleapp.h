@@ -8,6 +8,8 @@
 //------------------------------------------------------------------------------
 #include "core/app.h"
 #include "render/window.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
 namespace Example
 {
 class ExampleApp : public Core::App
@@ -30,5 +32,9 @@ private:
 	GLuint uniform;
 	GLuint triangle;
 	Display::Window* window;
+	/// drops nodes outside the view before they are queued
+	GG::FrustumCuller culler;
+	/// drops nodes hidden behind occluders
+	GG::OcclusionCuller occlusion;
 };
 } // namespace Example
\ No newline at end of file
@@ -39,10 +39,16 @@
 //#include "matlib.h"
 #include "MeshResource.h"
 #include "exampleapp.h"
+#include "Benchmark.h"
 
 #include <iostream>
 
-int main() {
+int main(int argc, char** argv) {
+
+	// Headless benchmarks exit before a window is opened.
+	int benchmark = Benchmark::Run(argc, argv);
+	if (benchmark >= 0)
+		return benchmark;
 
 	Example::ExampleApp app;
 	if (app.Open())
@@ -7,17 +7,16 @@ layout(location=2) in vec2 uv;
 // Shader lifted from https://en.wikipedia.org/wiki/Blinn%E2%80%93Phong_reflection_model
 
 layout(location=10) uniform sampler2D diffuseTexture;
-struct Light
-{
+// Shared per frame, see GG::ResourceHandler::LightBlock.
+layout(std140, binding=2) uniform LightBlock {
     vec3 Pos;
-    vec3 Color;
     float Power;
+    vec3 Color;
+    int Mode;
     vec3 Ambi;
     vec3 Spec;
-};
+} light;
 //layout(location=11) uniform int lightNumber;
-layout(location=12) uniform int mode;
-layout(location=13) uniform Light light;
 
 // Should normally be uniform per object.
 const float shininess = 32.0;
@@ -54,7 +53,7 @@ void main()
         specular = pow(specAngle, shininess);
 
         // phong only?
-        if (mode == 2) {
+        if (light.Mode == 2) {
             vec3 reflectDir = reflect(-lightDir, normal);
             specAngle = max(dot(reflectDir, viewDir), 0.0);
             specular = pow(specAngle, shininess/4.0);
@@ -1,14 +1,56 @@
 #type vertex
 
 #version 430
+// Extensions have to come before any declaration.
+#ifdef INSTANCED
+#extension GL_ARB_shader_draw_parameters : enable
+#ifdef GL_ARB_shader_draw_parameters
+#define DRAW_ID gl_DrawIDARB
+#else
+#define DRAW_ID 0
+#endif
+#endif
+
 layout(location=0) in vec3 pos;
 layout(location=2) in vec2 uv;
 layout(location=3) in vec3 normal;
 
-// uniform location 0 global for program.
-layout(location=0) uniform mat4 projection;
-layout(location=1) uniform mat4 modelView;
-layout(location=2) uniform mat4 normalMat;
+// Shared per frame, matrices are uploaded row major.
+layout(std140, row_major, binding=1) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+} camera;
+
+#ifdef INSTANCED
+// One element per instance, see GG::ResourceHandler::UploadDraws.
+struct Object {
+    mat4 model;
+    mat4 normalMat;
+};
+layout(std430, row_major, binding=0) readonly buffer InstanceBlock {
+    Object instances[];
+};
+
+// The indirect commands, baseInstance locates each draw's instances.
+struct Command {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+layout(std430, binding=1) readonly buffer DrawBlock {
+    Command draws[];
+};
+uniform int drawBase;
+#define object instances[draws[drawBase + DRAW_ID].baseInstance + gl_InstanceID]
+#else
+// Written per draw.
+layout(std140, row_major, binding=3) uniform ObjectBlock {
+    mat4 model;
+    mat4 normalMat;
+} object;
+#endif
 
 layout(location=0) out vec3 NormalInterp;
 layout(location=1) out vec3 Pos;
@@ -16,13 +58,14 @@ layout(location=2) out vec2 UV;
 
 void main()
 {
-	gl_Position = projection * modelView * vec4(pos, 1);
+	mat4 modelView = camera.view * object.model;
+	gl_Position = camera.projection * modelView * vec4(pos, 1);
     vec4 vertPos4 = modelView * vec4(pos, 1.0);
     Pos = vec3(vertPos4) / vertPos4.w;
 	UV = uv;
     //normalMat = transpose(inverse(model)) * normal 
 	//NormalInterp = vec3(normalMat * vec4(normal, 0.0));
-    NormalInterp = mat3(normalMat) * normal;
+    NormalInterp = mat3(object.normalMat) * normal;
 }
 #type fragment
 
@@ -35,17 +78,16 @@ layout(location=2) in vec2 uv;
 // Shader lifted from https://en.wikipedia.org/wiki/Blinn%E2%80%93Phong_reflection_model
 
 layout(location=10) uniform sampler2D diffuseTexture;
-struct Light
-{
+// Shared per frame, see GG::ResourceHandler::LightBlock.
+layout(std140, binding=2) uniform LightBlock {
     vec3 Pos;
-    vec3 Color;
     float Power;
+    vec3 Color;
+    int Mode;
     vec3 Ambi;
     vec3 Spec;
-};
+} light;
 //layout(location=11) uniform int lightNumber;
-layout(location=12) uniform int mode;
-layout(location=13) uniform Light light;
 
 // Should normally be uniform per object.
 const float shininess = 16.0;
@@ -82,7 +124,7 @@ void main()
         specular = pow(specAngle, shininess);
 
         // phong only?
-        /*if (mode == 2) {
+        /*if (light.Mode == 2) {
             vec3 reflectDir = reflect(-lightDir, normal);
             specAngle = max(dot(reflectDir, viewDir), 0.0);
             specular = pow(specAngle, shininess/4.0);